@@ -6,6 +6,17 @@
 
 #pragma link C++ class ApexVDCWire+; 
 #pragma link C++ struct ApexVDCHit+; 
+#pragma link C++ struct ApexVDCHitGroup+; 
+#pragma link C++ struct ApexVDCPlaneCalib+; 
+#pragma link C++ struct ApexVDCPlaneStats+; 
+#pragma link C++ struct ApexVDCPlaneEvent+; 
 #pragma link C++ class ApexVDCPlane+; 
+#pragma link C++ class ApexVDC+; 
+#pragma link C++ struct ApexVDCCluster+; 
+#pragma link C++ struct ApexVDCClusterPair+; 
+#pragma link C++ class ApexVDCTreeReplay; 
+#pragma link C++ class ApexVDCTTDConv+; 
+#pragma link C++ class ApexVDCHotWireFinder+; 
+#pragma link C++ class ApexVDCT0Calib; 
 
 #endif
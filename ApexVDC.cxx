@@ -0,0 +1,219 @@
+#include "ApexVDC.h"
+#include <Database.h>
+#include <THaTrack.h>
+#include <TClonesArray.h>
+#include <vector>
+#include <cmath>
+
+using namespace std;
+
+//______________________________________________________________________________________________________
+ApexVDC::ApexVDC(const char* name, const char* description, THaApparatus* apparatus)
+    : THaTrackingDetector(name, description, apparatus)
+{
+    fPlanes[kU1] = new ApexVDCPlane("u1", "U1 plane", this);
+    fPlanes[kV1] = new ApexVDCPlane("v1", "V1 plane", this);
+    fPlanes[kU2] = new ApexVDCPlane("u2", "U2 plane", this);
+    fPlanes[kV2] = new ApexVDCPlane("v2", "V2 plane", this);
+}
+
+//______________________________________________________________________________________________________
+ApexVDC::~ApexVDC()
+{
+    RemoveVariables();
+
+    for (int i=0; i<kNPlanes; i++) delete fPlanes[i];
+}
+
+//______________________________________________________________________________________________________
+THaAnalysisObject::EStatus ApexVDC::Init(const TDatime& date)
+{
+    //init this detector first (so that the planes can find our prefix), then each plane
+    EStatus status;
+    if ((status = THaTrackingDetector::Init(date)) != kOK) return fStatus = status;
+
+    for (int i=0; i<kNPlanes; i++) {
+        if ((status = fPlanes[i]->Init(date)) != kOK) return fStatus = status;
+
+        //tracking uses the fitted groups of every plane in every event
+        fPlanes[i]->RegisterConsumer(GetName(), ApexVDCPlaneEvent::kStageFit);
+    }
+
+    return fStatus = kOK;
+}
+
+//______________________________________________________________________________________________________
+int ApexVDC::ReadDatabase(const TDatime& date)
+{
+    // Load the matching windows from the database
+    FILE* file = OpenFile(date);
+    if( !file ) return kFileError;
+
+    DBRequest request[] = {
+        { "match.poswin",   &fPosWindow,    kDouble,  0, true, -1 },
+        { "match.slopewin", &fSlopeWindow,  kDouble,  0, true, -1 },
+        { "match.xywin",    &fXYWindow,     kDouble,  0, true, -1 },
+        { nullptr }
+    };
+
+    int err = LoadDB(file, date, request, fPrefix);
+    fclose(file);
+
+    return err != 0 ? kInitError : kOK;
+}
+
+//______________________________________________________________________________________________________
+int ApexVDC::DefineVariables(EMode mode)
+{
+    //define the candidate accounting variables
+    VarDef vars[] = {
+        {"ncand",   "Candidates examined while matching clusters",              kInt,    0, &fNCandidates},
+        {"ncomb",   "Combinations a naive U1*V1*U2*V2 search would examine",    kDouble, 0, &fNCombinations},
+        {"noutside","U/V pair combinations whose track misses a chamber",       kInt,    0, &fNOutside},
+        {"ntracks", "Number of tracks made",                                    kInt,    0, &fNTracks},
+        {nullptr}
+    };
+
+    return DefineVarsFromList(vars, mode);
+}
+
+//______________________________________________________________________________________________________
+void ApexVDC::Clear(Option_t* opt)
+{
+    //reset all per-event data. the planes are cleared when they decode.
+    THaTrackingDetector::Clear(opt);
+
+    for (int i=0; i<kNPlanes; i++) fTables[i].clear();
+    fUPairs.clear();
+    fVPairs.clear();
+    fTrackPairs.clear();
+
+    fNCandidates   = 0;
+    fNCombinations = 0.;
+    fNOutside      = 0;
+    fNTracks       = 0;
+}
+
+//______________________________________________________________________________________________________
+int ApexVDC::Begin(THaRunBase* run)
+{
+    //reset the candidate counters for this run
+    fSumCandidates   = 0.;
+    fSumCombinations = 0.;
+    fNEventsTracked  = 0;
+
+    for (int i=0; i<kNPlanes; i++) fPlanes[i]->Begin(run);
+
+    return THaTrackingDetector::Begin(run);
+}
+
+//______________________________________________________________________________________________________
+int ApexVDC::End(THaRunBase* run)
+{
+    //report how many candidates were examined, compared to a naive search
+    const char* const here = "End";
+
+    const double n = fNEventsTracked > 0 ? (double)fNEventsTracked : 1.;
+
+    Info(Here(here), "%u events tracked. candidates examined/event = %.2f (naive search: %.2f)",
+                     fNEventsTracked, fSumCandidates/n, fSumCombinations/n);
+
+    for (int i=0; i<kNPlanes; i++) fPlanes[i]->End(run);
+
+    return THaTrackingDetector::End(run);
+}
+
+//______________________________________________________________________________________________________
+int ApexVDC::Decode(const THaEvData& evdata)
+{
+    Clear();
+
+    for (int i=0; i<kNPlanes; i++) fPlanes[i]->Decode(evdata);
+
+    return 0;
+}
+
+//______________________________________________________________________________________________________
+int ApexVDC::CoarseTrack(TClonesArray& tracks)
+{
+    //the geometry of each plane. 'offset' is the position of the plane's center along its coordinate
+    // (u or v), so that cluster positions are all in detector coordinates.
+    double z[kNPlanes];
+    for (int i=0; i<kNPlanes; i++) {
+
+        const ApexVDCPlaneCalib& calib = fPlanes[i]->GetCalib();
+
+        z[i] = calib.center[2];
+
+        const double offset = calib.center[0]*cos(calib.wire_angle) + calib.center[1]*sin(calib.wire_angle);
+
+        ApexVDCClusterMatch::MakeTable(fPlanes[i]->GetEvent(), offset, fTables[i]);
+    }
+
+    fNCombinations = (double)fTables[kU1].size() * fTables[kV1].size() * fTables[kU2].size() * fTables[kV2].size();
+
+    //match U1 to U2, and V1 to V2
+    fNCandidates  = ApexVDCClusterMatch::MatchPlanes(fTables[kU1], fTables[kU2], z[kU2] - z[kU1],
+                                                     fPosWindow, fSlopeWindow, fUPairs);
+    fNCandidates += ApexVDCClusterMatch::MatchPlanes(fTables[kV1], fTables[kV2], z[kV2] - z[kV1],
+                                                     fPosWindow, fSlopeWindow, fVPairs);
+
+    //match U pairs to V pairs whose track crosses both chambers (U1 for the lower chamber, U2 for the 
+    // upper one) inside of its active area, plus a margin of 'fXYWindow'. (a plane without a size in the 
+    // DB does not cut.) 
+    const double u_angle = fPlanes[kU1]->GetCalib().wire_angle;
+    const double v_angle = fPlanes[kV1]->GetCalib().wire_angle;
+
+    ApexVDCUVGeometry geom;
+    geom.u_angle = u_angle;
+    geom.v_angle = v_angle;
+    geom.z_u     = z[kU1];
+    geom.z_v     = z[kV1];
+    geom.margin  = fXYWindow;
+
+    const int chamber_plane[2] = { kU1, kU2 };
+    for (int c=0; c<2; c++) {
+        const ApexVDCPlaneCalib& calib = fPlanes[chamber_plane[c]]->GetCalib();
+        geom.area[c] = { z[chamber_plane[c]], calib.center[0], calib.center[1], calib.length, calib.width };
+    }
+
+    fNCandidates += ApexVDCClusterMatch::MatchUV(fUPairs, fVPairs, geom, fVIndex, fTrackPairs);
+
+    fNOutside = (int)(fUPairs.size()*fVPairs.size() - fTrackPairs.size());
+
+    //convert from UV to detector coordinates (as in Podd's THaVDC)
+    const double sin_u = sin(u_angle), cos_u = cos(u_angle);
+    const double sin_v = sin(v_angle), cos_v = cos(v_angle);
+    const double sin_vu = sin(v_angle - u_angle);
+
+    for (const auto& pair : fTrackPairs) {
+
+        const ApexVDCClusterPair& up = fUPairs[pair.u];
+        const ApexVDCClusterPair& vp = fVPairs[pair.v];
+
+        //project the lower UV point to z=0
+        const double u = up.pos - up.slope*z[kU1];
+        const double v = vp.pos - vp.slope*z[kV1];
+
+        const double x     = (u*sin_v - v*sin_u) / sin_vu;
+        const double y     = (v*cos_u - u*cos_v) / sin_vu;
+        const double theta = (up.slope*sin_v - vp.slope*sin_u) / sin_vu;
+        const double phi   = (vp.slope*cos_u - up.slope*cos_v) / sin_vu;
+
+        AddTrack(tracks, x, y, theta, phi);
+        fNTracks++;
+    }
+
+    fSumCandidates   += fNCandidates;
+    fSumCombinations += fNCombinations;
+    fNEventsTracked++;
+
+    return fNTracks;
+}
+
+//______________________________________________________________________________________________________
+int ApexVDC::FineTrack(TClonesArray& /*tracks*/)
+{
+    return 0;
+}
+//______________________________________________________________________________________________________
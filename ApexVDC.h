@@ -0,0 +1,114 @@
+#ifndef ApexVDC_H
+#define ApexVDC_H
+////////////////////////////////////////////////////////////////////////////////////////
+//
+//  class: ApexVDC
+//
+//  The VDC tracking detector: owns the 4 planes (U1, V1, U2, V2), and makes tracks out of
+//  their fitted groups ('clusters'). This is built the same way as Podd's THaVDC.
+//
+//  U1 clusters are matched to U2 clusters, and V1 clusters to V2 clusters, with a binary
+//  search in a sorted cluster table (see ApexVDCClusterMatch.h), instead of looping over
+//  all U1*V1*U2*V2 combinations. A U pair & a V pair then make a track if the track they
+//  make crosses both chambers inside their active area (length x width, plus a margin):
+//  a U pair & a V pair of different tracks almost never do, so that the number of tracks
+//  does not grow as (U pairs)*(V pairs). The V pairs are sorted by where they cross the U1
+//  plane, so that only those in the lower chamber's window of each U pair are examined.
+//
+//  The number of candidates examined in each event is kept ('ncand'), along with the
+//  number of combinations the naive search would have looked at ('ncomb').
+//
+//  - Seth H 28 Sep 25
+////////////////////////////////////////////////////////////////////////////////////////
+
+#include <THaTrackingDetector.h>
+#include <TDatime.h>
+#include "ApexVDCPlane.h"
+#include "ApexVDCClusterMatch.h"
+#include <vector>
+
+class THaEvData;
+class THaRunBase;
+class THaApparatus;
+class TClonesArray;
+
+class ApexVDC : public THaTrackingDetector {
+
+public:
+    enum EPlane { kU1 = 0, kV1, kU2, kV2, kNPlanes };
+
+private:
+
+    ApexVDCPlane* fPlanes[kNPlanes];    //the 4 planes, in the order above
+
+    //matching windows (from the DB). see ApexVDCClusterMatch.h
+    double fPosWindow   = 5.e-3;    //[m]
+    double fSlopeWindow = 0.2;
+    double fXYWindow    = 2.e-2;    //margin around the active area of each chamber [m]
+
+    //cluster tables of each plane, and U & V pairs, for the current event. these are kept between
+    // events so that they don't allocate.
+    std::vector<ApexVDCCluster>     fTables[kNPlanes];
+    std::vector<ApexVDCClusterPair> fUPairs;
+    std::vector<ApexVDCClusterPair> fVPairs;
+    std::vector<ApexVDCVIndex>      fVIndex;        //V pairs sorted by their v in the U1 plane
+    std::vector<ApexVDCTrackPair>   fTrackPairs;    //U & V pairs which make a track
+
+    //candidate accounting, for the current event
+    int    fNCandidates  = 0;   //candidates examined (upper clusters in a window, and V pairs in a U pair's window)
+    double fNCombinations= 0.;  //combinations a naive U1*V1*U2*V2 search would have examined
+    int    fNOutside     = 0;   //U/V pair combinations dropped since their track misses a chamber
+    int    fNTracks      = 0;   //tracks made
+
+    //... and summed over the run
+    double fSumCandidates  = 0.;
+    double fSumCombinations= 0.;
+    UInt_t fNEventsTracked = 0;
+
+public:
+    explicit ApexVDC(   const char* name="",
+                        const char* description="",
+                        THaApparatus* apparatus=nullptr );
+
+    ~ApexVDC();
+
+    //init the tracking detector & all 4 planes
+    EStatus Init(const TDatime& date);
+
+    //reset the candidate counters at the start of a run
+    int Begin(THaRunBase* run=nullptr);
+
+    //print the candidate counters of this run
+    int End(THaRunBase* run=nullptr);
+
+    //reset all per-event data
+    void Clear(Option_t* opt="");
+
+    //decode all 4 planes
+    int Decode(const THaEvData& data);
+
+    //match clusters between planes & make tracks
+    int CoarseTrack(TClonesArray& tracks);
+
+    //no fine tracking (yet): the coarse tracks are final
+    int FineTrack(TClonesArray& tracks);
+
+    ApexVDCPlane* GetPlane(EPlane plane) const { return fPlanes[plane]; }
+
+    //candidate accounting for the last event
+    int    GetNCandidates()  const { return fNCandidates; }
+    double GetNCombinations()const { return fNCombinations; }
+    int    GetNOutside()     const { return fNOutside; }
+    int    GetNTracks()      const { return fNTracks; }
+
+protected:
+    //read the matching windows from the DB
+    int ReadDatabase(const TDatime& date);
+
+    //define variables which this detector can provide
+    int DefineVariables(EMode mode = kDefine);
+
+    ClassDef(ApexVDC,0);
+};
+
+#endif
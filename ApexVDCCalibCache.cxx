@@ -0,0 +1,381 @@
+#include "ApexVDCCalibCache.h"
+#include <cstring>
+#include <cstddef>
+#include <algorithm>
+#include <cstdlib>
+#include <cstdio>
+#include <mutex>
+#include <type_traits>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using namespace std;
+
+namespace {
+
+    static_assert(is_trivially_copyable<ApexVDCPlaneDB::Scalars>::value,
+                  "ApexVDCPlaneDB::Scalars is written to the cache as raw bytes");
+
+    const char kMagic[8] = { 'A','P','E','X','V','D','C','C' };
+
+    struct Header {
+        char     magic[8];
+        uint32_t version;
+        uint32_t scalars_size;
+        uint64_t hash;
+        int64_t  validity;
+        uint64_t total_size;
+    };
+
+    //every block in the file starts on an 8-byte boundary
+    inline size_t Pad8(size_t n) { return (n + 7) & ~size_t(7); }
+
+    mutex  gDirLock;
+    string gDir;
+    bool   gDirSet = false;
+
+    //hash & validity timestamps of each DB file seen by MakeKey() so far, so that a file which has not 
+    // changed (same file, size & modification time) is only read & hashed once, however many planes (or 
+    // Init()s) use it 
+    struct FileKeys {
+        dev_t     dev;
+        ino_t     ino;
+        off_t     size;
+        timespec  mtime;
+        uint64_t  hash;
+        vector<long long> stamps;   //all validity timestamps in the file, sorted
+    };
+
+    mutex            gKeysLock;
+    vector<FileKeys> gKeys;
+
+    //call f(stamp) for each '[ yyyy-mm-dd hh:mm:ss ]' line (the time is optional) in 'data', with the 
+    // timestamp as yyyymmddhhmmss 
+    template<typename F> void ForEachStamp(const char* data, size_t n, F&& f)
+    {
+        const char* line = data;
+        const char* end  = data + n;
+
+        while (line < end) {
+
+            const char* eol = (const char*)memchr(line, '\n', end - line);
+            if (!eol) eol = end;
+
+            //timestamp lines look like '[ 2019-02-14 00:00:00 ]' (maybe with some '-' in front)
+            const char* open = (const char*)memchr(line, '[', eol - line);
+
+            if (open) {
+                char buf[64] = {0};
+                memcpy(buf, open+1, min<size_t>(eol - open - 1, sizeof(buf)-1));
+
+                int y = 0, mo = 0, d = 0, h = 0, mi = 0, sec = 0;
+                const int nread = sscanf(buf, " %d-%d-%d %d:%d:%d", &y, &mo, &d, &h, &mi, &sec);
+
+                if (nread >= 3 && strchr(buf, ']'))
+                    f( ((y*100LL + mo)*100LL + d)*1000000LL + (h*100LL + mi)*100LL + sec );
+            }
+            line = eol + 1;
+        }
+    }
+
+    //the latest of the (sorted) 'stamps' which is not after 'run_stamp' (0 if there is none)
+    long long LatestStamp(const vector<long long>& stamps, long long run_stamp)
+    {
+        auto it = upper_bound(stamps.begin(), stamps.end(), run_stamp);
+        return it == stamps.begin() ? 0 : *(it - 1);
+    }
+
+    //__________________________________________________________________________________________________
+    //appends blocks to an in-memory image of a cache file
+    struct Writer {
+        vector<char> buf;
+
+        void Put(const void* data, size_t n) {
+            const size_t at = buf.size();
+            buf.resize(at + Pad8(n), 0);
+            if (n > 0) memcpy(buf.data() + at, data, n);
+        }
+        template<typename T> void PutArray(const T* data, uint64_t n) {
+            Put(&n, sizeof(n));
+            Put(data, n*sizeof(T));
+        }
+
+        //the scalars, with all padding bytes zero, so that the same DB always gives the same file. the
+        // members are copied one at a time, since copying a whole struct may copy its padding, too.
+        void PutScalars(const ApexVDCPlaneDB::Scalars& s) {
+            using Scalars = ApexVDCPlaneDB::Scalars;
+
+            unsigned char bytes[sizeof(Scalars)];
+            memset(bytes, 0, sizeof(bytes));
+
+#define APEXVDC_PUT_MEMBER(m) memcpy(bytes + offsetof(Scalars, m), &s.m, sizeof(s.m))
+            APEXVDC_PUT_MEMBER(center);
+            APEXVDC_PUT_MEMBER(length);
+            APEXVDC_PUT_MEMBER(width);
+            APEXVDC_PUT_MEMBER(nwires);
+            APEXVDC_PUT_MEMBER(first_wire_pos);
+            APEXVDC_PUT_MEMBER(wire_spacing);
+            APEXVDC_PUT_MEMBER(wire_angle);
+            APEXVDC_PUT_MEMBER(tdc_resolution);
+            APEXVDC_PUT_MEMBER(tdc_rawtime_min);
+            APEXVDC_PUT_MEMBER(tdc_rawtime_max);
+            APEXVDC_PUT_MEMBER(group_hits_min);
+            APEXVDC_PUT_MEMBER(group_span_min);
+            APEXVDC_PUT_MEMBER(group_span_max);
+            APEXVDC_PUT_MEMBER(group_max_gap);
+            APEXVDC_PUT_MEMBER(fit_sigma);
+            APEXVDC_PUT_MEMBER(ttd_params.drift_vel);
+            APEXVDC_PUT_MEMBER(ttd_params.t_near);
+            APEXVDC_PUT_MEMBER(ttd_params.c_near);
+            APEXVDC_PUT_MEMBER(ttd_params.dmax);
+            APEXVDC_PUT_MEMBER(ttd_tmin);
+            APEXVDC_PUT_MEMBER(ttd_tmax);
+            APEXVDC_PUT_MEMBER(ttd_nbins);
+            APEXVDC_PUT_MEMBER(ttd_ngroups);
+            APEXVDC_PUT_MEMBER(reftime_chan);
+            APEXVDC_PUT_MEMBER(reftime_offset);
+            APEXVDC_PUT_MEMBER(reftime_min);
+            APEXVDC_PUT_MEMBER(reftime_max);
+            APEXVDC_PUT_MEMBER(hot_enable);
+            APEXVDC_PUT_MEMBER(hot_config.window);
+            APEXVDC_PUT_MEMBER(hot_config.nblocks);
+            APEXVDC_PUT_MEMBER(hot_config.factor);
+            APEXVDC_PUT_MEMBER(hot_config.min_hits);
+            APEXVDC_PUT_MEMBER(hot_config.nneighbors);
+            APEXVDC_PUT_MEMBER(t0_enable);
+            APEXVDC_PUT_MEMBER(t0_config.raw_min);
+            APEXVDC_PUT_MEMBER(t0_config.raw_max);
+            APEXVDC_PUT_MEMBER(t0_config.bin_shift);
+            APEXVDC_PUT_MEMBER(t0_config.min_entries);
+            APEXVDC_PUT_MEMBER(t0_config.nsmooth);
+            APEXVDC_PUT_MEMBER(t0_config.nbackground);
+            APEXVDC_PUT_MEMBER(t0_config.nplateau);
+            APEXVDC_PUT_MEMBER(t0_config.max_width);
+            APEXVDC_PUT_MEMBER(last_stage);
+            APEXVDC_PUT_MEMBER(use_std_sort);
+            APEXVDC_PUT_MEMBER(use_iterator);
+            APEXVDC_PUT_MEMBER(hits_reserve);
+            APEXVDC_PUT_MEMBER(groups_reserve);
+#undef APEXVDC_PUT_MEMBER
+
+            Put(bytes, sizeof(bytes));
+        }
+    };
+
+    //__________________________________________________________________________________________________
+    //reads blocks from a (mapped) cache file, checking that nothing runs past its end
+    struct Reader {
+        const char* pos;
+        const char* end;
+
+        bool Get(void* data, size_t n) {
+            if ((size_t)(end - pos) < Pad8(n)) return false;
+            if (n > 0) memcpy(data, pos, n);
+            pos += Pad8(n);
+            return true;
+        }
+        template<typename T, typename Vec> bool GetArray(Vec& vec) {
+            uint64_t n;
+            if (!Get(&n, sizeof(n)) || n > (uint64_t)(end - pos)/sizeof(T)) return false;
+            vec.resize(n);
+            return n == 0 || Get(&vec[0], n*sizeof(T));
+        }
+    };
+}
+
+//______________________________________________________________________________________________________
+uint64_t ApexVDCCalibCache::Hash(const char* data, size_t n)
+{
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t i=0; i<n; i++) {
+        hash ^= (unsigned char)data[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+//______________________________________________________________________________________________________
+long long ApexVDCCalibCache::FindValidity(const char* data, size_t n, long long run_stamp)
+{
+    long long validity = 0;
+
+    ForEachStamp(data, n, [&](long long stamp) {
+        if (stamp <= run_stamp && stamp > validity) validity = stamp;
+    });
+
+    return validity;
+}
+
+//______________________________________________________________________________________________________
+bool ApexVDCCalibCache::MakeKey(FILE* file, long long run_stamp, Key& key)
+{
+    struct stat st;
+    if (fstat(fileno(file), &st) != 0) return false;
+
+    auto same_file = [&](const FileKeys& keys) {
+        return keys.dev == st.st_dev && keys.ino == st.st_ino && keys.size == st.st_size &&
+               keys.mtime.tv_sec == st.st_mtim.tv_sec && keys.mtime.tv_nsec == st.st_mtim.tv_nsec;
+    };
+
+    //seen before, and not changed since
+    {
+        lock_guard<mutex> guard(gKeysLock);
+        auto it = find_if(gKeys.begin(), gKeys.end(), same_file);
+        if (it != gKeys.end()) {
+            key.hash     = it->hash;
+            key.validity = LatestStamp(it->stamps, run_stamp);
+            return true;
+        }
+    }
+
+    //otherwise, read & hash the whole file
+    if (fseek(file, 0, SEEK_END) != 0) return false;
+    const long size = ftell(file);
+    rewind(file);
+    if (size < 0) return false;
+
+    vector<char> buf(size);
+    const bool ok = fread(buf.data(), 1, size, file) == (size_t)size;
+    rewind(file);
+    if (!ok) return false;
+
+    FileKeys keys{ st.st_dev, st.st_ino, st.st_size, st.st_mtim, Hash(buf.data(), buf.size()), {} };
+    ForEachStamp(buf.data(), buf.size(), [&](long long stamp) { keys.stamps.push_back(stamp); });
+    sort(keys.stamps.begin(), keys.stamps.end());
+
+    key.hash     = keys.hash;
+    key.validity = LatestStamp(keys.stamps, run_stamp);
+
+    //(a file which changed replaces what we had for it)
+    lock_guard<mutex> guard(gKeysLock);
+    auto it = find_if(gKeys.begin(), gKeys.end(), [&](const FileKeys& k) { return k.dev == st.st_dev && k.ino == st.st_ino; });
+    if (it != gKeys.end()) *it = std::move(keys);
+    else                   gKeys.push_back(std::move(keys));
+
+    return true;
+}
+
+//______________________________________________________________________________________________________
+void ApexVDCCalibCache::SetDirectory(const char* dir)
+{
+    lock_guard<mutex> guard(gDirLock);
+    gDir    = dir ? dir : "";
+    gDirSet = true;
+}
+
+//______________________________________________________________________________________________________
+string ApexVDCCalibCache::GetDirectory()
+{
+    lock_guard<mutex> guard(gDirLock);
+    if (gDirSet) return gDir;
+
+    const char* env = getenv("APEXVDC_CALIB_CACHE");
+    return env ? env : "";
+}
+
+//______________________________________________________________________________________________________
+string ApexVDCCalibCache::MakePath(const string& name, const Key& key)
+{
+    const string dir = GetDirectory();
+    if (dir.empty()) return "";
+
+    char buf[64];
+    snprintf(buf, sizeof(buf), "%016llx.%014lld.vdccal", (unsigned long long)key.hash, key.validity);
+
+    return dir + "/" + name + (name.empty() || name.back() == '.' ? "" : ".") + buf;
+}
+
+//______________________________________________________________________________________________________
+bool ApexVDCCalibCache::Read(const string& path, const Key& key, ApexVDCPlaneDB& db)
+{
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(Header)) { close(fd); return false; }
+
+    const size_t size = st.st_size;
+    void* map = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return false;
+
+    const char* data = (const char*)map;
+
+    //check that this is the file we want
+    Header header;
+    memcpy(&header, data, sizeof(header));
+
+    bool ok = memcmp(header.magic, kMagic, sizeof(kMagic)) == 0 &&
+              header.version      == kVersion &&
+              header.scalars_size == sizeof(ApexVDCPlaneDB::Scalars) &&
+              header.hash         == key.hash &&
+              header.validity     == key.validity &&
+              header.total_size   == size;
+
+    //read into a copy, so that 'db' is untouched if the file turns out to be bad
+    ApexVDCPlaneDB tmp;
+    if (ok) {
+        Reader in{ data + Pad8(sizeof(Header)), data + size };
+
+        ok = in.Get(&tmp.s, sizeof(tmp.s)) &&
+             in.GetArray<int>   (tmp.detmap) &&
+             in.GetArray<int>   (tmp.badlist) &&
+             in.GetArray<double>(tmp.tdc_offsets) &&
+             in.GetArray<double>(tmp.ttd_table) &&
+             in.GetArray<char>  (tmp.ttd_conv) &&
+             in.GetArray<char>  (tmp.description) &&
+             in.GetArray<char>  (tmp.reftime_var) &&
+             in.GetArray<char>  (tmp.t0_output);
+    }
+
+    munmap(map, size);
+
+    if (ok) db = std::move(tmp);
+    return ok;
+}
+
+//______________________________________________________________________________________________________
+bool ApexVDCCalibCache::Write(const string& path, const Key& key, const ApexVDCPlaneDB& db)
+{
+    Writer out;
+
+    Header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version      = kVersion;
+    header.scalars_size = sizeof(ApexVDCPlaneDB::Scalars);
+    header.hash         = key.hash;
+    header.validity     = key.validity;
+
+    out.Put(&header, sizeof(header));
+    out.PutScalars(db.s);
+    out.PutArray(db.detmap.data(),      db.detmap.size());
+    out.PutArray(db.badlist.data(),     db.badlist.size());
+    out.PutArray(db.tdc_offsets.data(), db.tdc_offsets.size());
+    out.PutArray(db.ttd_table.data(),   db.ttd_table.size());
+    out.PutArray(db.ttd_conv.data(),    db.ttd_conv.size());
+    out.PutArray(db.description.data(), db.description.size());
+    out.PutArray(db.reftime_var.data(), db.reftime_var.size());
+    out.PutArray(db.t0_output.data(),   db.t0_output.size());
+
+    //now that we know the size, fill it in
+    const uint64_t total_size = out.buf.size();
+    memcpy(out.buf.data() + offsetof(Header, total_size), &total_size, sizeof(total_size));
+
+    //write to a temporary file first, then rename it, so that no one ever reads a half-written file
+    const string tmp_path = path + ".tmp." + to_string(getpid());
+
+    FILE* file = fopen(tmp_path.c_str(), "wb");
+    if (!file) return false;
+
+    const bool ok = fwrite(out.buf.data(), 1, out.buf.size(), file) == out.buf.size();
+
+    if (fclose(file) != 0 || !ok || rename(tmp_path.c_str(), path.c_str()) != 0) {
+        remove(tmp_path.c_str());
+        return false;
+    }
+    return true;
+}
+//______________________________________________________________________________________________________
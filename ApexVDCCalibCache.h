@@ -0,0 +1,142 @@
+#ifndef ApexVDCCalibCache_H
+#define ApexVDCCalibCache_H
+////////////////////////////////////////////////////////////////////////////////////////
+//
+//  namespace: ApexVDCCalibCache
+//  Binary cache of the parsed DB parameters of one VDC plane, for fast startup when
+//  replaying many short runs.
+//
+//  Parsing the text DB (368 tdc offsets, the detmap, geometry, ...) for every plane of
+//  every job adds up. So, once a plane has parsed its DB, everything it read is written
+//  to a small binary file (see ApexVDCPlaneDB below), and the next job which needs the
+//  same parameters just maps that file into memory instead.
+//
+//  A cache file is keyed by:
+//   - the 64-bit FNV-1a hash of the whole DB file, so that any edit to it makes a new key
+//   - the validity timestamp in effect for the run, i.e. the latest '[ yyyy-mm-dd hh:mm:ss ]'
+//     line in the DB file which is not after the run date
+//  Both are in the file name, and in the file's header (along with a format version and
+//  the size of the parameter block), which are all checked on loading. Any file which does
+//  not match is ignored, and the text DB is read instead.
+//
+//  The planes of a detector (and every Init() of a plane) usually read the same DB file, so
+//  MakeKey() remembers the hash & timestamps of each file it has read, and only reads it
+//  again once its size or modification time changes. (An edit which keeps both, to the
+//  nanosecond, is not noticed until the next job.)
+//
+//  Files are written to a temporary name and then renamed, so that several jobs sharing
+//  a cache directory never see a half-written file.
+//
+//  The cache is off unless a directory is given, either with SetDirectory() or with the
+//  environment variable APEXVDC_CALIB_CACHE.
+//
+//  This does not depend on Podd or ROOT, so that it can be used outside of the analyzer.
+//
+//  - Seth H 28 Sep 25
+////////////////////////////////////////////////////////////////////////////////////////
+
+#include "ApexVDCTTDConv.h"
+#include "ApexVDCHotWireFinder.h"
+#include "ApexVDCT0Calib.h"
+#include "ApexVDCPlaneEvent.h"
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <cstdint>
+
+//everything one plane reads from its DB file, as it appears in the file (i.e., before any unit
+// conversion or derived quantities). see ApexVDCPlane::ReadDataBase() for the DB key of each.
+struct ApexVDCPlaneDB {
+
+    //all fixed-size parameters. this is written to (and read from) the cache as a single block.
+    struct Scalars {
+        //geometry
+        double center[3]        = {0., 0., 0.};
+        double length           = 0.;
+        double width            = 0.;
+        int    nwires           = 0;
+        double first_wire_pos   = 0.;
+        double wire_spacing     = 0.;
+        double wire_angle       = 0.;   //[deg]
+        //TDC
+        double tdc_resolution   = 0.;
+        double tdc_rawtime_min  = 0.;
+        double tdc_rawtime_max  = 0.;
+        //groups & group fit
+        int    group_hits_min   = 0;
+        int    group_span_min   = 0;
+        int    group_span_max   = 0;
+        int    group_max_gap    = 0;
+        double fit_sigma        = 0.;
+        //time-to-distance conversion
+        ApexVDCTTDConv::AnalyticParams ttd_params;
+        double ttd_tmin         = 0.;
+        double ttd_tmax         = 0.;
+        int    ttd_nbins        = 0;
+        int    ttd_ngroups      = 1;
+        //reference time
+        int    reftime_chan[3]  = {-1, -1, -1};
+        double reftime_offset   = 0.;
+        double reftime_min      = 0.;
+        double reftime_max      = 0.;
+        //hot-wire finder
+        int    hot_enable       = 0;
+        ApexVDCHotWireFinder::Config hot_config;
+        //t0 calibration
+        int    t0_enable        = 0;
+        ApexVDCT0Calib::Config t0_config;
+        //decoding
+        int    last_stage       = ApexVDCPlaneEvent::kStageFit;
+        int    use_std_sort     = 0;
+        int    use_iterator     = 0;
+        int    hits_reserve     = 0;
+        int    groups_reserve   = 0;
+    } s;
+
+    std::vector<int>    detmap;
+    std::vector<int>    badlist;
+    std::vector<double> tdc_offsets;
+    std::vector<double> ttd_table;
+    std::string         ttd_conv;
+    std::string         description;
+    std::string         reftime_var;
+    std::string         t0_output;
+};
+
+namespace ApexVDCCalibCache {
+
+    const unsigned int kVersion = 4;    //bump this whenever the file layout, or ApexVDCPlaneDB, changes
+
+    struct Key {
+        uint64_t  hash     = 0;     //FNV-1a hash of the DB file
+        long long validity = 0;     //yyyymmddhhmmss of the validity timestamp in effect (0 if none)
+    };
+
+    //64-bit FNV-1a hash
+    uint64_t Hash(const char* data, size_t n);
+
+    //the latest '[ yyyy-mm-dd hh:mm:ss ]' timestamp (the time is optional) in 'data' which is not
+    // after 'run_stamp' (yyyymmddhhmmss). returns 0 if there is none.
+    long long FindValidity(const char* data, size_t n, long long run_stamp);
+
+    //compute the key of an (open) DB file, for a run at 'run_stamp'. the file is only read (& then 
+    // rewound) if it was not seen before, or has changed since (see above). returns false if the file 
+    // can't be read.
+    bool MakeKey(FILE* file, long long run_stamp, Key& key);
+
+    //directory of the cache. if this is empty, the cache is not used.
+    void        SetDirectory(const char* dir);
+    std::string GetDirectory();
+
+    //path of the cache file for the given name (e.g. the plane's prefix) & key. empty if the cache is off.
+    std::string MakePath(const std::string& name, const Key& key);
+
+    //load 'db' from the cache file at 'path'. returns false (leaving 'db' untouched) if the file is
+    // missing, or doesn't match this key & version.
+    bool Read(const std::string& path, const Key& key, ApexVDCPlaneDB& db);
+
+    //write 'db' to the cache file at 'path'. returns false if it could not be written.
+    bool Write(const std::string& path, const Key& key, const ApexVDCPlaneDB& db);
+}
+
+#endif
@@ -0,0 +1,104 @@
+#include "ApexVDCClusterFit.h"
+#include <algorithm>
+
+using namespace std;
+
+//______________________________________________________________________________________________________
+size_t ApexVDCClusterFit::Fit( const double* pos, const double* dist, const int* wire,
+                               const int* start, const int* end, size_t ngroups,
+                               double sigma,
+                               double* fit_pos, double* fit_slope, double* fit_chi2, int* fit_pivot,
+                               vector<double>& scratch )
+{
+    //make sure the scratch space is big enough for the largest group. this only allocates if a
+    // larger group shows up than in any event before.
+    int max_hits = 0;
+    for (size_t g=0; g<ngroups; g++) max_hits = max(max_hits, end[g] - start[g] + 1);
+
+    if (scratch.size() < 4*((size_t)max_hits + 1)) scratch.resize(4*((size_t)max_hits + 1));
+
+    double* x   = scratch.data();           //wire position of each used hit (relative to the first)
+    double* d   = x + (max_hits + 1);       //drift distance of each used hit
+    double* Pd  = d + (max_hits + 1);       //Pd[k]  = sum of d[j]      for j<k
+    double* Pxd = Pd + (max_hits + 1);      //Pxd[k] = sum of x[j]*d[j] for j<k
+
+    const double inv_sigma2 = 1./(sigma*sigma);
+
+    size_t nfit = 0;
+
+    for (size_t g=0; g<ngroups; g++) {
+
+        //collect the first hit on each wire, and find the pivot (the hit with the smallest distance).
+        // positions are taken relative to the first wire, so that the sums below don't lose precision.
+        // they are also taken along the direction in which wire numbers grow ('dir'), so that 'x' always 
+        // increases with the hit index, whatever the sign of the wire spacing. 
+        const double x_ref = pos[start[g]];
+        const double dir   = pos[end[g]] < x_ref ? -1. : 1.;
+
+        int n = 0, pivot = 0, pivot_wire = wire[start[g]];
+        for (int i=start[g]; i<=end[g]; i++) {
+
+            if (i > start[g] && wire[i] == wire[i-1]) continue;
+
+            x[n] = dir*(pos[i] - x_ref);
+            d[n] = dist[i];
+            if (d[n] < d[pivot]) { pivot = n; pivot_wire = wire[i]; }
+            n++;
+        }
+
+        fit_pivot[g] = -1;
+        fit_chi2[g]  = -1.;
+        fit_pos[g]   = x_ref;
+        fit_slope[g] = 0.;
+
+        if (n < 2) continue;
+
+        //sums which don't depend on the signs
+        double S = n, Sx = 0., Sxx = 0., Sdd = 0.;
+        Pd[0] = 0.; Pxd[0] = 0.;
+
+        for (int j=0; j<n; j++) {
+            Sx  += x[j];
+            Sxx += x[j]*x[j];
+            Sdd += d[j]*d[j];
+            Pd [j+1] = Pd [j] + d[j];
+            Pxd[j+1] = Pxd[j] + x[j]*d[j];
+        }
+
+        const double det = S*Sxx - Sx*Sx;
+
+        //try each split 'k' around the pivot: hits [0,k) get a negative sign, hits [k,n) a positive one.
+        double best_chi2 = -1., best_a = 0., best_b = 0.;
+
+        for (int k=max(0, pivot-1); k<=min(n, pivot+2); k++) {
+
+            const double Sy  = Pd [n] - 2.*Pd [k];
+            const double Sxy = Pxd[n] - 2.*Pxd[k];
+
+            const double b = (S*Sxy - Sx*Sy) / det;
+
+            //an upside-down 'V' is not a track
+            if (b <= 0.) continue;
+
+            const double a = (Sy - b*Sx) / S;
+
+            //residual sum of squares of the best line, in closed form (clamped against rounding)
+            const double chi2 = max(0., Sdd - a*Sy - b*Sxy) * inv_sigma2;
+
+            if (best_chi2 < 0. || chi2 < best_chi2) { best_chi2 = chi2; best_a = a; best_b = b; }
+        }
+
+        if (best_chi2 < 0.) continue;
+
+        //the line is y = a + b*x, so it crosses y=0 at x = -a/b (which is back along 'dir' from the first wire)
+        fit_pos[g]   = x_ref - dir*best_a/best_b;
+        fit_slope[g] = best_b;
+        fit_chi2[g]  = best_chi2;
+        fit_pivot[g] = pivot_wire;
+
+        nfit++;
+    }
+
+    return nfit;
+}
+//______________________________________________________________________________________________________
@@ -0,0 +1,63 @@
+#ifndef ApexVDCClusterFit_H
+#define ApexVDCClusterFit_H
+////////////////////////////////////////////////////////////////////////////////////////
+//
+//  namespace: ApexVDCClusterFit
+//  Fit of the crossing point & slope of a track for every hit group of a plane at once.
+//
+//  A track crossing the wire plane at position 'x0' leaves drift distances which form a
+//  'V' as a function of wire position 'x'. Giving the hits on the low side of the crossing
+//  a negative sign, the signed distances lie on a line:
+//
+//      y_i = -d_i  (x_i < x0),   y_i = +d_i  (x_i > x0),      y = slope*(x - x0)
+//
+//  Which hits get the negative sign is not known in advance. The 'pivot' is the hit with
+//  the smallest drift distance; only the sign splits right around it (the pivot & its
+//  neighbors on either side) are tried, and splits which give a non-positive slope (an
+//  upside-down V) are dropped right away.
+//
+//  Every candidate split is fit with closed-form (weighted) least squares. Flipping the
+//  sign of the first k hits only changes sum(y) and sum(x*y), and these are computed for
+//  any k from prefix sums of d & x*d, so each candidate costs O(1) after one O(n) pass.
+//
+//  Only the first hit on each wire (the one with the shortest drift time) is used.
+//
+//  The fit is done along the direction in which wire numbers grow, so it gives the same
+//  result whether the wire spacing is positive or negative (as in most Hall A VDC DBs):
+//  the crossing position is in the plane's own coordinate, and the slope is always
+//  positive (the magnitude of d(distance)/d(position)).
+//
+//  This does not depend on Podd or ROOT, so that it can be used outside of the analyzer.
+//
+//  - Seth H 28 Sep 25
+////////////////////////////////////////////////////////////////////////////////////////
+
+#include <vector>
+#include <cstddef>
+
+namespace ApexVDCClusterFit {
+
+    //fit 'ngroups' groups of hits. group 'g' is made of hits [start[g], end[g]] (inclusive) of the
+    // hit arrays 'pos' (wire position), 'dist' (drift distance) & 'wire' (wire number), which must be
+    // sorted by wire. 'sigma' is the resolution of one drift distance, which sets the scale of chi2.
+    //
+    // for each group, this fills the crossing position & slope, the chi2 of the fit, and the wire of
+    // the pivot hit. groups which can't be fit (fewer than 2 wires, or no split with a positive slope)
+    // get chi2 = -1. 'scratch' is resized as needed, so that it can be reused from event to event.
+    //
+    // returns the number of groups which could be fit.
+    size_t Fit( const double*        pos,
+                const double*        dist,
+                const int*           wire,
+                const int*           start,
+                const int*           end,
+                size_t               ngroups,
+                double               sigma,
+                double*              fit_pos,
+                double*              fit_slope,
+                double*              fit_chi2,
+                int*                 fit_pivot,
+                std::vector<double>& scratch );
+}
+
+#endif
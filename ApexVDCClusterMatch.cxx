@@ -0,0 +1,165 @@
+#include "ApexVDCClusterMatch.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace std;
+
+//______________________________________________________________________________________________________
+void ApexVDCClusterMatch::MakeTable(const ApexVDCPlaneEvent& event, double offset, vector<ApexVDCCluster>& table)
+{
+    table.clear();
+
+    for (size_t g=0; g<event.group_chi2.size(); g++) {
+
+        //skip groups which could not be fit (a fitted group always has a positive slope, see ApexVDCClusterFit.h)
+        if (event.group_chi2[g] < 0. || !(event.group_slope[g] > 0.)) continue;
+
+        table.push_back({ event.group_pos[g] + offset, 1./event.group_slope[g], (int)g });
+    }
+
+    //groups are found in wire order, so this is usually sorted already
+    if (!is_sorted(table.begin(), table.end(),
+                   [](const ApexVDCCluster& a, const ApexVDCCluster& b) { return a.pos < b.pos; })) {
+
+        sort(table.begin(), table.end(),
+             [](const ApexVDCCluster& a, const ApexVDCCluster& b) { return a.pos < b.pos; });
+    }
+}
+
+//______________________________________________________________________________________________________
+size_t ApexVDCClusterMatch::MatchPlanes( const vector<ApexVDCCluster>& lower,
+                                         const vector<ApexVDCCluster>& upper,
+                                         double dz, double pos_window, double slope_window,
+                                         vector<ApexVDCClusterPair>& pairs )
+{
+    pairs.clear();
+
+    if (lower.empty() || upper.empty()) return 0;
+
+    const double window = pos_window + slope_window*fabs(dz);
+
+    size_t ncand = 0;
+
+    for (size_t i=0; i<lower.size(); i++) {
+
+        const double predicted = lower[i].pos + lower[i].slope*dz;
+
+        //first upper cluster inside the window
+        auto it = lower_bound(upper.begin(), upper.end(), predicted - window,
+                              [](const ApexVDCCluster& c, double pos) { return c.pos < pos; });
+
+        for (; it != upper.end() && it->pos <= predicted + window; ++it) {
+
+            ncand++;
+
+            //the slope of the track, as measured by the two positions, must agree with both clusters
+            const double slope = (it->pos - lower[i].pos) / dz;
+
+            if (fabs(slope - lower[i].slope) > slope_window ||
+                fabs(slope - it->slope)      > slope_window) continue;
+
+            pairs.push_back({ (int)i, (int)(it - upper.begin()), lower[i].pos, slope });
+        }
+    }
+
+    return ncand;
+}
+//______________________________________________________________________________________________________
+namespace {
+
+    //true if the track of a U pair & a V pair crosses the active area 'a' (plus the margin)
+    bool Inside(const ApexVDCClusterPair& up, const ApexVDCClusterPair& vp, const ApexVDCUVGeometry& geom,
+                const ApexVDCUVGeometry::Area& a, double sin_u, double cos_u, double sin_v, double cos_v,
+                double sin_vu)
+    {
+        const double u = up.pos + up.slope*(a.z - geom.z_u);
+        const double v = vp.pos + vp.slope*(a.z - geom.z_v);
+
+        const double x = (u*sin_v - v*sin_u) / sin_vu;
+        const double y = (v*cos_u - u*cos_v) / sin_vu;
+
+        return (a.length <= 0. || fabs(x - a.x) <= 0.5*a.length + geom.margin) &&
+               (a.width  <= 0. || fabs(y - a.y) <= 0.5*a.width  + geom.margin);
+    }
+
+    //narrow [lo, hi] to the v's for which |c + b*v| <= h
+    void Narrow(double c, double b, double h, double& lo, double& hi)
+    {
+        if (b == 0.) {
+            if (!(fabs(c) <= h)) { lo = 1.; hi = -1.; }
+            return;
+        }
+        const double v1 = (-h - c)/b, v2 = (h - c)/b;
+
+        lo = max(lo, min(v1, v2));
+        hi = min(hi, max(v1, v2));
+    }
+}
+
+//______________________________________________________________________________________________________
+size_t ApexVDCClusterMatch::MatchUV( const vector<ApexVDCClusterPair>& upairs,
+                                     const vector<ApexVDCClusterPair>& vpairs,
+                                     const ApexVDCUVGeometry& geom,
+                                     vector<ApexVDCVIndex>& index,
+                                     vector<ApexVDCTrackPair>& tracks )
+{
+    tracks.clear();
+
+    if (upairs.empty() || vpairs.empty()) return 0;
+
+    const double sin_u = sin(geom.u_angle), cos_u = cos(geom.u_angle);
+    const double sin_v = sin(geom.v_angle), cos_v = cos(geom.v_angle);
+    const double sin_vu = sin(geom.v_angle - geom.u_angle);
+
+    const ApexVDCUVGeometry::Area& lower = geom.area[0];
+
+    //the V pairs, sorted by where they cross the lower U plane
+    index.clear();
+    for (size_t j=0; j<vpairs.size(); j++)
+        index.push_back({ vpairs[j].pos + vpairs[j].slope*(lower.z - geom.z_v), (int)j });
+
+    sort(index.begin(), index.end(), [](const ApexVDCVIndex& a, const ApexVDCVIndex& b) { return a.v < b.v; });
+
+    const double inf = numeric_limits<double>::infinity();
+
+    size_t ncand = 0;
+
+    for (size_t i=0; i<upairs.size(); i++) {
+
+        //the window in v, in the lower U plane, for which this U pair's track is inside of the lower chamber.
+        // x = (u*sin_v - v*sin_u)/sin_vu & y = (v*cos_u - u*cos_v)/sin_vu are linear in v for a given u.
+        const double u = upairs[i].pos + upairs[i].slope*(lower.z - geom.z_u);
+
+        double lo = -inf, hi = inf;
+
+        if (lower.length > 0.)
+            Narrow(u*sin_v/sin_vu - lower.x, -sin_u/sin_vu, 0.5*lower.length + geom.margin, lo, hi);
+        if (lower.width > 0.)
+            Narrow(-u*cos_v/sin_vu - lower.y, cos_u/sin_vu, 0.5*lower.width + geom.margin, lo, hi);
+
+        if (!(lo <= hi)) continue;
+
+        //widen the window a little, so that rounding never loses a pair which Inside() would keep
+        const double eps = 1.e-9*(1. + max(fabs(lo) < inf ? fabs(lo) : 0., fabs(hi) < inf ? fabs(hi) : 0.));
+
+        //first V pair inside the window
+        auto it = lower_bound(index.begin(), index.end(), lo - eps,
+                              [](const ApexVDCVIndex& c, double v) { return c.v < v; });
+
+        for (; it != index.end() && it->v <= hi + eps; ++it) {
+
+            ncand++;
+
+            const ApexVDCClusterPair& vp = vpairs[it->index];
+
+            if (!Inside(upairs[i], vp, geom, geom.area[0], sin_u, cos_u, sin_v, cos_v, sin_vu) ||
+                !Inside(upairs[i], vp, geom, geom.area[1], sin_u, cos_u, sin_v, cos_v, sin_vu)) continue;
+
+            tracks.push_back({ (int)i, it->index });
+        }
+    }
+
+    return ncand;
+}
+//______________________________________________________________________________________________________
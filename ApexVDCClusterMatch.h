@@ -0,0 +1,111 @@
+#ifndef ApexVDCClusterMatch_H
+#define ApexVDCClusterMatch_H
+////////////////////////////////////////////////////////////////////////////////////////
+//
+//  namespace: ApexVDCClusterMatch
+//  Matching of fitted clusters (hit groups) between the lower & upper VDC chambers.
+//
+//  Each plane's fitted groups are put in a 'cluster table', sorted by crossing position.
+//  A cluster in a lower plane (U1 or V1) predicts where the track crosses the upper plane
+//  which measures the same coordinate (U2 or V2), from its own position & slope:
+//
+//      predicted = pos + slope*dz          (dz = z_upper - z_lower)
+//
+//  Only the upper clusters within a window around the prediction are examined, and these
+//  are found with a binary search in the (sorted) upper table. The window is
+//
+//      pos_window + slope_window*|dz|
+//
+//  since each cluster's slope is only known to within about 'slope_window'. A candidate
+//  pair is kept if the slope between the two positions agrees (to within 'slope_window')
+//  with the slopes of both clusters. So, matching N lower to M upper clusters costs
+//  about N*log(M) instead of N*M.
+//
+//  A track is then one U pair and one V pair whose track crosses both chambers inside of
+//  their active area (plus a margin). For a given U pair, the chamber's x & y limits in the
+//  U1 plane are a window in v there, so the V pairs are sorted by their v in the U1 plane,
+//  and only those in the window of each U pair are examined (and then checked against both
+//  chambers). Every candidate examined (upper clusters in a window, and V pairs in the
+//  window of a U pair) is counted, so that this can be compared against the naive number
+//  of combinations (U1*V1*U2*V2).
+//
+//  This does not depend on Podd or ROOT, so that it can be used outside of the analyzer.
+//
+//  - Seth H 28 Sep 25
+////////////////////////////////////////////////////////////////////////////////////////
+
+#include "ApexVDCPlaneEvent.h"
+#include <vector>
+#include <cstddef>
+
+//one fitted group of one plane
+struct ApexVDCCluster {
+    double pos;     //crossing position in this plane's coordinate (u or v) [m]
+    double slope;   //du/dz (or dv/dz) of the track
+    int    group;   //index of this group in the plane's ApexVDCPlaneEvent
+};
+
+//a lower & upper cluster of the same coordinate (u or v) which belong to the same track
+struct ApexVDCClusterPair {
+    int    lower;   //index into the lower cluster table
+    int    upper;   //index into the upper cluster table
+    double pos;     //crossing position at the lower plane [m]
+    double slope;   //slope from the two crossing positions (du/dz or dv/dz)
+};
+
+//a U pair & a V pair which make a track
+struct ApexVDCTrackPair {
+    int    u;       //index into the U pairs
+    int    v;       //index into the V pairs
+};
+
+//what's needed to check whether the track of a U pair & a V pair crosses a chamber inside of its active area
+struct ApexVDCUVGeometry {
+    double u_angle, v_angle;    //wire angles of the U & V planes
+    double z_u, z_v;            //z of the lower U & V planes, where the pairs' positions are
+
+    //the active area of each chamber, at the z of its U plane. a length (or width) <= 0 does not cut.
+    struct Area {
+        double z;
+        double x, y;            //center [m]
+        double length, width;   //along x & y [m]
+    } area[2];
+
+    double margin;              //added to the active area on each side [m]
+};
+
+//a V pair's position in the lower U plane, for the index used by MatchUV()
+struct ApexVDCVIndex {
+    double v;
+    int    index;
+};
+
+namespace ApexVDCClusterMatch {
+
+    //fill 'table' with all groups of 'event' which could be fit, sorted by position. 'offset' is added
+    // to each group's position (to go from wire-plane to detector coordinates).
+    //
+    // as in Podd's THaVDCCluster, all tracks are taken to cross the planes in the same direction, so
+    // that the slope of each cluster is 1/(fitted slope of its drift distances).
+    void MakeTable(const ApexVDCPlaneEvent& event, double offset, std::vector<ApexVDCCluster>& table);
+
+    //match clusters of a lower & upper plane (see above). 'pairs' is cleared first.
+    // returns the number of candidate pairs examined.
+    size_t MatchPlanes( const std::vector<ApexVDCCluster>&  lower,
+                        const std::vector<ApexVDCCluster>&  upper,
+                        double                              dz,
+                        double                              pos_window,
+                        double                              slope_window,
+                        std::vector<ApexVDCClusterPair>&    pairs );
+
+    //match U pairs to V pairs (see above). 'tracks' is cleared first, and 'index' is scratch space
+    // (kept by the caller, so that it is not allocated in every event). returns the number of
+    // U/V pair combinations examined.
+    size_t MatchUV( const std::vector<ApexVDCClusterPair>&  upairs,
+                    const std::vector<ApexVDCClusterPair>&  vpairs,
+                    const ApexVDCUVGeometry&                geom,
+                    std::vector<ApexVDCVIndex>&             index,
+                    std::vector<ApexVDCTrackPair>&          tracks );
+}
+
+#endif
@@ -2,20 +2,23 @@
 #define ApexVDCHitGroup_H
 ////////////////////////////////////////////////////////////////////////////////////////
 //
-//  struct: ApexVDCHitGroup 
-//  A 'group' is a collection of hits which are close enough to one another to be 
-//  considered as a candidate for a cluster.   
+//  struct: ApexVDCHitGroup
+//  A 'group' is a collection of hits which are close enough to one another to be
+//  considered as a candidate for a cluster.
 //
-//  Note: right now its just an alias for a std::vector<ApexVDCHit>, but if it needs
-//  more complicated functionality of its own later, I can add it. 
+//  A group does not own (or copy) any hits. It is just a range of indices into the
+//  (sorted) hit list of the plane which found it, so forming groups for an event
+//  never has to allocate anything once the plane's group list has grown large enough.
 //
-//  - Seth H 28 Sep 25 
+//  - Seth H 28 Sep 25
 ////////////////////////////////////////////////////////////////////////////////////////
 
-#include "ApexVDCWire.h"
-#include "ApexVDCHit.h"
-#include <vector> 
+struct ApexVDCHitGroup {
+    int start;  //index of the first hit in this group (in the plane's sorted hit list)
+    int end;    //index of the last hit in this group (inclusive)
+    int span;   //number of wires between first and last hit + 1
 
-using ApexVDCHitGroup = std::vector<ApexVDCHit>; 
+    int GetNHits() const { return end - start + 1; }
+};
 
-#endif 
\ No newline at end of file
+#endif
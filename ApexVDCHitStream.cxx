@@ -0,0 +1,332 @@
+#include "ApexVDCHitStream.h"
+#include "ApexVDCCalibCache.h"
+#include <cstring>
+#include <stdexcept>
+#include <sstream>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using namespace std;
+
+namespace {
+
+    const char kMagic[8]        = { 'A','P','E','X','V','D','C','H' };
+    const char kTrailerMagic[8] = { 'A','P','E','X','V','D','C','I' };
+
+    struct Header {
+        char     magic[8];
+        uint32_t version;
+        int32_t  nwires;
+        uint64_t calib_hash;
+    };
+
+    struct Trailer {
+        uint64_t nevents;
+        uint64_t index_offset;
+        char     magic[8];
+    };
+
+    //unsigned LEB128
+    inline void PutVarint(vector<unsigned char>& buf, uint32_t x) {
+        while (x >= 0x80) { buf.push_back((unsigned char)(x | 0x80)); x >>= 7; }
+        buf.push_back((unsigned char)x);
+    }
+
+    //returns nullptr if the varint runs past 'end'
+    inline const unsigned char* GetVarint(const unsigned char* p, const unsigned char* end, uint32_t& x) {
+        x = 0;
+        for (int shift=0; p < end && shift < 35; shift += 7) {
+            const unsigned char b = *p++;
+            x |= (uint32_t)(b & 0x7f) << shift;
+            if (!(b & 0x80)) return p;
+        }
+        return nullptr;
+    }
+
+    inline uint64_t GetU64(const unsigned char* p) { uint64_t x; memcpy(&x, p, sizeof(x)); return x; }
+}
+
+//______________________________________________________________________________________________________
+uint64_t ApexVDCHitStream::CalibHash(const ApexVDCPlaneCalib& calib)
+{
+    vector<char> buf(sizeof(double)*(calib.tdc_offsets.size() + 1));
+    memcpy(buf.data(), &calib.tdc_resolution, sizeof(double));
+    memcpy(buf.data() + sizeof(double), calib.tdc_offsets.data(), sizeof(double)*calib.tdc_offsets.size());
+
+    return ApexVDCCalibCache::Hash(buf.data(), buf.size());
+}
+
+//______________________________________________________________________________________________________
+ApexVDCHitStreamWriter::~ApexVDCHitStreamWriter()
+{
+    if (fFile) Close();
+}
+
+//______________________________________________________________________________________________________
+void ApexVDCHitStreamWriter::Open(const char* path, const ApexVDCPlaneCalib& calib)
+{
+    const char* const here = "ApexVDCHitStreamWriter::Open";
+
+    if (fFile) Close();
+
+    //every hit which passes the TDC cut must fit in the 16-bit raw TDC column. checking this once here 
+    // means that Write() can't fail halfway through a run. 
+    if (!(calib.tdc_rawtime_max <= 65535.)) {
+        ostringstream oss;
+        oss << "in <" << here << ">: the TDC cut lets through raw TDC values up to " << calib.tdc_rawtime_max
+            << ", which do not fit in 16 bits (max. 65535). '" << path << "' was not opened.";
+        throw invalid_argument(oss.str());
+    }
+
+    fFile = fopen(path, "wb");
+    if (!fFile) {
+        ostringstream oss;
+        oss << "in <" << here << ">: can't open '" << path << "' for writing.";
+        throw runtime_error(oss.str());
+    }
+    fPath = path;
+
+    Header header;
+    memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version    = ApexVDCHitStream::kVersion;
+    header.nwires     = calib.nwires;
+    header.calib_hash = ApexVDCHitStream::CalibHash(calib);
+
+    fwrite(&header, sizeof(header), 1, fFile);
+    fOffset = sizeof(header);
+
+    fIndex.clear();
+}
+
+//______________________________________________________________________________________________________
+void ApexVDCHitStreamWriter::Write(uint64_t event_number, const ApexVDCPlaneEvent& event)
+{
+    const char* const here = "ApexVDCHitStreamWriter::Write";
+
+    const size_t nhits = event.hits.size();
+
+    fBuffer.clear();
+    PutVarint(fBuffer, nhits);
+
+    //reference time
+    fBuffer.push_back(event.has_reftime ? 1 : 0);
+    if (event.has_reftime) {
+        const size_t at = fBuffer.size();
+        fBuffer.resize(at + sizeof(double));
+        memcpy(fBuffer.data() + at, &event.reftime, sizeof(double));
+    }
+
+    //wire column
+    int last_wire = 0;
+    for (size_t i=0; i<nhits; i++) {
+        const int wire = event.hits[i].wire->GetNum();
+        PutVarint(fBuffer, wire - last_wire);
+        last_wire = wire;
+    }
+
+    //raw TDC column
+    const size_t at = fBuffer.size();
+    fBuffer.resize(at + 2*nhits);
+
+    for (size_t i=0; i<nhits; i++) {
+        const double rawtime = event.hits[i].rawtime;
+
+        if (!(rawtime >= 0. && rawtime <= 65535.)) {
+            ostringstream oss;
+            oss << "in <" << here << ">: raw TDC value " << rawtime << " (event " << event_number << ") "
+                   "does not fit in 16 bits.";
+            throw out_of_range(oss.str());
+        }
+        const uint16_t raw = (uint16_t)rawtime;
+        fBuffer[at + 2*i]     = raw & 0xff;
+        fBuffer[at + 2*i + 1] = raw >> 8;
+    }
+
+    fwrite(fBuffer.data(), 1, fBuffer.size(), fFile);
+
+    fIndex.push_back(event_number);
+    fIndex.push_back(fOffset);
+    fOffset += fBuffer.size();
+}
+
+//______________________________________________________________________________________________________
+void ApexVDCHitStreamWriter::Close()
+{
+    const char* const here = "ApexVDCHitStreamWriter::Close";
+
+    if (!fFile) return;
+
+    Trailer trailer;
+    trailer.nevents      = fIndex.size()/2;
+    trailer.index_offset = fOffset;
+    memcpy(trailer.magic, kTrailerMagic, sizeof(kTrailerMagic));
+
+    fwrite(fIndex.data(), sizeof(uint64_t), fIndex.size(), fFile);
+    fwrite(&trailer, sizeof(trailer), 1, fFile);
+
+    const bool failed = ferror(fFile) != 0;
+
+    fclose(fFile);
+    fFile = nullptr;
+
+    if (failed) {
+        ostringstream oss;
+        oss << "in <" << here << ">: error while writing '" << fPath << "'.";
+        throw runtime_error(oss.str());
+    }
+}
+
+//______________________________________________________________________________________________________
+ApexVDCHitStreamReader::~ApexVDCHitStreamReader()
+{
+    Close();
+}
+
+//______________________________________________________________________________________________________
+void ApexVDCHitStreamReader::Open(const char* path)
+{
+    const char* const here = "ApexVDCHitStreamReader::Open";
+
+    Close();
+
+    const int fd = open(path, O_RDONLY);
+
+    struct stat st;
+    const bool ok = fd >= 0 && fstat(fd, &st) == 0;
+
+    if (!ok || (size_t)st.st_size < sizeof(Header) + sizeof(Trailer)) {
+        if (fd >= 0) close(fd);
+        ostringstream oss;
+        oss << "in <" << here << ">: can't open '" << path << "', or it is too small to be a hit stream.";
+        throw runtime_error(oss.str());
+    }
+
+    fSize = st.st_size;
+    void* map = mmap(nullptr, fSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (map == MAP_FAILED) {
+        fSize = 0;
+        ostringstream oss;
+        oss << "in <" << here << ">: can't map '" << path << "'.";
+        throw runtime_error(oss.str());
+    }
+    fData = (const unsigned char*)map;
+    fPath = path;
+
+    Header header;
+    Trailer trailer;
+    memcpy(&header,  fData, sizeof(header));
+    memcpy(&trailer, fData + fSize - sizeof(trailer), sizeof(trailer));
+
+    //check the header, the trailer, and that the index fits between the two
+    const bool valid =
+        memcmp(header.magic,  kMagic,        sizeof(kMagic)) == 0 &&
+        memcmp(trailer.magic, kTrailerMagic, sizeof(kTrailerMagic)) == 0 &&
+        trailer.index_offset >= sizeof(Header) &&
+        trailer.nevents <= (fSize - sizeof(Trailer))/(2*sizeof(uint64_t)) &&
+        trailer.index_offset + trailer.nevents*2*sizeof(uint64_t) == fSize - sizeof(Trailer);
+
+    if (!valid || header.version != ApexVDCHitStream::kVersion) {
+        Close();
+        ostringstream oss;
+        oss << "in <" << here << ">: '" << path << "' is not a valid hit stream";
+        if (valid) oss << " of version " << ApexVDCHitStream::kVersion << " (it is version " << header.version << ")";
+        oss << ".";
+        throw runtime_error(oss.str());
+    }
+
+    fNEvents   = trailer.nevents;
+    fIndex     = fData + trailer.index_offset;
+    fNWires    = header.nwires;
+    fCalibHash = header.calib_hash;
+}
+
+//______________________________________________________________________________________________________
+void ApexVDCHitStreamReader::Close()
+{
+    if (fData) munmap((void*)fData, fSize);
+
+    fData = nullptr; fSize = 0;
+    fNEvents = 0; fIndex = nullptr;
+}
+
+//______________________________________________________________________________________________________
+uint64_t ApexVDCHitStreamReader::GetEventNumber(uint64_t i) const
+{
+    return GetU64(fIndex + 2*sizeof(uint64_t)*i);
+}
+
+//______________________________________________________________________________________________________
+bool ApexVDCHitStreamReader::MatchesCalib(const ApexVDCPlaneCalib& calib) const
+{
+    return calib.nwires == fNWires && ApexVDCHitStream::CalibHash(calib) == fCalibHash;
+}
+
+//______________________________________________________________________________________________________
+int ApexVDCHitStreamReader::Read(uint64_t i, const ApexVDCPlaneCalib& calib, ApexVDCPlaneEvent& event) const
+{
+    const char* const here = "ApexVDCHitStreamReader::Read";
+
+    if (i >= fNEvents) {
+        ostringstream oss;
+        oss << "in <" << here << ">: event " << i << " is out of range (stream has " << fNEvents << " events).";
+        throw out_of_range(oss.str());
+    }
+
+    const unsigned char* p   = fData + GetU64(fIndex + 2*sizeof(uint64_t)*i + sizeof(uint64_t));
+    const unsigned char* end = fIndex;
+
+    auto corrupt = [&]() {
+        ostringstream oss;
+        oss << "in <" << here << ">: event " << i << " of '" << fPath << "' is corrupt.";
+        throw runtime_error(oss.str());
+    };
+
+    uint32_t nhits;
+    if (!(p = GetVarint(p, end, nhits))) corrupt();
+
+    //every hit takes at least 3 bytes (a 1-byte wire step & the 2-byte TDC value), so a count which 
+    // could not fit in the rest of the file is refused before anything is allocated for it 
+    if (nhits > (size_t)(end - p)/3) corrupt();
+
+    //reference time
+    if (p >= end) corrupt();
+    if (*p++) {
+        if ((size_t)(end - p) < sizeof(double)) corrupt();
+        double reftime;
+        memcpy(&reftime, p, sizeof(double));
+        p += sizeof(double);
+        event.SetRefTime(reftime);
+    }
+
+    //wire column
+    const size_t first = event.raw_wire.size();
+    event.raw_wire.resize(first + nhits);
+    int* wire = event.raw_wire.data() + first;
+
+    uint32_t w = 0;
+    for (uint32_t k=0; k<nhits; k++) {
+        uint32_t delta;
+        if (!(p = GetVarint(p, end, delta))) corrupt();
+        if (delta >= (uint32_t)calib.nwires) corrupt();     //(so that 'w' can't wrap around)
+        w += delta;
+        if (w >= (uint32_t)calib.nwires) corrupt();
+        wire[k] = w;
+    }
+
+    //raw TDC column
+    if ((size_t)(end - p) < 2*(size_t)nhits) corrupt();
+
+    event.raw_data.resize(first + nhits);
+    unsigned int* data = event.raw_data.data() + first;
+
+    for (uint32_t k=0; k<nhits; k++) data[k] = p[2*k] | ((unsigned int)p[2*k + 1] << 8);
+
+    //convert them just like in decoding (relative to the same reference time). the order of the hits 
+    // does not change, so they are still sorted.
+    return event.ConvertHits(calib);
+}
+//______________________________________________________________________________________________________
@@ -0,0 +1,128 @@
+#ifndef ApexVDCHitStream_H
+#define ApexVDCHitStream_H
+////////////////////////////////////////////////////////////////////////////////////////
+//
+//  classes: ApexVDCHitStreamWriter, ApexVDCHitStreamReader
+//  Compact binary stream of the decoded (accepted & sorted) hits of one VDC plane, so
+//  that grouping, fitting and tracking can be re-run without decoding the raw data again.
+//
+//  Each event is stored as two columns:
+//
+//      nhits                   varint
+//      has_reftime             1 byte: 1 if the event has a reference time, then
+//      reftime                 double (only if has_reftime), see ApexVDCPlaneEvent::reftime
+//      wire[nhits]             varint, the first one as is, then the difference to the one
+//                              before (hits are sorted by wire, so these are all >= 0, and
+//                              nearly always fit in one byte)
+//      rawtime[nhits]          16-bit little-endian raw TDC value
+//
+//  and after the last event comes the event index (for random access), then a trailer:
+//
+//      index[nevents]          { uint64 event number, uint64 offset of the event in the file }
+//      trailer                 { uint64 nevents, uint64 offset of the index, char[8] magic }
+//
+//  The file starts with a header which has a format version, the number of wires and a
+//  fingerprint of the TDC calibration (resolution & offsets) the hits were decoded with.
+//
+//  The reader maps the whole file into memory. For an event, it decodes the wire & raw TDC
+//  columns straight into the raw hit buffers of an ApexVDCPlaneEvent, and converts them
+//  with the same kernel as decoding does (see ApexVDCPlaneEvent::ConvertHits()). So, with
+//  the same calibration, the hits come back bit-for-bit identical to what was written,
+//  and in the same (sorted) order; only ApexVDCPlaneEvent::ProcessSorted() is left to do.
+//
+//  This does not depend on Podd or ROOT, so that it can be used outside of the analyzer.
+//
+//  - Seth H 28 Sep 25
+////////////////////////////////////////////////////////////////////////////////////////
+
+#include "ApexVDCPlaneCalib.h"
+#include "ApexVDCPlaneEvent.h"
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <cstdint>
+
+namespace ApexVDCHitStream {
+
+    const unsigned int kVersion = 2;    //bump this whenever the format changes
+
+    //fingerprint of the parts of a calibration which the stored hits depend on
+    uint64_t CalibHash(const ApexVDCPlaneCalib& calib);
+}
+
+class ApexVDCHitStreamWriter {
+
+private:
+    std::string fPath;
+    FILE*       fFile = nullptr;
+    uint64_t    fOffset = 0;            //current write position in the file
+
+    std::vector<uint64_t>       fIndex;     //event number & offset of each event, one after the other
+    std::vector<unsigned char>  fBuffer;    //encoded columns of the current event
+
+public:
+    ApexVDCHitStreamWriter() = default;
+    ~ApexVDCHitStreamWriter();
+
+    ApexVDCHitStreamWriter(const ApexVDCHitStreamWriter&) = delete;
+    ApexVDCHitStreamWriter& operator=(const ApexVDCHitStreamWriter&) = delete;
+
+    //open a new stream at 'path' for hits decoded with 'calib'. throws if the file can't be opened, or 
+    // if the TDC cut of 'calib' lets through raw TDC values which don't fit in 16 bits (tdc_rawtime_max 
+    // above 65535). 
+    void Open(const char* path, const ApexVDCPlaneCalib& calib);
+
+    //write the (sorted) hits of one event. with the calibration the stream was opened with, every hit 
+    // fits; throws if one does not (i.e. the calibration changed since).
+    void Write(uint64_t event_number, const ApexVDCPlaneEvent& event);
+
+    //write the index & trailer, and close the file
+    void Close();
+
+    bool     IsOpen()     const { return fFile != nullptr; }
+    uint64_t GetNEvents() const { return fIndex.size()/2; }
+};
+
+class ApexVDCHitStreamReader {
+
+private:
+    std::string          fPath;
+    const unsigned char* fData = nullptr;   //the mapped file
+    size_t               fSize = 0;
+
+    uint64_t             fNEvents = 0;
+    const unsigned char* fIndex   = nullptr;
+    int                  fNWires  = 0;
+    uint64_t             fCalibHash = 0;
+
+public:
+    ApexVDCHitStreamReader() = default;
+    ~ApexVDCHitStreamReader();
+
+    ApexVDCHitStreamReader(const ApexVDCHitStreamReader&) = delete;
+    ApexVDCHitStreamReader& operator=(const ApexVDCHitStreamReader&) = delete;
+
+    //map the stream at 'path'. throws if it is missing, or not a valid stream of this version.
+    void Open(const char* path);
+
+    void Close();
+
+    uint64_t GetNEvents()  const { return fNEvents; }
+    int      GetNWires()   const { return fNWires; }
+
+    //event number of the i-th event in the stream
+    uint64_t GetEventNumber(uint64_t i) const;
+
+    //true if the hits were written with the same TDC calibration as 'calib' (otherwise, the real
+    // times read back will not be the same as the ones written)
+    bool MatchesCalib(const ApexVDCPlaneCalib& calib) const;
+
+    //fingerprint of the TDC calibration the hits were written with (see ApexVDCHitStream::CalibHash())
+    uint64_t GetCalibHash() const { return fCalibHash; }
+
+    //fill 'event.hits' with the hits of the i-th event (see above). the event should be cleared
+    // first. 'event' is then ready for ApexVDCPlaneEvent::ProcessSorted(). returns the number of hits.
+    int Read(uint64_t i, const ApexVDCPlaneCalib& calib, ApexVDCPlaneEvent& event) const;
+};
+
+#endif
@@ -0,0 +1,111 @@
+#include "ApexVDCHotWireFinder.h"
+#include <algorithm>
+#include <stdexcept>
+#include <sstream>
+
+using namespace std;
+
+//______________________________________________________________________________________________________
+void ApexVDCHotWireFinder::Init(const Config& config, int nwires, const vector<unsigned char>& bad)
+{
+    const char* const here = "ApexVDCHotWireFinder::Init";
+
+    if (config.window < 1 || config.nblocks < 1 || config.nblocks > config.window || nwires < 1) {
+        ostringstream oss;
+        oss << "in <" << here << ">: invalid window of " << config.window << " events in "
+            << config.nblocks << " blocks, for " << nwires << " wires.";
+        throw invalid_argument(oss.str());
+    }
+
+    fConfig      = config;
+    fNWires      = nwires;
+    fBlockEvents = config.window / config.nblocks;
+
+    fBad.assign(nwires, 0);
+    for (int w=0; w<nwires && w<(int)bad.size(); w++) fBad[w] = bad[w];
+
+    Reset();
+}
+
+//______________________________________________________________________________________________________
+void ApexVDCHotWireFinder::Reset()
+{
+    fNEventsBlock = 0;
+    fNBlocksDone  = 0;
+    fOldest       = 0;
+
+    fCurrent.assign(fNWires, 0);
+    fBlocks .assign((size_t)fNWires * fConfig.nblocks, 0);
+    fWindow .assign(fNWires, 0);
+    fHot    .assign(fNWires, 0);
+
+    fNewHot .clear();
+    fNewCold.clear();
+}
+
+//______________________________________________________________________________________________________
+bool ApexVDCHotWireFinder::Fill(const int* wire, size_t n)
+{
+    for (size_t i=0; i<n; i++) fCurrent[wire[i]]++;
+
+    if (++fNEventsBlock < fBlockEvents) return false;
+
+    //this sub-block is full: it replaces the oldest one in the window
+    unsigned int* oldest = fBlocks.data() + (size_t)fOldest * fNWires;
+
+    for (int w=0; w<fNWires; w++) {
+        fWindow[w] += fCurrent[w] - oldest[w];
+        oldest[w]   = fCurrent[w];
+        fCurrent[w] = 0;
+    }
+
+    fOldest = (fOldest + 1) % fConfig.nblocks;
+    fNEventsBlock = 0;
+
+    //only look for hot wires once the window is full
+    if (fNBlocksDone < fConfig.nblocks) fNBlocksDone++;
+    if (fNBlocksDone < fConfig.nblocks) return false;
+
+    Evaluate();
+
+    return !fNewHot.empty() || !fNewCold.empty();
+}
+
+//______________________________________________________________________________________________________
+double ApexVDCHotWireFinder::GetNeighborMean(int wire) const
+{
+    const int lo = max(0,         wire - fConfig.nneighbors);
+    const int hi = min(fNWires-1, wire + fConfig.nneighbors);
+
+    double sum = 0.; int n = 0;
+    for (int w=lo; w<=hi; w++) {
+        if (w == wire || fBad[w]) continue;
+        sum += fWindow[w];
+        n++;
+    }
+    return n > 0 ? sum/n : 0.;
+}
+
+//______________________________________________________________________________________________________
+void ApexVDCHotWireFinder::Evaluate()
+{
+    fNewHot .clear();
+    fNewCold.clear();
+
+    for (int w=0; w<fNWires; w++) {
+
+        if (fBad[w]) continue;
+
+        const double threshold = max( fConfig.factor * GetNeighborMean(w), (double)fConfig.min_hits );
+
+        if (!fHot[w] && fWindow[w] > threshold) {
+            fHot[w] = 1;
+            fNewHot.push_back(w);
+        }
+        else if (fHot[w] && fWindow[w] < 0.5*threshold) {
+            fHot[w] = 0;
+            fNewCold.push_back(w);
+        }
+    }
+}
+//______________________________________________________________________________________________________
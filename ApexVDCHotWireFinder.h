@@ -0,0 +1,92 @@
+#ifndef ApexVDCHotWireFinder_H
+#define ApexVDCHotWireFinder_H
+////////////////////////////////////////////////////////////////////////////////////////
+//
+//  class: ApexVDCHotWireFinder
+//  Online detection of 'hot' (ringing or noisy) wires in one VDC plane.
+//
+//  The number of raw hits on each wire is counted over a sliding window of the last
+//  'window' events. The window is made of 'nblocks' sub-blocks of window/nblocks events:
+//  each sub-block has its own per-wire counts, and when a sub-block is full it is added to
+//  the window sum, and the oldest sub-block is taken out. So, the window moves in steps of
+//  one sub-block, and the cost per event is just the counting of its hits.
+//
+//  Each time the window moves (once it is full), every wire's count is compared to the
+//  mean count of its 'nneighbors' neighbors on either side (not counting wires on the bad
+//  list, which are dead anyway). A wire becomes hot if its count is more than 'factor'
+//  times that mean, and more than 'min_hits'. A hot wire is released once its count falls
+//  below half of that threshold, so that wires near the threshold don't flip every step.
+//
+//  Hits are counted before any masking, so that a hot wire which calms down is noticed.
+//  The finder only reports which wires changed; applying the mask is up to the caller
+//  (see ApexVDCPlane::Decode()).
+//
+//  This does not depend on Podd or ROOT, so that it can be used outside of the analyzer.
+//
+//  - Seth H 28 Sep 25
+////////////////////////////////////////////////////////////////////////////////////////
+
+#include <vector>
+#include <cstddef>
+
+class ApexVDCHotWireFinder {
+
+public:
+    struct Config {
+        int    window     = 10000;  //number of events in the sliding window
+        int    nblocks    = 10;     //number of sub-blocks the window is made of
+        double factor     = 10.;    //a wire is hot if it has more than 'factor' times the hits of its neighbors...
+        int    min_hits   = 50;     //...and more than this many hits in the window
+        int    nneighbors = 4;      //number of neighbors on either side to compare with
+    };
+
+private:
+    Config fConfig;
+
+    int fNWires       = 0;
+    int fBlockEvents  = 1;  //events per sub-block
+    int fNEventsBlock = 0;  //events in the current sub-block so far
+    int fNBlocksDone  = 0;  //number of full sub-blocks so far (up to 'nblocks')
+    int fOldest       = 0;  //index of the oldest sub-block in 'fBlocks'
+
+    std::vector<unsigned int>   fCurrent;   //per-wire counts of the current sub-block
+    std::vector<unsigned int>   fBlocks;    //per-wire counts of the last 'nblocks' full sub-blocks
+    std::vector<unsigned int>   fWindow;    //sum of 'fBlocks'
+    std::vector<unsigned char>  fBad;       //wires on the bad list (not used as neighbors)
+    std::vector<unsigned char>  fHot;       //wires which are hot right now
+
+    std::vector<int> fNewHot;       //wires which became hot in the last Fill()
+    std::vector<int> fNewCold;      //wires which stopped being hot in the last Fill()
+
+    //compare every wire against its neighbors (see above)
+    void Evaluate();
+
+public:
+    ApexVDCHotWireFinder() = default;
+    ~ApexVDCHotWireFinder() = default;
+
+    //set up for 'nwires' wires. 'bad' flags wires on the bad list (may be empty). this forgets all counts.
+    void Init(const Config& config, int nwires, const std::vector<unsigned char>& bad);
+
+    //forget all counts & hot wires
+    void Reset();
+
+    //count the raw hits of one event. returns true if the window moved, and the set of hot wires
+    // changed (see GetNewHot() & GetNewCold()).
+    bool Fill(const int* wire, size_t n);
+
+    const std::vector<int>& GetNewHot()  const { return fNewHot; }
+    const std::vector<int>& GetNewCold() const { return fNewCold; }
+
+    bool IsHot(int wire) const { return fHot[wire]; }
+
+    //number of hits on a wire in the current window
+    unsigned int GetWindowCount(int wire) const { return fWindow[wire]; }
+
+    //mean number of hits on the neighbors of a wire in the current window
+    double GetNeighborMean(int wire) const;
+
+    const Config& GetConfig() const { return fConfig; }
+};
+
+#endif
@@ -1,6 +1,9 @@
 #include "ApexVDCPlane.h"
 #include <Database.h> 
 #include <THaDetMap.h> 
+#include <THaGlobals.h> 
+#include <THaVarList.h> 
+#include <THaVar.h> 
 #include <vector>
 #include <stdexcept> 
 #include <sstream> 
@@ -13,8 +16,8 @@ using namespace std;
 //______________________________________________________________________________________________________
 ApexVDCPlane::ApexVDCPlane(const char* name, const char* description, THaDetectorBase* parent)
     : THaSubDetector(name, description, parent), 
-    fWires{},
-    fHits{}
+    fCalib{},
+    fEvent{}
 {
     //noop 
 }
@@ -28,25 +31,76 @@ ApexVDCPlane::~ApexVDCPlane()
 //______________________________________________________________________________________________________
 int ApexVDCPlane::ReadDataBase(const TDatime& date)
 {
-    // Load VDCPlane parameters from database
+    // Load VDCPlane parameters from database, or from the calibration cache (see ApexVDCCalibCache.h) 
+    // if it has an up-to-date copy of them. 
 
     const char* const here = "ReadDatabase";
 
     FILE* file = OpenFile(date);
     if( !file ) return kFileError;
 
-    // Read fCenter and fSize
-    int err; 
-    if((err = ReadGeometry(file, date)) != 0) {
-        fclose(file);
-        return err;
+    fT0Date = date; 
+
+    // start from the defaults, so that optional keys which are missing get their default values (and not 
+    // the ones from an earlier Init(), which would also end up in the cache) 
+    if (!fHaveDefaultDB) {
+        SaveDB(fDefaultDB); 
+        fHaveDefaultDB = true; 
+    }
+    ApexVDCPlaneDB db = fDefaultDB; 
+
+    // the cache is keyed by the DB file's contents, and the validity timestamp in effect for this run 
+    ApexVDCCalibCache::Key key; 
+    string cache_path; 
+    if (!ApexVDCCalibCache::GetDirectory().empty() && 
+        ApexVDCCalibCache::MakeKey(file, date.GetDate()*1000000LL + date.GetTime(), key)) {
+        
+        cache_path = ApexVDCCalibCache::MakePath(fPrefix ? fPrefix : GetName(), key); 
+    }
+
+    fCalibFromCache = !cache_path.empty() && ApexVDCCalibCache::Read(cache_path, key, db); 
+
+    if (fCalibFromCache) {
+        
+        if (fDebug > 0) Info(Here(here), "parameters loaded from cache '%s'", cache_path.c_str()); 
+    
+    } else {
+
+        int err = ReadTextDB(file, date, db); 
+        if (err != kOK) {
+            fclose(file); 
+            return err; 
+        }
+
+        if (!cache_path.empty() && !ApexVDCCalibCache::Write(cache_path, key, db)) 
+            Warning(Here(here), "could not write calibration cache '%s'", cache_path.c_str()); 
     }
 
-    // Read configuration parameters
-    vector<int> detmap, bad_wirelist;
-    // timing offset for each wire
-    vector<double> tdc_offsets;
-    TString ttd_conv = "AnalyticTTDConv";
+    fclose(file); 
+
+    return ApplyDB(db); 
+}
+
+//______________________________________________________________________________________________________
+int ApexVDCPlane::ReadTextDB(FILE* file, const TDatime& date, ApexVDCPlaneDB& db)
+{
+    // Read all parameters of this plane from the text DB file into 'db' 
+
+    // Read fCalib.center and fCalib.length/width
+    int err; 
+    if((err = ReadGeometry(file, date)) != 0) return err;
+
+    for (int i=0; i<3; i++) db.s.center[i] = fCalib.center[i]; 
+    db.s.length = fCalib.length; 
+    db.s.width  = fCalib.width; 
+
+    TString ttd_conv    = db.ttd_conv.c_str(); 
+    TString description = db.description.c_str(); 
+    TString reftime_var = db.reftime_var.c_str(); 
+    TString t0_output   = db.t0_output.c_str(); 
+    TString stages      = ApexVDCPlaneEvent::GetStageName(db.s.last_stage); 
+
+    vector<int> reftime_chan; 
 
     // The anatomy of a 'DBRequest' struct is as follows (taken from Database/VarDef.h):
     //
@@ -61,68 +115,286 @@ int ApexVDCPlane::ReadDataBase(const TDatime& date)
     //     }; 
     //
     DBRequest request[] = {
-        { "detmap",         &detmap,           kIntV,    0, false},
-        { "nwires",         &fNumWires,        kInt,     0, false, -1 },
-        { "wire.start",     &fFirstWirePos,    kDouble,  0, false, -1 },
-        { "wire.spacing",   &fWireSpacing,     kDouble,  0, false, -1 },
-        { "wire.angle",     &fWireAngle,       kDouble,  0, false, -1 },
-        { "wire.badlist",   &bad_wirelist,     kIntV,    0, true,  -1 },
-        { "tdc.min",        &fTDC_rawtime_min, kInt,     0, true,  -1 },
-        { "tdc.max",        &fTDC_rawtime_max, kInt,     0, true,  -1 },
-        { "tdc.res",        &fTDC_resolution,  kDouble,  0, false, -1 },
-        { "tdc.offsets",    &tdc_offsets,      kDoubleV, 0, false, -1 },
-        { "group.minhits",  &fGroup_hits_min,  kInt,     0, true,  -1 },
-        { "group.minspan",  &fGroup_span_min,  kInt,     0, true,  -1 },
-        { "group.maxspan",  &fGroup_span_max,  kInt,     0, true,  -1 },
-        { "group.maxgap",   &fGroup_max_gap,   kInt,     0, true,  -1 },
-        { "description",    &fTitle,           kTString, 0, true },
+        { "detmap",         &db.detmap,                 kIntV,    0, false},
+        { "nwires",         &db.s.nwires,               kInt,     0, false, -1 },
+        { "wire.start",     &db.s.first_wire_pos,       kDouble,  0, false, -1 },
+        { "wire.spacing",   &db.s.wire_spacing,         kDouble,  0, false, -1 },
+        { "wire.angle",     &db.s.wire_angle,           kDouble,  0, false, -1 },
+        { "wire.badlist",   &db.badlist,                kIntV,    0, true,  -1 },
+        { "tdc.min",        &db.s.tdc_rawtime_min,      kDouble,  0, true,  -1 },
+        { "tdc.max",        &db.s.tdc_rawtime_max,      kDouble,  0, true,  -1 },
+        { "tdc.res",        &db.s.tdc_resolution,       kDouble,  0, false, -1 },
+        { "tdc.offsets",    &db.tdc_offsets,            kDoubleV, 0, false, -1 },
+        { "group.minhits",  &db.s.group_hits_min,       kInt,     0, true,  -1 },
+        { "group.minspan",  &db.s.group_span_min,       kInt,     0, true,  -1 },
+        { "group.maxspan",  &db.s.group_span_max,       kInt,     0, true,  -1 },
+        { "group.maxgap",   &db.s.group_max_gap,        kInt,     0, true,  -1 },
+        { "ttd.conv",       &ttd_conv,                  kTString, 0, true,  -1 },
+        { "ttd.driftvel",   &db.s.ttd_params.drift_vel, kDouble,  0, true,  -1 },
+        { "ttd.tnear",      &db.s.ttd_params.t_near,    kDouble,  0, true,  -1 },
+        { "ttd.cnear",      &db.s.ttd_params.c_near,    kDouble,  0, true,  -1 },
+        { "ttd.dmax",       &db.s.ttd_params.dmax,      kDouble,  0, true,  -1 },
+        { "ttd.tmin",       &db.s.ttd_tmin,             kDouble,  0, true,  -1 },
+        { "ttd.tmax",       &db.s.ttd_tmax,             kDouble,  0, true,  -1 },
+        { "ttd.nbins",      &db.s.ttd_nbins,            kInt,     0, true,  -1 },
+        { "ttd.table",      &db.ttd_table,              kDoubleV, 0, true,  -1 },
+        { "ttd.ngroups",    &db.s.ttd_ngroups,          kInt,     0, true,  -1 },
+        { "fit.sigma",      &db.s.fit_sigma,            kDouble,  0, true,  -1 },
+        { "reftime.chan",   &reftime_chan,              kIntV,    0, true,  -1 },
+        { "reftime.var",    &reftime_var,               kTString, 0, true,  -1 },
+        { "reftime.offset", &db.s.reftime_offset,       kDouble,  0, true,  -1 },
+        { "reftime.min",    &db.s.reftime_min,          kDouble,  0, true,  -1 },
+        { "reftime.max",    &db.s.reftime_max,          kDouble,  0, true,  -1 },
+        { "hot.enable",     &db.s.hot_enable,           kInt,     0, true,  -1 },
+        { "hot.window",     &db.s.hot_config.window,    kInt,     0, true,  -1 },
+        { "hot.nblocks",    &db.s.hot_config.nblocks,   kInt,     0, true,  -1 },
+        { "hot.factor",     &db.s.hot_config.factor,    kDouble,  0, true,  -1 },
+        { "hot.minhits",    &db.s.hot_config.min_hits,  kInt,     0, true,  -1 },
+        { "hot.neighbors",  &db.s.hot_config.nneighbors,kInt,     0, true,  -1 },
+        { "t0.enable",      &db.s.t0_enable,            kInt,     0, true,  -1 },
+        { "t0.rawmin",      &db.s.t0_config.raw_min,    kInt,     0, true,  -1 },
+        { "t0.rawmax",      &db.s.t0_config.raw_max,    kInt,     0, true,  -1 },
+        { "t0.binshift",    &db.s.t0_config.bin_shift,  kInt,     0, true,  -1 },
+        { "t0.minentries",  &db.s.t0_config.min_entries,kInt,     0, true,  -1 },
+        { "t0.maxwidth",    &db.s.t0_config.max_width,  kDouble,  0, true,  -1 },
+        { "t0.output",      &t0_output,                 kTString, 0, true,  -1 },
+        { "stages",         &stages,                    kTString, 0, true,  -1 },
+        { "decode.iterator",&db.s.use_iterator,         kInt,     0, true,  -1 },
+        { "hit.stdsort",    &db.s.use_std_sort,         kInt,     0, true,  -1 },
+        { "hit.reserve",    &db.s.hits_reserve,         kInt,     0, true,  -1 },
+        { "group.reserve",  &db.s.groups_reserve,       kInt,     0, true,  -1 },
+        { "description",    &description,               kTString, 0, true },
         { nullptr }
     };
 
     //try to read the DB variables from our request above. 
-    if((err = LoadDB(file, date, request, fPrefix)) != 0) {
-        fclose(file);
-        return err;
+    if((err = LoadDB(file, date, request, fPrefix)) != 0) return err;
+
+    db.ttd_conv    = ttd_conv.Data(); 
+    db.description = description.Data(); 
+    db.reftime_var = reftime_var.Data(); 
+    db.t0_output   = t0_output.Data(); 
+
+    //the last stage to run in every event is given by name 
+    db.s.last_stage = ApexVDCPlaneEvent::FindStage(stages.Data()); 
+    if (db.s.last_stage < 0) {
+        ostringstream oss; 
+        oss << "in <" << Here("ReadDatabase") << ">: unknown stage '" << stages.Data() << "' in 'stages'. valid "
+               "stages are:"; 
+        for (int i=0; i<ApexVDCPlaneEvent::kNStages; i++) oss << " '" << ApexVDCPlaneEvent::GetStageName(i) << "'"; 
+        throw logic_error(oss.str()); 
     }
 
-    //try to read the geometry from the DB file
-    if ((err = ReadGeometry(file, date)) != 0) {
-        fclose(file); 
-        return err; 
+    //the reference channel is given as 'crate slot channel' 
+    if (!reftime_chan.empty()) {
+        if (reftime_chan.size() != 3) {
+            ostringstream oss; 
+            oss << "in <" << Here("ReadDatabase") << ">: 'reftime.chan' must be 'crate slot channel' "
+                   "(got " << reftime_chan.size() << " numbers)."; 
+            throw logic_error(oss.str()); 
+        }
+        for (int i=0; i<3; i++) db.s.reftime_chan[i] = reftime_chan[i]; 
+    }
+
+    return kOK; 
+}
+
+//______________________________________________________________________________________________________
+void ApexVDCPlane::SaveDB(ApexVDCPlaneDB& db) const
+{
+    // Copy the current parameters of this plane into 'db' (the defaults, unless the DB has been read before) 
+    for (int i=0; i<3; i++) db.s.center[i] = fCalib.center[i]; 
+    db.s.length          = fCalib.length; 
+    db.s.width           = fCalib.width; 
+    db.s.nwires          = fCalib.nwires; 
+    db.s.first_wire_pos  = fCalib.first_wire_pos; 
+    db.s.wire_spacing    = fCalib.wire_spacing; 
+    db.s.wire_angle      = fCalib.wire_angle * TMath::RadToDeg(); 
+    db.s.tdc_resolution  = fCalib.tdc_resolution; 
+    db.s.tdc_rawtime_min = fCalib.tdc_rawtime_min; 
+    db.s.tdc_rawtime_max = fCalib.tdc_rawtime_max; 
+    db.s.group_hits_min  = fCalib.group_hits_min; 
+    db.s.group_span_min  = fCalib.group_span_min; 
+    db.s.group_span_max  = fCalib.group_span_max; 
+    db.s.group_max_gap   = fCalib.group_max_gap; 
+    db.s.fit_sigma       = fCalib.fit_sigma; 
+    db.s.ttd_params      = fCalib.ttd.GetAnalyticParams(); 
+    db.s.ttd_tmin        = fCalib.ttd.GetTimeMin(); 
+    db.s.ttd_tmax        = fCalib.ttd.GetTimeMax(); 
+    db.s.ttd_nbins       = fCalib.ttd.GetNBins(); 
+    db.s.ttd_ngroups     = 1; 
+    for (int i=0; i<3; i++) db.s.reftime_chan[i] = fRefChan[i]; 
+    db.s.reftime_offset  = fRefOffset; 
+    db.s.reftime_min     = fCalib.reftime_min; 
+    db.s.reftime_max     = fCalib.reftime_max; 
+    db.s.hot_enable      = fHotWireEnable; 
+    db.s.hot_config      = fHotWires.GetConfig(); 
+    db.s.t0_enable       = fT0Enable; 
+    db.s.t0_config       = fT0Calib.GetConfig(); 
+    db.s.last_stage      = fStageDB; 
+    db.s.use_std_sort    = fCalib.use_std_sort; 
+    db.s.use_iterator    = fUseIterator; 
+    db.s.hits_reserve    = fHits_reserve; 
+    db.s.groups_reserve  = fGroups_reserve; 
+
+    db.ttd_conv    = "AnalyticTTDConv"; 
+    db.description = fTitle.Data(); 
+    db.reftime_var = fRefVarName.Data(); 
+    db.t0_output   = fT0Output.Data(); 
+}
+
+//______________________________________________________________________________________________________
+int ApexVDCPlane::ApplyDB(const ApexVDCPlaneDB& db)
+{
+    // Set up this plane from the parameters in 'db' (read from either the text DB or the cache) 
+
+    const char* const here = "ReadDatabase";
+
+    for (int i=0; i<3; i++) fCalib.center[i] = db.s.center[i]; 
+    fCalib.length          = db.s.length; 
+    fCalib.width           = db.s.width; 
+    fCalib.nwires          = db.s.nwires; 
+    fCalib.first_wire_pos  = db.s.first_wire_pos; 
+    fCalib.wire_spacing    = db.s.wire_spacing; 
+    fCalib.wire_angle      = db.s.wire_angle; 
+    fCalib.tdc_resolution  = db.s.tdc_resolution; 
+    fCalib.tdc_rawtime_min = db.s.tdc_rawtime_min; 
+    fCalib.tdc_rawtime_max = db.s.tdc_rawtime_max; 
+    fCalib.group_hits_min  = db.s.group_hits_min; 
+    fCalib.group_span_min  = db.s.group_span_min; 
+    fCalib.group_span_max  = db.s.group_span_max; 
+    fCalib.group_max_gap   = db.s.group_max_gap; 
+    fCalib.fit_sigma       = db.s.fit_sigma; 
+    fCalib.reftime_min     = db.s.reftime_min; 
+    fCalib.reftime_max     = db.s.reftime_max; 
+    fCalib.use_std_sort    = db.s.use_std_sort; 
+    fStageDB               = db.s.last_stage; 
+    fHotWireEnable         = db.s.hot_enable; 
+    fT0Enable              = db.s.t0_enable; 
+    fT0Output              = db.t0_output.c_str(); 
+    fUseIterator           = db.s.use_iterator; 
+    fHits_reserve          = db.s.hits_reserve; 
+    fGroups_reserve        = db.s.groups_reserve; 
+    fTitle                 = db.description.c_str(); 
+    fRefOffset             = db.s.reftime_offset; 
+    fRefVarName            = db.reftime_var.c_str(); 
+    for (int i=0; i<3; i++) fRefChan[i] = db.s.reftime_chan[i]; 
+
+    if (fRefChan[0] >= 0 && !fRefVarName.IsNull()) {
+        ostringstream oss; 
+        oss << "in <" << here << ">: both 'reftime.chan' and 'reftime.var' are given; only one reference "
+               "time can be used."; 
+        throw logic_error(oss.str()); 
     }
 
+    const vector<int>&    detmap        = db.detmap; 
+    const vector<int>&    bad_wirelist  = db.badlist; 
+    const vector<double>& tdc_offsets   = db.tdc_offsets; 
+    const vector<double>& ttd_table     = db.ttd_table; 
+    const TString         ttd_conv      = db.ttd_conv.c_str(); 
+
     //try to fill the detmap
     if( FillDetMap(detmap, THaDetMap::kFillLogicalChannel, here) <= 0 ) 
         return kInitError; // Error already printed by FillDetMap
 
     // All our frontend modules are common stop TDCs
     UInt_t nmodules = fDetMap->GetSize();
+
+    fChanWire.clear(); 
+    fModuleChanOffset.assign(nmodules, 0); 
+
     for( UInt_t i = 0; i < nmodules; i++ ) {
         THaDetMap::Module* d = fDetMap->GetModule(i);
         d->MakeTDC();
         d->SetTDCMode(false);
+
+        //check that every logical channel (wire number) of this module is a valid wire, so that we 
+        // don't have to worry about it for every hit. 
+        const int first_wire = d->first; 
+        const int last_wire  = d->first + (int)(d->hi - d->lo); 
+
+        if (first_wire < 0 || last_wire >= fCalib.nwires) {
+            ostringstream oss; 
+            oss << "in <" << here << ">: detector map entry for crate " << d->crate << ", slot " << d->slot 
+                << " maps onto wires [" << first_wire << "," << last_wire << "], but only wires "
+                   "[0," << fCalib.nwires-1 << "] exist."; 
+            throw logic_error(oss.str()); 
+        }
+
+        //the wire number of each channel of this module, for DecodeBulk(). (this is the same mapping 
+        // as THaDetMap's iterator uses for the logical channel) 
+        fModuleChanOffset[i] = fChanWire.size(); 
+        for (UInt_t chan = d->lo; chan <= d->hi; chan++) 
+            fChanWire.push_back( d->reverse ? first_wire + (int)(d->hi - chan) : first_wire + (int)(chan - d->lo) ); 
     }
 
     // Derived geometry quantities
-    fWireAngle *= TMath::DegToRad();
+    fCalib.wire_angle *= TMath::DegToRad();
 
     //check if the number of wires we were told that we have actually matches the nubmer of DB file entries for TDC offsets
-    if (tdc_offsets.size() != (size_t)fNumWires) {
+    if (tdc_offsets.size() != (size_t)fCalib.nwires) {
         ostringstream oss; 
         oss << "in <" << here << ">: number of tdc offsets parsed from DB file " 
-            "(" << tdc_offsets.size() << ") does not match number of wires given (" << fNumWires << ")"; 
+            "(" << tdc_offsets.size() << ") does not match number of wires given (" << fCalib.nwires << ")"; 
         throw logic_error(oss.str()); 
     }
 
-    // Initialize wires
-    // start with the position of first wire
-    double wire_pos = fFirstWirePos; 
+    // Initialize wires (any hit stream replayed so far has to be checked against them again) 
+    fCalib.MakeWires(tdc_offsets); 
+    fReplayStream = nullptr; 
 
-    for (int i=0; i<fNumWires; i++) {
-        ApexVDCWire wire(i, wire_pos, tdc_offsets[i], fTDC_resolution); 
-        fWires.push_back(wire);
-        wire_pos += fWireSpacing; 
+    // Mask the wires on the bad list
+    for (int wire : bad_wirelist) {
+        if (wire < 0 || wire >= fCalib.nwires) {
+            ostringstream oss; 
+            oss << "in <" << here << ">: wire " << wire << " on 'wire.badlist' does not exist (only wires "
+                   "[0," << fCalib.nwires-1 << "] exist)."; 
+            throw logic_error(oss.str()); 
+        }
     }
+    fCalib.MakeWireMask(bad_wirelist); 
+    fNMaskedWires = count(fCalib.wire_ok.begin(), fCalib.wire_ok.end(), 0); 
+
+    // Set up the hot-wire finder. the mask was just rebuilt from the bad list alone, so no wire is 
+    // masked as hot any more 
+    fHotWireList.clear(); 
+    fNHotWires = 0; 
+    if (fHotWireEnable) fHotWires.Init(db.s.hot_config, fCalib.nwires, fCalib.wire_bad); 
+
+    // Set up the t0 histograms (this throws if the histogram range makes no sense) 
+    if (fT0Enable) fT0Calib.Init(db.s.t0_config, fCalib.nwires); 
+
+    // Initialize the time-to-distance conversion. whichever kind is chosen, it ends up as a lookup table, 
+    // so that there is no per-hit dispatch (see ApexVDCTTDConv.h). 
+    if (ttd_conv == "AnalyticTTDConv") {
+        
+        fCalib.ttd.MakeAnalytic(db.s.ttd_params, db.s.ttd_tmin, db.s.ttd_tmax, db.s.ttd_nbins); 
+    
+    } else if (ttd_conv == "TableTTDConv" || ttd_conv == "WireGroupTTDConv") {
+
+        if (ttd_table.size() < 2) {
+            ostringstream oss; 
+            oss << "in <" << here << ">: 'ttd.conv' is '" << ttd_conv.Data() << "', but 'ttd.table' "
+                   "has " << ttd_table.size() << " entries (need at least 2)."; 
+            throw logic_error(oss.str()); 
+        }
+
+        if (ttd_conv == "TableTTDConv") fCalib.ttd.MakeTable(ttd_table, db.s.ttd_tmin, db.s.ttd_tmax); 
+        else fCalib.ttd.MakeWireGroupTables(ttd_table, db.s.ttd_ngroups, fCalib.nwires, db.s.ttd_tmin, db.s.ttd_tmax); 
+
+    } else {
+        ostringstream oss; 
+        oss << "in <" << here << ">: unknown 'ttd.conv' type '" << ttd_conv.Data() << "'. valid types are "
+               "'AnalyticTTDConv', 'TableTTDConv' and 'WireGroupTTDConv'."; 
+        throw logic_error(oss.str()); 
+    }
+
+    //the stages to run in every event 
+    fStage = fStageDB; 
+    for (const auto& consumer : fConsumers) fStage = max(fStage, consumer.second); 
+
+    //pre-allocate space for hits & groups, if we were told how much we need
+    fEvent.Reserve(fHits_reserve, fGroups_reserve, fCalib.nwires); 
 
     return kOK;
 }
@@ -135,9 +407,9 @@ int ApexVDCPlane::ReadGeometry(FILE* file, const TDatime& date)
 
     vector<double> position; 
     DBRequest request[] = {
-        { "position", &position, kDoubleV, 0, false, 0, "detector center position in DET coord sys.[m])" },
-        { "length",   &fLength,  kDouble,  0, false, 0, "detector length (x-direction) [m])" },
-        { "width",    &fWidth,   kDouble,  0, false, 0, "detector width (y-direction) [m])"},
+        { "position", &position,       kDoubleV, 0, false, 0, "detector center position in DET coord sys.[m])" },
+        { "length",   &fCalib.length,  kDouble,  0, false, 0, "detector length (x-direction) [m])" },
+        { "width",    &fCalib.width,   kDouble,  0, false, 0, "detector width (y-direction) [m])"},
         { nullptr }
     };
     int err;
@@ -153,11 +425,100 @@ int ApexVDCPlane::ReadGeometry(FILE* file, const TDatime& date)
     }
 
     //set the center of the detector
-    fCenter.SetXYZ( position[0], position[1], position[2] );
+    for (int i=0; i<3; i++) fCalib.center[i] = position[i];
 
     return kOK; 
 }
 
+//______________________________________________________________________________________________________
+void ApexVDCPlane::Clear(Option_t* opt)
+{
+    //reset all per-event data. this keeps the capacity of all buffers. 
+    THaSubDetector::Clear(opt); 
+
+    fEvent.Clear(); 
+}
+
+//______________________________________________________________________________________________________
+int ApexVDCPlane::Begin(THaRunBase* run)
+{
+    //reset the high-water marks & counters for this run 
+    fNEventsDecoded    = 0; 
+    fMaxHitsPerEvent   = 0; 
+    fMaxGroupsPerEvent = 0; 
+    fNEventsGrouped    = 0; 
+    fFirstEvNum        = 0; 
+    fLastEvNum         = 0; 
+    fNDataWarnings     = 0; 
+
+    fEvent.stats.Clear(); 
+
+    //look up the reference-time variable now, since every detector has defined its variables by now 
+    if (!fRefVarName.IsNull()) {
+        fRefVar = gHaVars ? gHaVars->Find(fRefVarName.Data()) : nullptr; 
+        if (!fRefVar) 
+            Warning(Here("Begin"), "reference-time variable '%s' not found. hit times will not be "
+                                   "relative to a reference time.", fRefVarName.Data()); 
+    }
+
+    //say so if some stages are only run when asked for. the hit & group arrays are read in place (see 
+    // DefineVariables()), so the ones whose stage is not run in every event are empty in the output. 
+    if (fStage < ApexVDCPlaneEvent::kStageOutput) 
+        Warning(Here("Begin"), "running the stages up to '%s' in every event (DB key 'stages' = '%s'): the hit.* & "
+                               "group.* arrays will be empty in every event. set 'stages' to 'fit' if they are in "
+                               "the output.", 
+                               ApexVDCPlaneEvent::GetStageName(fStage), ApexVDCPlaneEvent::GetStageName(fStageDB)); 
+    else if (fStage < ApexVDCPlaneEvent::kStageFit) 
+        Info(Here("Begin"), "running the stages up to '%s' in every event (DB key 'stages' = '%s'); the others "
+                            "only when their results are asked for, so %s empty in the output.", 
+                            ApexVDCPlaneEvent::GetStageName(fStage), ApexVDCPlaneEvent::GetStageName(fStageDB), 
+                            fStage < ApexVDCPlaneEvent::kStageTTD ? "hit.dist & group.pos, .slope, .chi2, .pivot are" 
+                                                                  : "group.pos, .slope, .chi2, .pivot are"); 
+
+    //start each run with empty t0 histograms 
+    if (fT0Enable) fT0Calib.Reset(); 
+
+    //start each run with only the bad list masked
+    if (fHotWireEnable) {
+        fHotWires.Reset(); 
+        for (int wire : fHotWireList) fCalib.wire_ok[wire] = !fCalib.wire_bad[wire]; 
+        fHotWireList.clear(); 
+        fNHotWires    = 0; 
+        fNMaskedWires = count(fCalib.wire_ok.begin(), fCalib.wire_ok.end(), 0); 
+    }
+
+    return THaSubDetector::Begin(run); 
+}
+
+//______________________________________________________________________________________________________
+int ApexVDCPlane::End(THaRunBase* run)
+{
+    //report the high-water marks for this run. If the buffers are pre-sized (with the DB keys 
+    // 'hit.reserve' and 'group.reserve') to at least these numbers, decoding never allocates. 
+    const char* const here = "End"; 
+
+    //the hits may not have been grouped in any event (see the DB key 'stages') 
+    const string max_groups = fNEventsGrouped > 0 ? to_string(fMaxGroupsPerEvent) : "not measured"; 
+
+    Info(Here(here), "%u events decoded. max hits/event = %u (hit.reserve = %i), "
+                     "max groups/event = %s (group.reserve = %i)", 
+                     fNEventsDecoded, 
+                     fMaxHitsPerEvent,   fHits_reserve, 
+                     max_groups.c_str(), fGroups_reserve ); 
+
+    //timing & rate counters (see ApexVDCPlaneStats.h) 
+    if (ApexVDCPlaneStats::IsEnabled()) 
+        Info(Here(here), "decoding statistics:\n%s", fEvent.stats.Summary().c_str()); 
+
+    if (fT0Enable) FitT0Calib(); 
+
+    CloseHitStream(); 
+
+    if (!ApexVDCShard::GetDirectory().empty()) WriteShardReport(); 
+
+    return THaSubDetector::End(run); 
+}
+
 //______________________________________________________________________________________________________
 int ApexVDCPlane::DefineVariables(EMode mode)
 {
@@ -169,127 +530,459 @@ int ApexVDCPlane::DefineVariables(EMode mode)
     //    const char*      def;      // Definition of data (data member or method name)
     // };
     //
+    // The hit & group arrays are registered as data members (rather than methods returning a 
+    // std::vector by value), so that the output system reads them in place each event. 
+    //
+    // The variables defined by a method ('nhits' & 'ngroups') run the stages they need when they are 
+    // read, but the ones read in place are only filled if Decode() runs their stage in every event. Podd 
+    // can't tell us which variables the output actually uses, so the DB key 'stages' says how far that 
+    // is (the default, 'fit', is everything): 
+    //
+    //      'convert'   nhits 
+    //      'group'     ngroups 
+    //      'output'    hit.rawtime, hit.time_gbl, hit.wire, hit.pos, group.nhits, .start, .end, .span 
+    //      'ttd'       hit.dist 
+    //      'fit'       group.pos, group.slope, group.chi2, group.pivot 
+    //
+    // (nhot, nmasked, hot.wire, reftime & reftime.ok are filled before any of the stages.) 
+    //
     RVarDef vars[] = {
         {"nhits",           "Number of (raw) hits in this plane for this event",    "GetNHits()"},
-        {"hit.rawtime",     "Array of raw times for each hit",                      "GetHits_rawtime()"},
-        {"hit.time_gbl",    "offset-corrected 'real time' [s], but NOT relative to the event's selected S2 hit.", "GetHits_time()"},
-        {"hit.wire",        "VDC wire ID of this hit",                              "GetHits_wire()"},
-        {"hit.pos",         "position of this hit's wire [m]. given in UV-coords, rel. to central wire in plane.", "GetHits_pos()"},
         {"ngroups",         "Number of hit-groups formed in this plane",            "GetNGroups()"},
-        {"group.nhits",     "Number of hits in this group",                         "GetGroups_nhits()"},
-        {"group.start",     "Hit index of first hit in group",                      "GetGroups_start()"},
-        {"group.end",       "Hit index of last hit in group",                       "GetGroups_end()"},
-        {"group.span",      "number of wires between first and last hit + 1 (see above def.)",  "GetGroups_span()"},
+        {"nhot",            "Number of wires masked as hot right now",              "GetNHotWires()"},
+        {"nmasked",         "Number of wires masked right now (bad list & hot)",    "GetNMaskedWires()"},
+        {nullptr}
+    }; 
+
+    int err = DefineVarsFromList(vars, mode); 
+    if (err != kOK) return err; 
+
+    // The hit & group columns live in 'fEvent', not in this class itself, so they are registered by
+    // address with a 'VarDef' (taken from VarDef.h): 
+    //
+    // struct VarDef {
+    //    const char*      name;     // Variable name
+    //    const char*      desc;     // Variable description
+    //    VarType          type;     // Variable data type (see VarType.h)
+    //    UInt_t           size;     // Size of array (0/1 = scalar)
+    //    const void*      loc;      // Location of data
+    //    const Int_t*     count;    // Optional: Actual size of variable size array
+    // };
+    //
+    VarDef columns[] = {
+        {"hit.rawtime",     "Array of raw times for each hit",                      kDoubleV, 0, &fEvent.hit_rawtime},
+        {"hit.time_gbl",    "offset-corrected 'real time' [s], relative to the event's reference time if it has one (see reftime.ok)", kDoubleV, 0, &fEvent.hit_time},
+        {"hit.wire",        "VDC wire ID of this hit",                              kIntV,    0, &fEvent.hit_wire},
+        {"hit.pos",         "position of this hit's wire [m]. given in UV-coords, rel. to central wire in plane.", kDoubleV, 0, &fEvent.hit_pos},
+        {"hit.dist",        "drift distance of this hit [m], from the time-to-distance conversion.", kDoubleV, 0, &fEvent.hit_dist},
+        {"group.nhits",     "Number of hits in this group",                         kIntV,    0, &fEvent.group_nhits},
+        {"group.start",     "Hit index of first hit in group",                      kIntV,    0, &fEvent.group_start},
+        {"group.end",       "Hit index of last hit in group",                       kIntV,    0, &fEvent.group_end},
+        {"group.span",      "number of wires between first and last hit + 1 (see above def.)",  kIntV, 0, &fEvent.group_span},
+        {"group.pos",       "fitted crossing position of this group [m]",           kDoubleV, 0, &fEvent.group_pos},
+        {"group.slope",     "fitted slope of this group (drift distance / wire position)", kDoubleV, 0, &fEvent.group_slope},
+        {"group.chi2",      "chi2 of the fit of this group (-1 if the fit failed)",  kDoubleV, 0, &fEvent.group_chi2},
+        {"group.pivot",     "wire of the hit closest to the track in this group",   kIntV,    0, &fEvent.group_pivot},
+        {"hot.wire",        "wires masked as hot right now",                        kIntV,    0, &fHotWireList},
+        {"reftime",         "reference time of this event [s] (0 if none)",         kDouble,  0, &fEvent.reftime},
+        {"reftime.ok",      "1 if this event has a reference time",                 kInt,     0, &fEvent.has_reftime},
         {nullptr}
     }; 
 
-    return DefineVarsFromList(vars, mode); 
+    err = DefineVarsFromList(columns, mode); 
+    if (err != kOK || !ApexVDCPlaneStats::IsEnabled()) return err; 
+
+    //timing & rate counters, summed over all events of this run so far (see ApexVDCPlaneStats.h). 
+    // these only exist if the library was built with instrumentation. 
+    const ApexVDCPlaneStats& stats = fEvent.stats; 
+    
+    VarDef statvars[] = {
+        {"stats.nevents",       "Events decoded (this run)",                            kULong,  0, &stats.nevents},
+        {"stats.nwarnings",     "Events with missing data (this run)",                  kULong,  0, &stats.nevents_with_warnings},
+        {"stats.nraw",          "Raw hits stored (this run)",                           kULong,  0, &stats.nhits_raw},
+        {"stats.naccepted",     "Hits which passed the TDC window (this run)",          kULong,  0, &stats.nhits_accepted},
+        {"stats.nrejected_tdc", "Hits rejected by the TDC window (this run)",           kULong,  0, &stats.nhits_rejected_tdc},
+        {"stats.nrejected_time","Hits rejected by the reference-time window (this run)", kULong, 0, &stats.nhits_rejected_time},
+        {"stats.nnoreftime",    "Events without a reference time (this run)",           kULong,  0, &stats.nevents_no_reftime},
+        {"stats.nmasked",       "Hits on masked wires (this run)",                      kULong,  0, &stats.nhits_masked},
+        {"stats.nbad_channel",  "Hits on invalid logical channels (this run)",          kULong,  0, &stats.nhits_bad_channel},
+        {"stats.nmissing",      "Hits with missing data (this run)",                    kULong,  0, &stats.nhits_missing_data},
+        {"stats.ngroups",       "Groups found (this run)",                              kULong,  0, &stats.ngroups},
+        {"stats.t_decode",      "Time spent in Decode() [ns] (this run)",               kDouble, 0, &stats.time_decode},
+        {"stats.t_convert",     "Time spent converting hits [ns] (this run)",           kDouble, 0, &stats.time_convert},
+        {"stats.t_sort",        "Time spent ordering hits [ns] (this run)",             kDouble, 0, &stats.time_sort},
+        {"stats.t_group",       "Time spent finding groups [ns] (this run)",            kDouble, 0, &stats.time_group},
+        {"stats.t_output",      "Time spent filling output [ns] (this run)",            kDouble, 0, &stats.time_output},
+        {"stats.t_ttd",         "Time spent converting time to distance [ns] (this run)", kDouble, 0, &stats.time_ttd},
+        {"stats.t_fit",         "Time spent fitting groups [ns] (this run)",            kDouble, 0, &stats.time_fit},
+        {"stats.hits_hist",     "Histogram of hits/event (this run)",                   kULong,  ApexVDCPlaneStats::kNHistBins, stats.hits_hist},
+        {nullptr}
+    }; 
+
+    return DefineVarsFromList(statvars, mode); 
+}
+
+//______________________________________________________________________________________________________
+int ApexVDCPlane::StoreHit(const DigitizerHitInfo_t& hit_info, UInt_t data)
+{
+    //according to THaDetMap.h, 'DigitizerHitInfo_t', which is just an 
+    // alias for 'THaDetMap::Iterator::HitInfo_t', has the following public data members:
+    //
+    // ...  
+    //  Decoder::Module*     module; // Current frontend module being decoded
+    //  Decoder::ChannelType type;   // Measurement type for current channel (ADC/TDC)
+    //  Decoder::ChannelType modtype; // Module type (ADC/TDC/MultiFunctionADC etc.)
+    //  UInt_t  ev;      // Event number (for error messages)
+    //  UInt_t  crate;   // Hardware crate
+    //  UInt_t  slot;    // Hardware slot
+    //  UInt_t  chan;    // Physical channel in current module
+    //  UInt_t  nhit;    // Number of hits in current channel
+    //  UInt_t  hit;     // Hit number in current channel
+    //  Int_t   lchan;   // Logical channel according to detector map
+    // ... 
+    // 
+    //the logical channel is the wire number. the hit is checked & stored by 'fEvent', and converted 
+    // (along with all other hits of this event) once all hits have been stored. see Decode(). 
+    return fEvent.StoreHit(fCalib, hit_info.lchan, data); 
+}
+
+//______________________________________________________________________________________________________
+int ApexVDCPlane::Decode(const THaEvData& event_data)
+{
+    //check to see if this is a physics event
+    if (!event_data.IsPhysicsTrigger()) return -1; 
+
+    //reset the data from the last event, in case our parent detector has not already done so
+    Clear(); 
+
+    APEXVDC_TIMER(timer, fEvent.stats.time_decode); 
+
+    //gather all raw hits
+    if (fUseIterator) DecodeIterator(event_data); 
+    else              DecodeBulk(event_data); 
+
+    //get the reference time of this event, so that the times of all hits are relative to it 
+    ReadRefTime(event_data); 
+
+    //count the raw TDC values on each wire (relative to the reference time), for the t0 calibration 
+    if (fT0Enable) fT0Calib.Fill(fEvent, fCalib.tdc_resolution); 
+
+    //count the raw hits on each wire (before any masking), and update the mask if the hot wires changed. 
+    if (fHotWireEnable && fHotWires.Fill(fEvent.raw_wire.data(), fEvent.raw_wire.size())) UpdateHotWires(); 
+
+    //now, run the stages which are needed in every event (convert & sort the hits, form them into groups 
+    // & fill the output variables, ...). any later ones are only run if something asks for them. 
+    fEvent.Process(fCalib, fStage); 
+
+    //(this can only fail if the calibration changed since the stream was opened. then, the stream is 
+    // given up on, rather than the decoding.) 
+    if (fHitStream.IsOpen()) {
+        EnsureStage(ApexVDCPlaneEvent::kStageOrder); 
+        try { 
+            fHitStream.Write(event_data.GetEvNum(), fEvent); 
+        } catch (const exception& e) {
+            Error(Here("Decode"), "%s. no more events are written to the hit stream.", e.what()); 
+            CloseHitStream(); 
+        }
+    }
+
+    //update the high-water marks (with the number of raw hits, if they were not even converted) 
+    const UInt_t nhits = fEvent.stage >= ApexVDCPlaneEvent::kStageConvert ? fEvent.hits.size() : fEvent.raw_wire.size(); 
+
+    if (fNEventsDecoded == 0) fFirstEvNum = event_data.GetEvNum(); 
+    fLastEvNum = event_data.GetEvNum(); 
+
+    fNEventsDecoded++; 
+    fMaxHitsPerEvent   = std::max<UInt_t>( fMaxHitsPerEvent,   nhits ); 
+
+    //the groups are only known if the hits were grouped 
+    if (fEvent.stage >= ApexVDCPlaneEvent::kStageGroup) {
+        fNEventsGrouped++; 
+        fMaxGroupsPerEvent = std::max<UInt_t>( fMaxGroupsPerEvent, fEvent.groups.size() ); 
+    }
+
+    return nhits; 
 }
 
 //______________________________________________________________________________________________________
-vector<double> ApexVDCPlane::GetHits_rawtime() const noexcept
+void ApexVDCPlane::ReadRefTime(const THaEvData& event_data)
 {
-    vector<double> ret; ret.reserve(fHits.size()); 
-    for (const auto& hit : fHits) ret.emplace_back(hit.rawtime);
-    return ret;  
+    // Set the reference time of this event, from the reference TDC channel or the reference-time variable. 
+    // if there is no reference time in this event, the hit times are left as they are, and no window is 
+    // applied around it. 
+    if (!HasRefTimeSource()) return; 
+
+    if (fRefChan[0] >= 0) {
+
+        const UInt_t crate = fRefChan[0], slot = fRefChan[1], chan = fRefChan[2]; 
+
+        //the first hit is the one which stopped the TDC 
+        if (event_data.GetNumHits(crate, slot, chan) > 0) 
+            fEvent.SetRefTime( fRefOffset - fCalib.tdc_resolution * event_data.GetData(crate, slot, chan, 0) ); 
+
+    } else if (fRefVar) {
+
+        //(kBig means that the detector which fills it had no good hit in this event) 
+        const double time = fRefVar->GetValue(); 
+        if (time < kBig) fEvent.SetRefTime(time); 
+    }
+
+    if (!fEvent.has_reftime) APEXVDC_COUNT( fEvent.stats.nevents_no_reftime++ ); 
 }
+
 //______________________________________________________________________________________________________
-vector<double> ApexVDCPlane::GetHits_time() const noexcept
+void ApexVDCPlane::RegisterConsumer(const char* name, int stage)
 {
-    vector<double> ret; ret.reserve(fHits.size()); 
-    for (const auto& hit : fHits) ret.emplace_back(hit.realtime);
-    return ret;  
+    const char* const here = "RegisterConsumer"; 
+
+    if (stage < 0 || stage >= ApexVDCPlaneEvent::kNStages) {
+        ostringstream oss; 
+        oss << "in <" << Here(here) << ">: '" << (name ? name : "") << "' asked for stage " << stage << ", "
+               "which does not exist."; 
+        throw invalid_argument(oss.str()); 
+    }
+
+    //a consumer which registers again (e.g. each time its detector is initialized) replaces its earlier entry 
+    const string consumer = name ? name : ""; 
+
+    auto it = find_if(fConsumers.begin(), fConsumers.end(), 
+                      [&](const pair<string, int>& c) { return c.first == consumer; }); 
+
+    if (it != fConsumers.end()) it->second = stage; 
+    else                        fConsumers.emplace_back(consumer, stage); 
+
+    fStage = fStageDB; 
+    for (const auto& c : fConsumers) fStage = max(fStage, c.second); 
+
+    if (fDebug > 0) Info(Here(here), "'%s' uses the stages up to '%s'", name, ApexVDCPlaneEvent::GetStageName(stage)); 
 }
+
 //______________________________________________________________________________________________________
-vector<int> ApexVDCPlane::GetHits_wire() const noexcept
+void ApexVDCPlane::FitT0Calib()
 {
-    vector<int> ret; ret.reserve(fHits.size()); 
-    for (const auto& hit : fHits) ret.emplace_back(hit.wire->GetNum());
-    return ret;  
+    // Find the leading edge of each wire's TDC spectrum from this run, and write the new offsets (and the 
+    // quality of each wire's fit) as a DB block, which can be pasted into this plane's DB file as it is. 
+    // wires which could not be fit keep the offset they have now. 
+    const char* const here = "FitT0Calib"; 
+
+    vector<double> offsets = fCalib.tdc_offsets; 
+    vector<int>    quality; 
+    const int ngood = fT0Calib.Fit(fCalib.tdc_resolution, fCalib.wire_bad, offsets, quality); 
+
+    const TString path = fT0Output.IsNull() ? TString(fPrefix ? fPrefix : GetName()) + "t0.db" : fT0Output; 
+
+    FILE* file = fopen(path.Data(), "w"); 
+    if (!file) {
+        Warning(Here(here), "can't open '%s' for writing. the t0 calibration is lost.", path.Data()); 
+        return; 
+    }
+    ApexVDCT0Calib::WriteDB(file, fPrefix ? fPrefix : "", fT0Date.AsSQLString(), offsets, quality); 
+    fclose(file); 
+
+    Info(Here(here), "%d of %d wires fit; offsets written to '%s'", ngood, fCalib.nwires, path.Data()); 
 }
+
 //______________________________________________________________________________________________________
-vector<double> ApexVDCPlane::GetHits_pos() const noexcept
+void ApexVDCPlane::OpenHitStream(const char* path)
 {
-    vector<double> ret; ret.reserve(fHits.size()); 
-    for (const auto& hit : fHits) ret.emplace_back(hit.wire->GetPos());
-    return ret;  
+    const char* const here = "OpenHitStream"; 
+
+    fHitStream.Open(path, fCalib); 
+
+    Info(Here(here), "writing decoded hits to '%s'", path); 
 }
+
 //______________________________________________________________________________________________________
-vector<int> ApexVDCPlane::GetGroups_start() const noexcept
+void ApexVDCPlane::WriteShardReport() const
 {
-    vector<int> ret; ret.reserve(fHits.size()); 
-    for (const auto& group : fGroups) ret.emplace_back(group.front().wire->GetNum());
-    return ret;  
+    // Write what this plane decoded in this run to the directory of this shard, so that the counters of all 
+    // shards can be checked against the plan, and added up (see ApexVDCShard::MergeReports()). 
+    const char* const here = "WriteShardReport"; 
+
+    ApexVDCShardReport report; 
+    report.plane           = fPrefix ? fPrefix : GetName(); 
+    report.nevents_decoded = fNEventsDecoded; 
+    report.first_evnum     = fFirstEvNum; 
+    report.last_evnum      = fLastEvNum; 
+    report.max_hits        = fMaxHitsPerEvent; 
+    report.max_groups      = fMaxGroupsPerEvent; 
+    report.nevents_grouped = fNEventsGrouped; 
+    report.stats           = fEvent.stats; 
+
+    const string path = ApexVDCShard::MakeReportPath(ApexVDCShard::GetDirectory(), report.plane); 
+
+    try { 
+        report.Write(path); 
+    } catch (const exception& e) {
+        Error(Here(here), "%s", e.what()); 
+        return; 
+    }
+
+    Info(Here(here), "shard report written to '%s'", path.c_str()); 
 }
+
 //______________________________________________________________________________________________________
-vector<int> ApexVDCPlane::GetGroups_end() const noexcept
+void ApexVDCPlane::CloseHitStream()
 {
-    vector<int> ret; ret.reserve(fHits.size()); 
-    for (const auto& group : fGroups) ret.emplace_back(group.back().wire->GetNum());
-    return ret;  
+    const char* const here = "CloseHitStream"; 
+
+    if (!fHitStream.IsOpen()) return; 
+
+    const uint64_t nevents = fHitStream.GetNEvents(); 
+
+    try { 
+        fHitStream.Close(); 
+    } catch (const exception& e) {
+        Error(Here(here), "%s", e.what()); 
+        return; 
+    }
+
+    Info(Here(here), "%llu events written to the hit stream", (unsigned long long)nevents); 
 }
+
 //______________________________________________________________________________________________________
-vector<int> ApexVDCPlane::GetGroups_span() const noexcept
+int ApexVDCPlane::ReplayHits(const ApexVDCHitStreamReader& stream, uint64_t i)
 {
-    vector<int> ret; ret.reserve(fHits.size()); 
-    for (const auto& group : fGroups) ret.emplace_back(group.front().wire->GetNum() - group.back().wire->GetNum());
-    return ret;  
+    const char* const here = "ReplayHits"; 
+
+    //the hits are converted with this plane's calibration, so it must be the one they were written with. 
+    // (otherwise, the times & groups would silently differ from the original ones) 
+    if (&stream != fReplayStream || stream.GetCalibHash() != fReplayStreamHash) {
+
+        if (!stream.MatchesCalib(fCalib)) {
+            ostringstream oss; 
+            oss << "in <" << Here(here) << ">: the hit stream was written with a different TDC calibration (or "
+                   "number of wires: " << stream.GetNWires() << " vs. " << fCalib.nwires << ") than this plane has."; 
+            throw runtime_error(oss.str()); 
+        }
+        fReplayStream     = &stream; 
+        fReplayStreamHash = stream.GetCalibHash(); 
+    }
+
+    Clear(); 
+
+    //the hits come back in the order they were written (sorted), so only the steps after sorting are left 
+    stream.Read(i, fCalib, fEvent); 
+    fEvent.ProcessSorted(fCalib, fStage); 
+
+    //update the high-water marks (& the event range, as Decode() does) 
+    const UInt_t evnum = stream.GetEventNumber(i); 
+    if (fNEventsDecoded == 0) fFirstEvNum = evnum; 
+    fLastEvNum = evnum; 
+
+    fNEventsDecoded++; 
+    fMaxHitsPerEvent   = std::max<UInt_t>( fMaxHitsPerEvent,   fEvent.hits.size() ); 
+
+    if (fEvent.stage >= ApexVDCPlaneEvent::kStageGroup) {
+        fNEventsGrouped++; 
+        fMaxGroupsPerEvent = std::max<UInt_t>( fMaxGroupsPerEvent, fEvent.groups.size() ); 
+    }
+
+    return fEvent.hits.size(); 
 }
+
 //______________________________________________________________________________________________________
-int ApexVDCPlane::StoreHit(const DigitizerHitInfo_t& hit_info, UInt_t data)
+void ApexVDCPlane::UpdateHotWires()
 {
-    //according to THaDetMap.h, 'DigitizerHitInfo_t', which is just an 
-    // alias for 'THaDetMap::Iterator::HitInfo_t', has the following public data members:
-    //
-    // ...  
-    //  Decoder::Module*     module; // Current frontend module being decoded
-    //  Decoder::ChannelType type;   // Measurement type for current channel (ADC/TDC)
-    //  Decoder::ChannelType modtype; // Module type (ADC/TDC/MultiFunctionADC etc.)
-    //  UInt_t  ev;      // Event number (for error messages)
-    //  UInt_t  crate;   // Hardware crate
-    //  UInt_t  slot;    // Hardware slot
-    //  UInt_t  chan;    // Physical channel in current module
-    //  UInt_t  nhit;    // Number of hits in current channel
-    //  UInt_t  hit;     // Hit number in current channel
-    //  Int_t   lchan;   // Logical channel according to detector map
-    // ... 
-    // 
-    const char* const here = "StoreHit"; 
+    //mask the wires which just became hot, and unmask the ones which calmed down 
+    const char* const here = "UpdateHotWires"; 
 
-    int wire_num = hit_info.lchan; 
-    //check if this logical channel number is invalid or not
-    if (wire_num < 0 || (size_t)wire_num >= fWires.size()) {
-        ostringstream oss;
-        oss <<  "in <" << here << ">: wire number of hit is invalid (" << wire_num << ") must be"
-                " in the range [0," << fWires.size()-1 << "]."; 
-        throw logic_error(oss.str()); 
-        return -1;  
+    for (int wire : fHotWires.GetNewHot()) {
+        
+        fCalib.wire_ok[wire] = 0; 
+        fHotWireList.push_back(wire); 
+
+        Info(Here(here), "event %u: masking hot wire %i (%u hits in window, neighbors %.1f)", 
+                         fNEventsDecoded, wire, fHotWires.GetWindowCount(wire), fHotWires.GetNeighborMean(wire)); 
+    }
+
+    for (int wire : fHotWires.GetNewCold()) {
+        
+        fCalib.wire_ok[wire] = !fCalib.wire_bad[wire]; 
+        fHotWireList.erase( remove(fHotWireList.begin(), fHotWireList.end(), wire), fHotWireList.end() ); 
+
+        Info(Here(here), "event %u: unmasking wire %i (%u hits in window, neighbors %.1f)", 
+                         fNEventsDecoded, wire, fHotWires.GetWindowCount(wire), fHotWires.GetNeighborMean(wire)); 
     }
 
-    //convert the data to a double 
-    double rawtime = static_cast<double>(data); 
+    sort(fHotWireList.begin(), fHotWireList.end()); 
+
+    fNHotWires    = fHotWireList.size(); 
+    fNMaskedWires = count(fCalib.wire_ok.begin(), fCalib.wire_ok.end(), 0); 
+}
+
+//______________________________________________________________________________________________________
+int ApexVDCPlane::DecodeBulk(const THaEvData& event_data)
+{
+    //for each module, walk only the channels which have data, and read all hits of each channel. 
+    // the wire of each channel comes from the table built in ReadDataBase(), which only contains valid 
+    // wires, so no hit is checked on its own. a module the decoder doesn't know, or a hit whose data 
+    // can't be read, is counted & warned about like in DecodeIterator(). 
+    const char* const here = "Decode"; 
+
+    const UInt_t nmodules = fDetMap->GetSize(); 
+
+    bool has_warning = false; 
+
+    for (UInt_t i=0; i<nmodules; i++) {
 
-    //check to see if this hit is outside of our TDC cutoff range 
-    if (rawtime > fTDC_rawtime_max || rawtime < fTDC_rawtime_min) return 0; 
+        const THaDetMap::Module* d = fDetMap->GetModule(i); 
+
+        //a module in the detector map which isn't in the crate map has no data at all 
+        if (!event_data.GetModule(d->crate, d->slot)) {
+            if (fNDataWarnings++ < kMaxDataWarnings) 
+                Warning(Here(here), "event %u: crate %u slot %u (detector map module %u) is not in the crate map, "
+                                    "so it has no data%s", event_data.GetEvNum(), d->crate, d->slot, i, 
+                                    fNDataWarnings == kMaxDataWarnings ? ". no more such warnings this run." : ""); 
+            has_warning = true; 
+            continue; 
+        }
 
-    //grab our wire so we can get some info from it 
-    const ApexVDCWire* wire = &fWires[wire_num]; 
+        const int* chan_wire = fChanWire.data() + fModuleChanOffset[i]; 
 
-    //now, compute the real-time
-    double realtime =  wire->GetTimingOffset() - (fTDC_resolution*((double)rawtime)); 
+        const UInt_t nchan = event_data.GetNumChan(d->crate, d->slot); 
 
-    //add this hit to the list of all hits
-    fHits.push_back({wire, realtime, rawtime}); 
+        for (UInt_t j=0; j<nchan; j++) {
 
-    return 0; 
+            const UInt_t chan = event_data.GetNextChan(d->crate, d->slot, j); 
+
+            //this module may have channels which don't belong to this plane
+            if (chan < d->lo || chan > d->hi) continue; 
+
+            const int    wire  = chan_wire[chan - d->lo]; 
+            const UInt_t nhits = event_data.GetNumHits(d->crate, d->slot, chan); 
+
+            for (UInt_t hit=0; hit<nhits; hit++) {
+
+                const UInt_t data = event_data.GetData(d->crate, d->slot, chan, hit); 
+
+                //GetData() returns kMaxUInt if the hit can't be read 
+                if (data == kMaxUInt) {
+                    if (fNDataWarnings++ < kMaxDataWarnings) 
+                        Warning(Here(here), "event %u: crate %u slot %u chan %u (wire %i): failed to load data for "
+                                            "hit %u of %u%s", event_data.GetEvNum(), d->crate, d->slot, chan, wire, 
+                                            hit, nhits, 
+                                            fNDataWarnings == kMaxDataWarnings ? ". no more such warnings this run." : ""); 
+                    has_warning = true; 
+                    APEXVDC_COUNT( fEvent.stats.nhits_missing_data++ ); 
+                    continue; 
+                }
+                fEvent.StoreRawHit( wire, data ); 
+            }
+        }
+    }
+
+    if (has_warning) {
+        fNEventsWithWarnings++; 
+        APEXVDC_COUNT( fEvent.stats.nevents_with_warnings++ ); 
+    }
+
+    return fEvent.raw_data.size(); 
 }
 
 //______________________________________________________________________________________________________
-int ApexVDCPlane::Decode(const THaEvData& event_data)
+int ApexVDCPlane::DecodeIterator(const THaEvData& event_data)
 {
-    //check to see if this is a physics event
-    if (!event_data.IsPhysicsTrigger()) return -1; 
-    
     const char* const here = "Decode"; 
 
     //iterate thru all hits
@@ -314,18 +1007,18 @@ int ApexVDCPlane::Decode(const THaEvData& event_data)
             //if the data is missing, show a warning 
             DataLoadWarning(hit_info, here); 
             has_warning = true; 
+            APEXVDC_COUNT( fEvent.stats.nhits_missing_data++ ); 
         }   
         //iterate to next hit
         ++it; 
     }
 
-    if (has_warning) fNEventsWithWarnings++; 
-    
-    //now, sort all hits in ascending order of wire number, and in ascending order of realtime for
-    // hits on the same wire. 
-    std::sort( fHits.begin(), fHits.end() ); 
+    if (has_warning) {
+        fNEventsWithWarnings++; 
+        APEXVDC_COUNT( fEvent.stats.nevents_with_warnings++ ); 
+    }
 
-    return fHits.size(); 
+    return fEvent.raw_data.size(); 
 }
 //______________________________________________________________________________________________________
 //______________________________________________________________________________________________________
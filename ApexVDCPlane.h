@@ -12,41 +12,136 @@
 #include <THaSubDetector.h> 
 #include <THaDetectorBase.h>
 #include <TDatime.h>  
-#include <TVector3.h> 
 #include <THaDetMap.h> 
 #include "ApexVDCHit.h"
 #include "ApexVDCWire.h"
 #include "ApexVDCHitGroup.h"
+#include "ApexVDCPlaneCalib.h"
+#include "ApexVDCPlaneEvent.h"
+#include "ApexVDCHotWireFinder.h"
+#include "ApexVDCCalibCache.h"
+#include "ApexVDCHitStream.h"
+#include "ApexVDCT0Calib.h"
+#include "ApexVDCShard.h"
+#include <vector>
+#include <string>
+#include <utility>
 
 class THaEvData; 
+class THaRunBase; 
+class THaVar; 
 
 class ApexVDCPlane : public THaSubDetector {
 
 private: 
 
-    //  These are the default parameters for a lot of values. 
-    //      If you would like to change them without having to hard-code them here, see how they can 
-    //      be manually speficied a DB file in the ApexVDCPlane::ReadDatabase() function. 
+    //  The calibration for this plane is read from the DB by ApexVDCPlane::ReadDatabase(), and never 
+    //  changes while decoding. see ApexVDCPlaneCalib.h for the default values of each parameter. 
     //
-    double fTDC_resolution  = 0.5e-9;  //by default, half a nanosecond. 
-    double fTDC_rawtime_max = 2200.;   //maximum & minimum raw TDC times for each wire
-    double fTDC_rawtime_min = 0.; 
-
-    //information about the geometry of the detector
-    TVector3 fCenter;       //center of the detector, displaced from the origin of the DET coordinate system [m]. 
-    double fLength, fWidth; //length (x-dir) and width (y-dir) of the detector [m]
-    int fNumWires = 368; 
-    //position of the first wire from the center of the detector [m], along with wire spacing [m]. 
-    double fFirstWirePos, fWireSpacing, fWireAngle; 
-
-    int fGroup_span_min = 2;      //for hit 'groups', the min and max span
-    int fGroup_span_max = 10;     
-    int fGroup_hits_min = 2;      //minimum number of hits for one group 
-    int fGroup_max_gap  = 3;      //largest allowable 'gap' between hits in a group 
-
-    std::vector<ApexVDCWire>        fWires; //list of all wires 
-    std::vector<ApexVDCHit>         fHits;  //list of all hits (for a single event)
-    std::vector<ApexVDCHitGroup>    fGroups; //list of all hit 'groups'  
+    ApexVDCPlaneCalib   fCalib; 
+
+    //  All per-event data (hits, groups, output columns) lives here. When decoding in the analyzer, 
+    //  this plane uses its own 'fEvent'. For event-parallel decoding, each thread can instead use its 
+    //  own ApexVDCPlaneEvent against this plane's 'fCalib' (see ApexVDCReplayMT.h). 
+    //
+    //  Decode() only runs the stages up to 'fStage' (see ApexVDCPlaneEvent::EStage), and the rest are run 
+    //  the first time something asks for their results in an event (see EnsureStage()). that is why this 
+    //  is mutable: the const accessors below may have to finish processing the event first. so, they are 
+    //  NOT thread-safe, even though they are const: only one thread at a time may use a plane's accessors. 
+    //
+    mutable ApexVDCPlaneEvent fEvent; 
+
+    //  The last stage which Decode() runs in every event: the larger of the DB key 'stages' (which must 
+    //  cover every output variable read by address, see DefineVariables()), and the stage needed by each 
+    //  consumer registered with RegisterConsumer(). 
+    //
+    int fStage   = ApexVDCPlaneEvent::kStageFit; 
+    int fStageDB = ApexVDCPlaneEvent::kStageFit;   //from the DB key 'stages' 
+    std::vector<std::pair<std::string, int>> fConsumers;   //name & stage of each registered consumer 
+
+    int fHits_reserve   = 0;      //number of hits & groups to pre-allocate space for at init (from the DB). 
+    int fGroups_reserve = 0;      // if the high-water marks below stay under these, decoding never allocates. 
+
+    //for the bulk decode path: the wire number of each channel of each detector map module. channel 'chan' 
+    // of module 'i' is wire fChanWire[ fModuleChanOffset[i] + chan - lo ]. built once by ReadDataBase(). 
+    std::vector<int> fChanWire; 
+    std::vector<int> fModuleChanOffset; 
+
+    int fUseIterator    = 0;      //if nonzero, decode with THaDetMap's multi-hit iterator instead (from the DB) 
+
+    //online hot-wire finder (see ApexVDCHotWireFinder.h). only used when decoding in the analyzer, 
+    // since it changes fCalib.wire_ok from event to event. (ApexVDCReplayMT only masks the bad list.) 
+    ApexVDCHotWireFinder fHotWires; 
+    int fHotWireEnable  = 0;      //if nonzero, look for hot wires (from the DB) 
+    std::vector<int> fHotWireList;//wires masked as hot right now 
+    int fNHotWires      = 0;      //number of wires masked as hot right now 
+    int fNMaskedWires   = 0;      //number of wires masked right now (bad list & hot) 
+
+    //apply the latest changes of the hot-wire finder to fCalib.wire_ok, and log them 
+    void UpdateHotWires(); 
+
+    bool fCalibFromCache = false; //true if the parameters were loaded from the calibration cache 
+
+    //source of each event's reference time (see ApexVDCPlaneEvent::reftime): either a TDC channel, 
+    // usually the trigger (DB key 'reftime.chan'), or a global variable which is filled before this 
+    // plane is decoded, e.g. the time of the selected S2 hit (DB key 'reftime.var'). 
+    int      fRefChan[3] = {-1, -1, -1}; //crate, slot & channel of the reference TDC channel (-1 = none) 
+    double   fRefOffset  = 0.;    //real time of the reference channel [s] is fRefOffset - tdc.res * its raw TDC value 
+    TString  fRefVarName;         //name of the global variable with the reference time [s] (empty = none) 
+    THaVar*  fRefVar     = nullptr;//that variable (looked up at Begin()) 
+
+    //set the reference time of this event (if there is a source for it) 
+    void ReadRefTime(const THaEvData& data); 
+
+    //t0 calibration from the raw hits of this run (see ApexVDCT0Calib.h). the histograms are filled by 
+    // Decode(), and fit by End(), which writes the fitted offsets as a 'tdc.offsets' DB block. 
+    ApexVDCT0Calib fT0Calib; 
+    int      fT0Enable   = 0;     //if nonzero, fill the t0 histograms (from the DB) 
+    TString  fT0Output;           //file to write the fitted offsets to (from the DB. empty = '<prefix>t0.db') 
+    TDatime  fT0Date;             //date of the run, used as the validity timestamp of the fitted offsets 
+
+    //fit the t0 histograms of this run, and write the offsets to fT0Output 
+    void FitT0Calib(); 
+
+    //if open, the hits of each decoded event are written here (see OpenHitStream()) 
+    ApexVDCHitStreamWriter fHitStream; 
+
+    //the last stream ReplayHits() found to match this plane's calibration (& the calibration hash it had 
+    // then), so that it is only checked once. reset whenever the DB is read. 
+    const ApexVDCHitStreamReader* fReplayStream     = nullptr; 
+    uint64_t                      fReplayStreamHash = 0; 
+
+    //read all parameters from the text DB into 'db' 
+    int ReadTextDB(FILE* file, const TDatime& date, ApexVDCPlaneDB& db); 
+
+    //copy the current parameters into 'db' 
+    void SaveDB(ApexVDCPlaneDB& db) const; 
+
+    //the parameters this plane had before its DB was first read. every ReadDataBase() starts from these, 
+    // so that an optional key which is missing for one run gets its default, and not the value it had 
+    // for the run before. 
+    ApexVDCPlaneDB fDefaultDB; 
+    bool fHaveDefaultDB = false; 
+
+    //set up this plane from the parameters in 'db' (from the text DB, or the cache) 
+    int ApplyDB(const ApexVDCPlaneDB& db); 
+
+    //high-water marks, so that the buffers above can be pre-sized from the DB for a given run period 
+    UInt_t fNEventsDecoded     = 0; //number of events decoded in this run
+    UInt_t fMaxHitsPerEvent    = 0; //largest number of hits seen in one event
+    UInt_t fMaxGroupsPerEvent  = 0; //largest number of groups seen in one event
+    UInt_t fNEventsGrouped     = 0; //number of events whose hits were grouped (fMaxGroupsPerEvent is only 
+                                    // measured in these, see the DB key 'stages')
+    UInt_t fFirstEvNum         = 0; //event numbers of the first & last event decoded in this run
+    UInt_t fLastEvNum          = 0; 
+
+    //missing-data warnings from DecodeBulk() in this run. only the first kMaxDataWarnings are printed. 
+    UInt_t fNDataWarnings      = 0; 
+    static constexpr UInt_t kMaxDataWarnings = 20; 
+
+    //write what was decoded in this run to the shard directory, if this is one shard of a sharded replay 
+    // (see ApexVDCShard.h) 
+    void WriteShardReport() const; 
 
 public: 
     explicit ApexVDCPlane(  const char* name="", 
@@ -55,42 +150,125 @@ public:
     
     ~ApexVDCPlane(); 
     
-    //read database, given the input date 
+    //read database, given the input date. if a calibration cache directory is set (see ApexVDCCalibCache.h), 
+    // the parameters are loaded from the cache if it is up to date, and the cache is written otherwise. 
     int ReadDataBase(const TDatime& date);
 
+    //true if the parameters were loaded from the calibration cache by the last ReadDataBase() 
+    bool IsCalibFromCache() const { return fCalibFromCache; }
+
     //read geometry from the database
     int ReadGeometry(FILE* file, const TDatime& date); 
 
+    //this is what Podd calls from Init(). (without it, ReadDataBase() above would never be called 
+    // when this plane is initialized by a parent detector, see ApexVDC.h) 
+    int ReadDatabase(const TDatime& date) { return ReadDataBase(date); }
+
+    //reset the high-water marks & counters at the start of a run
+    int Begin(THaRunBase* run=nullptr); 
+
+    //print the high-water marks & counters of this run
+    int End(THaRunBase* run=nullptr); 
+
+    //reset all per-event data. the capacity of all hit/group buffers is kept, so that decoding 
+    // does not allocate once the buffers have grown to their working size. 
+    void Clear(Option_t* opt=""); 
+
     //define variables which this detector can provide
     int DefineVariables(EMode mode = kDefine); 
 
-    //these are a list of functions that will give us the variables we want. 
-    // see the implementation of 'DefineVariables' above to see how they are defined. 
-    std::vector<double> GetHits_rawtime()   const noexcept;
-    std::vector<double> GetHits_time()      const noexcept; 
-    std::vector<int>    GetHits_wire()      const noexcept;  
-    std::vector<double> GetHits_pos()       const noexcept;  
-    std::vector<int>    GetGroups_start()   const noexcept; 
-    std::vector<int>    GetGroups_end()     const noexcept; 
-    std::vector<int>    GetGroups_span()    const noexcept; 
-
     //decode raw TDC data into hit-data
     int StoreHit(const DigitizerHitInfo_t& hit_info, UInt_t data); 
     
     //decode raw TDC data 
     int Decode(const THaEvData& data); 
+
+    //decode each module's channels in bulk, using the channel-to-wire table built by ReadDataBase(). 
+    // this is the default. 
+    int DecodeBulk(const THaEvData& data); 
+
+    //decode one hit at a time, with THaDetMap's multi-hit iterator, LoadData() & StoreHit(). (DB key 'decode.iterator') 
+    int DecodeIterator(const THaEvData& data); 
+
+    //write the (sorted) hits of every event decoded from now on to a hit stream at 'path' (see ApexVDCHitStream.h), 
+    // so that the events can be re-reconstructed later with ReplayHits(), without decoding the raw data again. 
+    // the stream is closed by CloseHitStream(), or at the end of the run. throws if the file can't be opened, 
+    // or if the TDC cut ('tdc.max') lets through raw TDC values which don't fit in the stream (see 
+    // ApexVDCHitStreamWriter::Open()). 
+    void OpenHitStream(const char* path); 
+    void CloseHitStream(); 
+
+    //refill this plane's hits from the i-th event of a hit stream, and group, fit & fill the output just 
+    // like Decode() does. returns the number of hits. throws if the stream was written with a different 
+    // TDC calibration or number of wires than this plane has now (checked once for each stream). 
+    int ReplayHits(const ApexVDCHitStreamReader& stream, uint64_t i); 
+
+    //true if this plane takes hit times relative to a reference time (DB keys 'reftime.chan' or 'reftime.var') 
+    bool HasRefTimeSource() const { return fRefChan[0] >= 0 || !fRefVarName.IsNull(); }
+
+    //use std::sort() instead of the bucket sort to order hits (for comparison of the two)
+    void SetUseStdSort(bool use_std_sort=true) { fCalib.use_std_sort = use_std_sort; }
+
+    //decode with THaDetMap's multi-hit iterator instead of the bulk channel loop (for comparison of the two)
+    void SetUseIterator(bool use_iterator=true) { fUseIterator = use_iterator; }
+
+    //calibration (read-only), and the per-event data of the last event decoded by this plane. 
+    // (GetEvent() & the hit & group accessors below may run the rest of the stages on 'fEvent' first, 
+    // so they must not be called from several threads at once.) 
+    const ApexVDCPlaneCalib& GetCalib() const { return fCalib; }
+    const ApexVDCPlaneEvent& GetEvent() const { EnsureStage(ApexVDCPlaneEvent::kStageFit); return fEvent; }
+
+    //run the stages of this event up to 'stage', if they have not been run yet (see fStage) 
+    void EnsureStage(int stage) const { if (fEvent.stage < stage) fEvent.Process(fCalib, stage); }
+
+    //tell this plane that 'name' (e.g. a parent detector, or a monitoring plugin) uses the results of 
+    // every event up to 'stage', so that Decode() always runs that far. call this before Begin(). 
+    // registering again under the same name replaces the earlier stage. 
+    void RegisterConsumer(const char* name, int stage); 
+
+    //the last stage which Decode() runs in every event 
+    int GetStage() const { return fStage; }
+
+    //t0 histograms of this run (only filled if 'fT0Enable' is set) 
+    const ApexVDCT0Calib& GetT0Calib() const { return fT0Calib; }
+
+    //timing & rate counters for this run (only filled if built with APEXVDC_INSTRUMENT)
+    const ApexVDCPlaneStats& GetStats() const { return fEvent.stats; }
     
-    //wires
-    int GetNWires() const { return fWires.size(); }
-    std::vector<ApexVDCWire> GetWires() const noexcept { return fWires; }
+    //wires, hits & groups, as read-only views which don't copy anything (see ApexVDCSpan.h). the views 
+    // of the hits & groups are valid until the next event is decoded, the view of the wires until the 
+    // DB is read again. 
+    int GetNWires() const { return fCalib.wires.size(); }
+    ApexVDCSpan<ApexVDCWire> GetWireSpan() const noexcept { return fCalib.wires; }
+    const ApexVDCWire& GetWire(int i) const { return fCalib.wires[i]; }
     
-    //hits 
-    int GetNHits() const { return fHits.size(); }
-    std::vector<ApexVDCHit> GetHits() const noexcept { return fHits; }
+    int GetNHits() const { EnsureStage(ApexVDCPlaneEvent::kStageConvert); return fEvent.hits.size(); }
+    ApexVDCSpan<ApexVDCHit> GetHitSpan() const { EnsureStage(ApexVDCPlaneEvent::kStageOrder); return fEvent.GetHitSpan(); }
+    const ApexVDCHit& GetHit(int i) const { EnsureStage(ApexVDCPlaneEvent::kStageOrder); return fEvent.hits[i]; }
+
+    int GetNGroups() const { EnsureStage(ApexVDCPlaneEvent::kStageGroup); return fEvent.groups.size(); }
+    ApexVDCGroupRange GetGroupRange() const { EnsureStage(ApexVDCPlaneEvent::kStageGroup); return fEvent.GetGroupRange(); }
+    ApexVDCGroupView  GetGroup(int i) const { EnsureStage(ApexVDCPlaneEvent::kStageGroup); return {fEvent.groups[i], fEvent.hits.data()}; }
+
+    //copies of the wires, hits & groups. these copy everything on every call, so they are only kept 
+    // for ROOT scripts; use the views above instead. 
+    [[deprecated("copies all wires; use GetWireSpan()")]]
+    std::vector<ApexVDCWire> GetWires() const { return fCalib.wires; }
+    [[deprecated("copies all hits; use GetHitSpan()")]]
+    std::vector<ApexVDCHit> GetHits() const { EnsureStage(ApexVDCPlaneEvent::kStageOrder); return fEvent.hits; }
+    [[deprecated("copies all groups; use GetGroupRange()")]]
+    std::vector<ApexVDCHitGroup> GetGroups() const { EnsureStage(ApexVDCPlaneEvent::kStageGroup); return fEvent.groups; }
+
+    //masked wires 
+    int GetNHotWires()    const { return fNHotWires; }
+    int GetNMaskedWires() const { return fNMaskedWires; }
+    const std::vector<int>& GetHotWires() const { return fHotWireList; }
 
-    //groups
-    int GetNGroups() const { return fGroups.size(); }
-    std::vector<ApexVDCHitGroup> GetGroups() const noexcept { return fGroups; }
+    //high-water marks 
+    UInt_t GetNEventsDecoded()    const { return fNEventsDecoded; }
+    UInt_t GetMaxHitsPerEvent()   const { return fMaxHitsPerEvent; }
+    UInt_t GetMaxGroupsPerEvent() const { return fMaxGroupsPerEvent; }
+    UInt_t GetNEventsGrouped()    const { return fNEventsGrouped; }
 
     ClassDef(ApexVDCPlane,0); 
 }; 
@@ -0,0 +1,95 @@
+#ifndef ApexVDCPlaneCalib_H
+#define ApexVDCPlaneCalib_H
+////////////////////////////////////////////////////////////////////////////////////////
+//
+//  struct: ApexVDCPlaneCalib
+//  All of the calibration & configuration of one VDC plane which does not change from
+//  event to event: the wire table, TDC window, geometry, group cuts, TTD conversion
+//  and group fit.
+//
+//  This is filled by ApexVDCPlane::ReadDataBase(), and is only ever read (through a
+//  const reference) while decoding. So, any number of threads can decode different
+//  events against the same ApexVDCPlaneCalib at once, each with its own
+//  ApexVDCPlaneEvent (see ApexVDCPlaneEvent.h).
+//
+//  This does not depend on Podd or ROOT, so that it can be used outside of the analyzer.
+//
+//  - Seth H 28 Sep 25
+////////////////////////////////////////////////////////////////////////////////////////
+
+#include "ApexVDCWire.h"
+#include "ApexVDCTTDConv.h"
+#include <vector>
+#include <limits>
+
+struct ApexVDCPlaneCalib {
+
+    //TDC parameters
+    double tdc_resolution  = 0.5e-9;  //by default, half a nanosecond.
+    double tdc_rawtime_max = 2200.;   //maximum & minimum raw TDC times for each wire
+    double tdc_rawtime_min = 0.;
+
+    //information about the geometry of the detector
+    double center[3] = {0., 0., 0.};  //center of the detector, displaced from the origin of the DET coordinate system [m].
+    double length = 0., width = 0.;   //length (x-dir) and width (y-dir) of the detector [m]
+    int    nwires = 368;
+    //position of the first wire from the center of the detector [m], along with wire spacing [m], and wire angle [rad].
+    double first_wire_pos = 0., wire_spacing = 0., wire_angle = 0.;
+
+    int group_span_min = 2;     //for hit 'groups', the min and max span
+    int group_span_max = 10;
+    int group_hits_min = 2;     //minimum number of hits for one group
+    int group_max_gap  = 3;     //largest allowable 'gap' between hits in a group
+
+    double fit_sigma   = 200.e-6; //resolution of one drift distance [m], used for the chi2 of group fits
+
+    //window on the real time of each hit, relative to the event's reference time [s] (see 
+    // ApexVDCPlaneEvent::reftime). only applied in events which have a reference time. 
+    double reftime_min = -std::numeric_limits<double>::infinity(); 
+    double reftime_max =  std::numeric_limits<double>::infinity(); 
+
+    int use_std_sort   = 0;     //if nonzero, order hits with std::sort() instead of the per-wire bucket sort
+
+    ApexVDCTTDConv           ttd;         //drift-time to drift-distance conversion
+
+    std::vector<ApexVDCWire> wires;       //list of all wires
+    std::vector<double>      tdc_offsets; //timing offset of each wire, in one contiguous array (for ApexVDCTimeKernel)
+
+    //acceptance table: 1 if hits on a wire are kept, 0 if they are dropped. this is checked for every hit 
+    // without a branch (see ApexVDCPlaneEvent::ConvertHits()). wires on the bad list are always 0; the 
+    // online hot-wire finder (see ApexVDCHotWireFinder.h) may set others to 0 while running. 
+    std::vector<unsigned char> wire_ok; 
+    std::vector<unsigned char> wire_bad;  //1 for each wire on the bad list
+
+    //(re)build the wire table from the geometry above & the given TDC offsets (one per wire)
+    void MakeWires(const std::vector<double>& offsets)
+    {
+        wires.clear();
+        wires.reserve(nwires);
+
+        tdc_offsets.assign(offsets.begin(), offsets.begin() + nwires);
+
+        //by default, all wires are good
+        wire_ok .assign(nwires, 1);
+        wire_bad.assign(nwires, 0);
+
+        double wire_pos = first_wire_pos;
+
+        for (int i=0; i<nwires; i++) {
+            wires.emplace_back(i, wire_pos, offsets[i], tdc_resolution);
+            wire_pos += wire_spacing;
+        }
+    }
+
+    //mark the wires on the bad list (which must be valid wire numbers), so that their hits are dropped. 
+    // this must be called after MakeWires(). 
+    void MakeWireMask(const std::vector<int>& badlist)
+    {
+        wire_ok .assign(nwires, 1);
+        wire_bad.assign(nwires, 0);
+
+        for (int wire : badlist) { wire_bad[wire] = 1; wire_ok[wire] = 0; }
+    }
+};
+
+#endif
@@ -0,0 +1,406 @@
+#include "ApexVDCPlaneEvent.h"
+#include "ApexVDCTimeKernel.h"
+#include "ApexVDCClusterFit.h"
+#include <vector>
+#include <algorithm>
+#include <limits>
+#include <cstring>
+
+using namespace std;
+
+namespace {
+    //below this number of hits, SortHits() uses std::sort() instead of the bucket sort
+    const size_t kBucketSortMinHits = 64;
+
+    const char* const kStageNames[ApexVDCPlaneEvent::kNStages] = 
+        { "store", "convert", "order", "group", "output", "ttd", "fit" }; 
+}
+
+//______________________________________________________________________________________________________
+const char* ApexVDCPlaneEvent::GetStageName(int stage)
+{
+    return (stage >= 0 && stage < kNStages) ? kStageNames[stage] : "unknown"; 
+}
+
+//______________________________________________________________________________________________________
+int ApexVDCPlaneEvent::FindStage(const char* name)
+{
+    for (int i=0; i<kNStages; i++) if (name && !strcmp(name, kStageNames[i])) return i; 
+    return -1; 
+}
+
+//______________________________________________________________________________________________________
+void ApexVDCPlaneEvent::Clear()
+{
+    //reset all per-event data. clear() keeps the capacity of each vector.
+    raw_wire.clear();
+    raw_data.clear();
+
+    has_reftime = 0;
+    reftime     = 0.;
+
+    stage = kStageStore;
+
+    hits.clear();
+    groups.clear();
+
+    hit_rawtime.clear();
+    hit_time   .clear();
+    hit_wire   .clear();
+    hit_pos    .clear();
+    hit_dist   .clear();
+
+    group_nhits.clear();
+    group_start.clear();
+    group_end  .clear();
+    group_span .clear();
+    group_pos  .clear();
+    group_slope.clear();
+    group_chi2 .clear();
+    group_pivot.clear();
+}
+
+//______________________________________________________________________________________________________
+void ApexVDCPlaneEvent::Reserve(int nhits, int ngroups, int nwires)
+{
+    //pre-allocate space for hits & groups, if we were told how much we need
+    if (nhits > 0) {
+        raw_wire    .reserve(nhits);
+        raw_data    .reserve(nhits);
+        raw_rawtime .reserve(nhits);
+        raw_realtime.reserve(nhits);
+        raw_accept  .reserve(nhits);
+        hits        .reserve(nhits);
+        hits_scratch.reserve(nhits);
+        hit_rawtime .reserve(nhits);
+        hit_time    .reserve(nhits);
+        hit_wire    .reserve(nhits);
+        hit_pos     .reserve(nhits);
+        hit_dist    .reserve(nhits);
+    }
+    if (ngroups > 0) {
+        groups      .reserve(ngroups);
+        group_nhits .reserve(ngroups);
+        group_start .reserve(ngroups);
+        group_end   .reserve(ngroups);
+        group_span  .reserve(ngroups);
+        group_pos   .reserve(ngroups);
+        group_slope .reserve(ngroups);
+        group_chi2  .reserve(ngroups);
+        group_pivot .reserve(ngroups);
+    }
+    if (nwires > 0) wire_offsets.reserve(nwires+1);
+}
+
+//______________________________________________________________________________________________________
+int ApexVDCPlaneEvent::StoreHit(const ApexVDCPlaneCalib& calib, int wire_num, unsigned int data)
+{
+    //check if this logical channel number is invalid or not. (ApexVDCPlane::ReadDataBase() already checks 
+    // that the detector map only contains valid wires, so this should never happen.)
+    if (wire_num < 0 || (size_t)wire_num >= calib.wires.size()) {
+        APEXVDC_COUNT( stats.nhits_bad_channel++ );
+        return -1;
+    }
+
+    //the TDC cut & time conversion are done for all hits at once, in ConvertHits()
+    raw_wire.push_back(wire_num);
+    raw_data.push_back(data);
+
+    return 0;
+}
+
+//______________________________________________________________________________________________________
+int ApexVDCPlaneEvent::ConvertHits(const ApexVDCPlaneCalib& calib)
+{
+    //Convert all raw hits into hits: apply the TDC cut, and compute the real time of each hit, 
+    // in one (vectorized) pass. see ApexVDCTimeKernel.h. If this event has a reference time, the 
+    // real times are relative to it, and the (tight) window around it is applied in the same pass, 
+    // so that out-of-time hits never reach the sort, the group finder or the fit. 
+    APEXVDC_TIMER(timer, stats.time_convert);
+
+    const size_t nraw = raw_data.size();
+
+    const double time_min = has_reftime ? calib.reftime_min : -numeric_limits<double>::infinity(); 
+    const double time_max = has_reftime ? calib.reftime_max :  numeric_limits<double>::infinity(); 
+
+    raw_rawtime .resize(nraw);
+    raw_realtime.resize(nraw);
+    raw_accept  .resize(nraw);
+
+    [[maybe_unused]] const size_t naccept = ApexVDCTimeKernel::Convert( raw_wire.data(), 
+                                                                        raw_data.data(), 
+                                                                        nraw, 
+                                                                        calib.tdc_offsets.data(),
+                                                                        calib.tdc_resolution, 
+                                                                        calib.tdc_rawtime_min, 
+                                                                        calib.tdc_rawtime_max, 
+                                                                        reftime, 
+                                                                        time_min, 
+                                                                        time_max, 
+                                                                        raw_rawtime.data(), 
+                                                                        raw_realtime.data(), 
+                                                                        raw_accept.data() ); 
+
+    //now, keep only the accepted hits: those in the TDC (& reference-time) window, on a wire which is not masked (see 
+    // ApexVDCPlaneCalib::wire_ok). every hit is written, but the write position only advances for 
+    // accepted hits, so that there is no (unpredictable) branch. 
+    const size_t first = hits.size();
+    hits.resize(first + nraw);
+
+    ApexVDCHit* out = hits.data() + first;
+    const unsigned char* wire_ok = calib.wire_ok.data(); 
+    size_t k = 0;
+
+    for (size_t i=0; i<nraw; i++) {
+        out[k] = { &calib.wires[raw_wire[i]], raw_realtime[i], raw_rawtime[i] };
+        k += raw_accept[i] & wire_ok[raw_wire[i]];
+    }
+    hits.resize(first + k);
+
+    //(to tell the hits rejected by the TDC window from those rejected by the reference-time window. 
+    // this only costs anything in an instrumented build.) 
+    [[maybe_unused]] size_t nin_tdc = 0; 
+    APEXVDC_COUNT( for (size_t i=0; i<nraw; i++) nin_tdc += (raw_rawtime[i] >= calib.tdc_rawtime_min) & 
+                                                            (raw_rawtime[i] <= calib.tdc_rawtime_max) ); 
+
+    APEXVDC_COUNT( stats.nhits_raw           += nraw );
+    APEXVDC_COUNT( stats.nhits_accepted      += k );
+    APEXVDC_COUNT( stats.nhits_rejected_tdc  += nraw - nin_tdc );
+    APEXVDC_COUNT( stats.nhits_rejected_time += nin_tdc - naccept );
+    APEXVDC_COUNT( stats.nhits_masked        += naccept - k );
+
+    raw_wire.clear();
+    raw_data.clear();
+
+    stage = kStageConvert;
+
+    APEXVDC_COUNT( stats.nevents++ );
+    APEXVDC_COUNT( stats.FillHitsHist(hits.size()) );
+
+    return hits.size();
+}
+
+//______________________________________________________________________________________________________
+void ApexVDCPlaneEvent::SortHits(const ApexVDCPlaneCalib& calib)
+{
+    //Sort all hits in ascending order of wire number, and in ascending order of realtime (so descending
+    // rawtime) for hits on the same wire. This gives exactly the same order as std::sort() with
+    // ApexVDCHit::operator<, but in O(n):
+    //
+    //  1. count the hits on each wire, and turn those counts into the index of each wire's first hit
+    //  2. scatter the hits into a scratch buffer, so they are grouped by wire in ascending order
+    //  3. insertion-sort by rawtime within each wire. There are almost never more than a few hits on
+    //     one wire, and we never have to look past the start of the wire, so this is ~linear too.
+    //
+    //The wire number is only looked up once per hit (in steps 1 & 2); step 3 compares wire pointers.
+    //
+    APEXVDC_TIMER(timer, stats.time_sort);
+
+    //The bucket sort has a fixed cost of one pass over all wires, so (according to ApexOfflineBench) 
+    // std::sort() is faster for events with fewer than ~60-80 hits. 
+    const size_t nhits = hits.size();
+
+    stage = kStageOrder;
+
+    if (calib.use_std_sort || nhits < kBucketSortMinHits) {
+        std::sort( hits.begin(), hits.end() );
+        return;
+    }
+
+    //these only allocate the first time they are used (or if the number of hits/wires grows)
+    wire_offsets.assign(calib.wires.size()+1, 0);
+    hits_scratch.resize(nhits);
+
+    //count the number of hits on each wire. entry [i+1] counts the hits on wire 'i'.
+    for (const auto& hit : hits) wire_offsets[hit.wire->GetNum()+1]++;
+
+    //now, entry [i] is the index of the first hit on wire 'i'
+    for (size_t i=1; i<wire_offsets.size(); i++) wire_offsets[i] += wire_offsets[i-1];
+
+    //scatter the hits into the scratch buffer
+    for (const auto& hit : hits) hits_scratch[ wire_offsets[hit.wire->GetNum()]++ ] = hit;
+
+    //sort each wire's hits in descending order of rawtime
+    for (size_t i=1; i<nhits; i++) {
+
+        const ApexVDCHit hit = hits_scratch[i];
+        size_t j = i;
+
+        while (j > 0 && hits_scratch[j-1].wire == hit.wire && hits_scratch[j-1].rawtime < hit.rawtime) {
+            hits_scratch[j] = hits_scratch[j-1];
+            j--;
+        }
+        hits_scratch[j] = hit;
+    }
+
+    //swap (rather than copy) so that both buffers keep their capacity
+    hits.swap(hits_scratch);
+}
+
+//______________________________________________________________________________________________________
+int ApexVDCPlaneEvent::FindGroups(const ApexVDCPlaneCalib& calib)
+{
+    //Walk the sorted list of hits once, and form 'groups' of hits. A group is a run of hits in which
+    // no two neighboring hit wires are separated by more than 'group_max_gap' empty wires.
+    // Each group is stored as a range of indices into 'hits', so that no hits are ever copied.
+    //
+    // a group is only kept if:
+    //  - it has at least 'group_hits_min' hits (multiple hits on the same wire all count)
+    //  - its span (last wire - first wire + 1) is in the range [group_span_min, group_span_max]
+    //
+    //clear() keeps the capacity of 'groups', so this does not allocate once the vector has grown.
+    APEXVDC_TIMER(timer, stats.time_group);
+
+    groups.clear();
+
+    const int nhits = hits.size();
+
+    int start = 0;
+    while (start < nhits) {
+
+        const int first_wire = hits[start].wire->GetNum();
+        int last_wire = first_wire;
+        int end = start;
+
+        //keep adding hits to this group until we find a gap which is too large
+        while (end+1 < nhits) {
+
+            const int next_wire = hits[end+1].wire->GetNum();
+
+            if (next_wire - last_wire - 1 > calib.group_max_gap) break;
+
+            last_wire = next_wire;
+            end++;
+        }
+
+        const int span = last_wire - first_wire + 1;
+
+        //check if this group passes our cuts
+        if ((end - start + 1) >= calib.group_hits_min &&
+            span >= calib.group_span_min &&
+            span <= calib.group_span_max) {
+
+            groups.push_back({start, end, span});
+        }
+
+        //start the next group with the first hit which was not included in this one
+        start = end+1;
+    }
+
+    stage = kStageGroup;
+
+    APEXVDC_COUNT( stats.ngroups += groups.size() );
+
+    return groups.size();
+}
+
+//______________________________________________________________________________________________________
+void ApexVDCPlaneEvent::FillOutput()
+{
+    //fill the output 'columns' for all hits & groups.
+    // resize() keeps the capacity of each vector, so this does not allocate once they have grown.
+    APEXVDC_TIMER(timer, stats.time_output);
+
+    stage = kStageOutput;
+
+    const size_t nhits = hits.size();
+
+    hit_rawtime.resize(nhits);
+    hit_time   .resize(nhits);
+    hit_wire   .resize(nhits);
+    hit_pos    .resize(nhits);
+
+    for (size_t i=0; i<nhits; i++) {
+        const ApexVDCHit& hit = hits[i];
+        hit_rawtime[i] = hit.rawtime;
+        hit_time[i]    = hit.realtime;
+        hit_wire[i]    = hit.wire->GetNum();
+        hit_pos[i]     = hit.wire->GetPos();
+    }
+
+    const size_t ngroups = groups.size();
+
+    group_nhits.resize(ngroups);
+    group_start.resize(ngroups);
+    group_end  .resize(ngroups);
+    group_span .resize(ngroups);
+
+    for (size_t i=0; i<ngroups; i++) {
+        const ApexVDCHitGroup& group = groups[i];
+        group_nhits[i] = group.GetNHits();
+        group_start[i] = group.start;
+        group_end[i]   = group.end;
+        group_span[i]  = group.span;
+    }
+}
+
+//______________________________________________________________________________________________________
+void ApexVDCPlaneEvent::ComputeDistances(const ApexVDCPlaneCalib& calib)
+{
+    //convert the drift time of every hit into a drift distance, over the whole 'hit_time' column at once. 
+    // (see ApexVDCTTDConv.h) 
+    APEXVDC_TIMER(timer, stats.time_ttd);
+
+    stage = kStageTTD;
+
+    hit_dist.resize(hit_time.size());
+
+    calib.ttd.Convert( hit_wire.data(), hit_time.data(), hit_time.size(), hit_dist.data() );
+}
+
+//______________________________________________________________________________________________________
+int ApexVDCPlaneEvent::FitGroups(const ApexVDCPlaneCalib& calib)
+{
+    //fit all groups of this event in one pass over the output columns (see ApexVDCClusterFit.h)
+    APEXVDC_TIMER(timer, stats.time_fit);
+
+    stage = kStageFit;
+
+    const size_t ngroups = groups.size();
+
+    group_pos  .resize(ngroups);
+    group_slope.resize(ngroups);
+    group_chi2 .resize(ngroups);
+    group_pivot.resize(ngroups);
+
+    return ApexVDCClusterFit::Fit( hit_pos.data(), hit_dist.data(), hit_wire.data(),
+                                   group_start.data(), group_end.data(), ngroups,
+                                   calib.fit_sigma,
+                                   group_pos.data(), group_slope.data(), group_chi2.data(), group_pivot.data(),
+                                   fit_scratch );
+}
+
+//______________________________________________________________________________________________________
+int ApexVDCPlaneEvent::Process(const ApexVDCPlaneCalib& calib, int last)
+{
+    //convert all raw hits which have been stored into hits 
+    if (stage < kStageConvert && last >= kStageConvert) ConvertHits(calib);
+
+    //now, sort all hits in ascending order of wire number, and in ascending order of realtime for
+    // hits on the same wire.
+    if (stage < kStageOrder && last >= kStageOrder) SortHits(calib);
+
+    //now that the hits are sorted, form them into groups
+    if (stage < kStageGroup && last >= kStageGroup) FindGroups(calib);
+
+    //fill the output variables
+    if (stage < kStageOutput && last >= kStageOutput) FillOutput();
+
+    //compute drift distances
+    if (stage < kStageTTD && last >= kStageTTD) ComputeDistances(calib);
+
+    //fit all groups
+    if (stage < kStageFit && last >= kStageFit) FitGroups(calib);
+
+    return hits.size();
+}
+
+//______________________________________________________________________________________________________
+int ApexVDCPlaneEvent::ProcessSorted(const ApexVDCPlaneCalib& calib, int last)
+{
+    //the hits are in order already 
+    stage = max<int>(stage, kStageOrder);
+
+    return Process(calib, last);
+}
+//______________________________________________________________________________________________________
@@ -0,0 +1,150 @@
+#ifndef ApexVDCPlaneEvent_H
+#define ApexVDCPlaneEvent_H
+////////////////////////////////////////////////////////////////////////////////////////
+//
+//  struct: ApexVDCPlaneEvent
+//  All of the per-event state of one VDC plane: its hits, hit 'groups', output columns
+//  and scratch space. Decoding fills one of these against a (read-only)
+//  ApexVDCPlaneCalib, so that several events can be decoded at once on different
+//  threads, each with its own ApexVDCPlaneEvent.
+//
+//  Clear() keeps the capacity of every buffer, so a ApexVDCPlaneEvent which is reused
+//  from event to event stops allocating once its buffers have grown to their working size.
+//
+//  Once the raw hits are stored, an event goes through a fixed sequence of stages (see
+//  EStage), each of which needs all of the ones before it. 'stage' keeps track of the last
+//  one done, so that Process() can be asked to go only as far as some stage, and be called
+//  again later to go further, without ever doing a stage twice. (ApexVDCPlane uses this to
+//  run only the stages something needs, see ApexVDCPlane::EnsureStage().)
+//
+//  This does not depend on Podd or ROOT, so that it can be used outside of the analyzer.
+//
+//  - Seth H 28 Sep 25
+////////////////////////////////////////////////////////////////////////////////////////
+
+#include "ApexVDCHit.h"
+#include "ApexVDCHitGroup.h"
+#include "ApexVDCPlaneCalib.h"
+#include "ApexVDCPlaneStats.h"
+#include "ApexVDCSpan.h"
+#include <vector>
+
+struct ApexVDCPlaneEvent {
+
+    //the stages of processing, in the order they are done, and what each one fills 
+    enum EStage {
+        kStageStore     = 0,    //raw hits stored: raw_wire, raw_data (nothing done yet) 
+        kStageConvert   = 1,    //TDC cut & real times: hits (in the order they were stored) 
+        kStageOrder     = 2,    //hits sorted by wire & time 
+        kStageGroup     = 3,    //groups 
+        kStageOutput    = 4,    //hit_rawtime, hit_time, hit_wire, hit_pos & group_nhits, _start, _end, _span 
+        kStageTTD       = 5,    //hit_dist 
+        kStageFit       = 6,    //group_pos, group_slope, group_chi2, group_pivot 
+        kNStages        = 7
+    };
+
+    //name of each stage: "store", "convert", "order", "group", "output", "ttd" & "fit" 
+    static const char* GetStageName(int stage); 
+
+    //the stage with this name. returns -1 if there is none. 
+    static int FindStage(const char* name); 
+
+    int                             stage = kStageStore;    //last stage done for this event (reset by Clear()) 
+
+    //raw (wire, TDC value) pairs of this event, gathered by StoreHit() and converted into hits all at 
+    // once by ConvertHits()
+    std::vector<int>                raw_wire; 
+    std::vector<unsigned int>       raw_data; 
+
+    //reference time of this event [s] (e.g. from the trigger, or the S2 hit), if it has one. the real time 
+    // of every hit is taken relative to this, and hits outside of [calib.reftime_min, calib.reftime_max] 
+    // of it are dropped before they are sorted (see ConvertHits()). reset by Clear(). 
+    int                             has_reftime = 0; 
+    double                          reftime     = 0.; 
+
+    std::vector<ApexVDCHit>         hits;   //list of all hits (for a single event)
+    std::vector<ApexVDCHitGroup>    groups; //list of all hit 'groups'
+
+    //Output 'columns' for hits & groups (structure-of-arrays), filled once per event by FillOutput().
+    std::vector<double>             hit_rawtime;    //raw TDC time of each hit
+    std::vector<double>             hit_time;       //offset-corrected 'real time' of each hit [s]
+    std::vector<int>                hit_wire;       //wire number of each hit
+    std::vector<double>             hit_pos;        //position of each hit's wire [m]
+    std::vector<double>             hit_dist;       //drift distance of each hit [m]
+    std::vector<int>                group_nhits;    //number of hits in each group
+    std::vector<int>                group_start;    //index of first hit in each group
+    std::vector<int>                group_end;      //index of last hit in each group
+    std::vector<int>                group_span;     //span (in wires) of each group
+    std::vector<double>             group_pos;      //fitted crossing position of each group [m]
+    std::vector<double>             group_slope;    //fitted slope (drift distance / wire position) of each group (always > 0)
+    std::vector<double>             group_chi2;     //chi2 of the fit of each group (-1 if the fit failed)
+    std::vector<int>                group_pivot;    //wire of the hit closest to the track in each group
+
+    //scratch space for ConvertHits() & SortHits(). these are kept between events so that they don't allocate.
+    std::vector<double>             raw_rawtime;
+    std::vector<double>             raw_realtime;
+    std::vector<unsigned char>      raw_accept;
+    std::vector<ApexVDCHit>         hits_scratch;
+    std::vector<int>                wire_offsets;
+    std::vector<double>             fit_scratch;
+
+    //timing & rate counters. these are NOT reset by Clear(), so they add up over all events decoded 
+    // with this ApexVDCPlaneEvent. (only filled if built with APEXVDC_INSTRUMENT, see ApexVDCPlaneStats.h)
+    ApexVDCPlaneStats               stats;
+
+    //read-only views of the (sorted) hits & the groups of this event, which don't copy anything 
+    // (see ApexVDCSpan.h). these are valid until the next Clear(). 
+    ApexVDCSpan<ApexVDCHit> GetHitSpan()    const noexcept { return hits; }
+    ApexVDCGroupRange       GetGroupRange() const noexcept { return {groups, hits.data()}; }
+
+    //reset all per-event data (keeping the capacity of all buffers)
+    void Clear();
+
+    //set the reference time of this event [s] (see above). this must be done before ConvertHits(). 
+    void SetRefTime(double time) { reftime = time; has_reftime = 1; }
+
+    //pre-allocate space for the given number of hits & groups
+    void Reserve(int nhits, int ngroups, int nwires);
+
+    //check the wire number of a raw TDC value, and add it to the list of raw hits of this event. 
+    // hits with an invalid wire number are counted & skipped (returns -1). 
+    int StoreHit(const ApexVDCPlaneCalib& calib, int wire_num, unsigned int data);
+
+    //add a raw TDC value to the list of raw hits, without checking its wire number. only for callers 
+    // which have already made sure that the wire number is valid (see ApexVDCPlane::DecodeBulk()). 
+    void StoreRawHit(int wire_num, unsigned int data) { raw_wire.push_back(wire_num); raw_data.push_back(data); }
+
+    //convert all raw hits into hits at once (see ApexVDCTimeKernel.h), keeping only those which pass
+    // the TDC cut, and are not on a masked wire (see ApexVDCPlaneCalib::wire_ok). returns the number of hits. 
+    int ConvertHits(const ApexVDCPlaneCalib& calib);
+
+    //sort hits in ascending order of wire number, and in ascending order of realtime for
+    // hits on the same wire.
+    void SortHits(const ApexVDCPlaneCalib& calib);
+
+    //find hit 'groups' in the (sorted) list of hits. returns the number of groups found.
+    int FindGroups(const ApexVDCPlaneCalib& calib);
+
+    //fill the output 'columns' (see above) from the sorted hits & groups of this event
+    void FillOutput();
+
+    //compute the drift distance of every hit (from the output columns), in one pass 
+    void ComputeDistances(const ApexVDCPlaneCalib& calib);
+
+    //fit the crossing position & slope of every group at once (see ApexVDCClusterFit.h). 
+    // returns the number of groups which could be fit. 
+    int FitGroups(const ApexVDCPlaneCalib& calib);
+
+    //once all raw hits have been stored: convert them, sort them, find groups, fill the output, 
+    // compute drift distances & fit the groups, stopping after stage 'last'. stages which were 
+    // done already (see 'stage') are not done again. 
+    // returns the number of hits.
+    int Process(const ApexVDCPlaneCalib& calib, int last=kStageFit);
+
+    //the part of Process() after the hits are sorted: find groups, fill the output, compute drift distances 
+    // & fit the groups. for when 'hits' is filled in order some other way (see ApexVDCHitStream.h). 
+    // returns the number of hits. 
+    int ProcessSorted(const ApexVDCPlaneCalib& calib, int last=kStageFit);
+};
+
+#endif
@@ -0,0 +1,74 @@
+#include "ApexVDCPlaneStats.h"
+#include <sstream>
+#include <iomanip>
+
+using namespace std;
+
+//______________________________________________________________________________________________________
+ApexVDCPlaneStats& ApexVDCPlaneStats::operator+=(const ApexVDCPlaneStats& rhs)
+{
+    nevents               += rhs.nevents;
+    nevents_with_warnings += rhs.nevents_with_warnings;
+    nhits_raw             += rhs.nhits_raw;
+    nhits_accepted        += rhs.nhits_accepted;
+    nhits_rejected_tdc    += rhs.nhits_rejected_tdc;
+    nhits_rejected_time   += rhs.nhits_rejected_time;
+    nevents_no_reftime    += rhs.nevents_no_reftime;
+    nhits_masked          += rhs.nhits_masked;
+    nhits_bad_channel     += rhs.nhits_bad_channel;
+    nhits_missing_data    += rhs.nhits_missing_data;
+    ngroups               += rhs.ngroups;
+
+    time_decode  += rhs.time_decode;
+    time_convert += rhs.time_convert;
+    time_sort    += rhs.time_sort;
+    time_group   += rhs.time_group;
+    time_output  += rhs.time_output;
+    time_ttd     += rhs.time_ttd;
+    time_fit     += rhs.time_fit;
+
+    for (int i=0; i<kNHistBins; i++) hits_hist[i] += rhs.hits_hist[i];
+
+    return *this;
+}
+
+//______________________________________________________________________________________________________
+string ApexVDCPlaneStats::Summary() const
+{
+    ostringstream oss;
+
+    if (!IsEnabled()) {
+        oss << "instrumentation disabled (build with -DAPEXOFFLINE_INSTRUMENT=ON)";
+        return oss.str();
+    }
+
+    const double n = nevents > 0 ? (double)nevents : 1.;
+
+    oss << fixed << setprecision(2);
+    oss << "events decoded          " << nevents << " (" << nevents_with_warnings << " with warnings)\n";
+    oss << "raw hits / event        " << nhits_raw/n << "\n";
+    oss << "accepted hits / event   " << nhits_accepted/n << "\n";
+    oss << "rejected by TDC window  " << nhits_rejected_tdc << "\n";
+    oss << "rejected by ref. window " << nhits_rejected_time << " (" << nevents_no_reftime << " events without a reference time)\n";
+    oss << "on masked wires         " << nhits_masked << "\n";
+    oss << "invalid channels        " << nhits_bad_channel << "\n";
+    oss << "missing data            " << nhits_missing_data << "\n";
+    oss << "groups / event          " << ngroups/n << "\n";
+    oss << "time / event [ns]: decode " << time_decode/n
+        << " (convert " << time_convert/n
+        << ", sort "    << time_sort/n
+        << ", group "   << time_group/n
+        << ", output "  << time_output/n
+        << ", ttd "     << time_ttd/n
+        << ", fit "     << time_fit/n << ")\n";
+
+    //only print the histogram up to the last non-empty bin
+    int last = kNHistBins-1;
+    while (last > 0 && hits_hist[last] == 0) last--;
+
+    oss << "hits / event histogram (bin width " << kHistBinSize << "):";
+    for (int i=0; i<=last; i++) oss << " " << hits_hist[i];
+
+    return oss.str();
+}
+//______________________________________________________________________________________________________
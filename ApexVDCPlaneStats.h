@@ -0,0 +1,103 @@
+#ifndef ApexVDCPlaneStats_H
+#define ApexVDCPlaneStats_H
+////////////////////////////////////////////////////////////////////////////////////////
+//
+//  struct: ApexVDCPlaneStats
+//  Timing & rate counters for the decoding of one VDC plane: time spent in each stage,
+//  hits accepted/rejected, invalid channels, missing data, and a histogram of the number
+//  of hits per event.
+//
+//  Each ApexVDCPlaneEvent has its own ApexVDCPlaneStats, and an ApexVDCPlaneEvent is only
+//  ever used by one thread at a time, so the counters are per-thread and need no locks.
+//  Stats from several threads are combined with operator+=.
+//
+//  The counters are only filled if the library is built with APEXVDC_INSTRUMENT defined
+//  (cmake -DAPEXOFFLINE_INSTRUMENT=ON). Otherwise, the APEXVDC_COUNT() & APEXVDC_TIMER()
+//  macros below compile to nothing, so the instrumentation costs nothing at all.
+//
+//  - Seth H 28 Sep 25
+////////////////////////////////////////////////////////////////////////////////////////
+
+#include <string>
+
+#ifdef APEXVDC_INSTRUMENT
+#include <chrono>
+#endif
+
+struct ApexVDCPlaneStats {
+
+    static const int kNHistBins   = 64; //bins of the hits-per-event histogram. the last bin is the overflow.
+    static const int kHistBinSize = 4;  //number of hits per bin
+
+    //counters
+    unsigned long long nevents              = 0;    //number of events decoded
+    unsigned long long nevents_with_warnings= 0;    //number of events with missing data
+    unsigned long long nhits_raw            = 0;    //raw hits stored
+    unsigned long long nhits_accepted       = 0;    //hits which passed the TDC window
+    unsigned long long nhits_rejected_tdc   = 0;    //hits rejected by the TDC window
+    unsigned long long nhits_rejected_time  = 0;    //hits in the TDC window, but outside the window around the reference time
+    unsigned long long nevents_no_reftime   = 0;    //events without a reference time (when one is expected)
+    unsigned long long nhits_masked         = 0;    //hits in the TDC window, but on a bad or hot wire
+    unsigned long long nhits_bad_channel    = 0;    //hits on an invalid logical channel
+    unsigned long long nhits_missing_data   = 0;    //hits for which no data could be loaded
+    unsigned long long ngroups              = 0;    //groups found
+
+    //time spent in each stage [ns]
+    double time_decode  = 0.;   //all of Decode() (includes all of the below)
+    double time_convert = 0.;   //TDC cut & conversion to real time
+    double time_sort    = 0.;   //ordering of hits
+    double time_group   = 0.;   //group finding
+    double time_output  = 0.;   //filling of the output columns
+    double time_ttd     = 0.;   //drift-time to distance conversion
+    double time_fit     = 0.;   //fits of all groups
+
+    //histogram of the number of (accepted) hits per event
+    unsigned long long hits_hist[kNHistBins] = {0};
+
+    void FillHitsHist(unsigned int nhits) {
+        const unsigned int bin = nhits / kHistBinSize;
+        hits_hist[ bin < (unsigned)kNHistBins ? bin : kNHistBins-1 ]++;
+    }
+
+    void Clear() { *this = ApexVDCPlaneStats(); }
+
+    ApexVDCPlaneStats& operator+=(const ApexVDCPlaneStats& rhs);
+
+    //a human-readable summary (one line per quantity)
+    std::string Summary() const;
+
+    //true if this library was built with instrumentation
+    static constexpr bool IsEnabled() {
+#ifdef APEXVDC_INSTRUMENT
+        return true;
+#else
+        return false;
+#endif
+    }
+};
+
+#ifdef APEXVDC_INSTRUMENT
+
+//adds the time (in ns) between its construction & destruction to 'acc'
+class ApexVDCStageTimer {
+private:
+    double& fAcc;
+    std::chrono::steady_clock::time_point fStart;
+public:
+    explicit ApexVDCStageTimer(double& acc) : fAcc(acc), fStart(std::chrono::steady_clock::now()) {}
+    ~ApexVDCStageTimer() {
+        fAcc += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - fStart).count();
+    }
+};
+
+#define APEXVDC_COUNT(expr)      do { expr; } while (0)
+#define APEXVDC_TIMER(name, acc) ApexVDCStageTimer name(acc)
+
+#else
+
+#define APEXVDC_COUNT(expr)      do {} while (0)
+#define APEXVDC_TIMER(name, acc) do {} while (0)
+
+#endif
+
+#endif
@@ -0,0 +1,157 @@
+#include "ApexVDCReplayMT.h"
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <memory>
+#include <exception>
+#include <stdexcept>
+#include <sstream>
+#include <algorithm>
+
+using namespace std;
+
+namespace {
+
+    //the queue of blocks belonging to one worker. The owner pops from the front, thieves pop from the back.
+    struct BlockQueue {
+        mutex               lock;
+        deque<long long>    blocks;
+
+        bool PopFront(long long& block) {
+            lock_guard<mutex> guard(lock);
+            if (blocks.empty()) return false;
+            block = blocks.front(); blocks.pop_front();
+            return true;
+        }
+        bool PopBack(long long& block) {
+            lock_guard<mutex> guard(lock);
+            if (blocks.empty()) return false;
+            block = blocks.back(); blocks.pop_back();
+            return true;
+        }
+    };
+
+    //statistics kept by each worker, which are combined once all workers are done
+    struct WorkerStats {
+        long long    nevents    = 0;
+        unsigned int max_hits   = 0;
+        unsigned int max_groups = 0;
+        long long    nstolen    = 0;
+        ApexVDCPlaneStats counters;
+        ApexVDCT0Calib    t0;     //only filled if the t0 calibration is on
+    };
+}
+
+//______________________________________________________________________________________________________
+ApexVDCReplayMT::ApexVDCReplayMT(const ApexVDCPlaneCalib& calib, unsigned int nthreads, long long block_size)
+    : fCalib(calib),
+    fNThreads(nthreads),
+    fBlockSize(block_size)
+{
+    const char* const here = "ApexVDCReplayMT";
+
+    if (fNThreads == 0) fNThreads = max(1u, thread::hardware_concurrency());
+
+    if (fBlockSize <= 0) {
+        ostringstream oss;
+        oss << "in <" << here << ">: block size must be positive (got " << fBlockSize << ").";
+        throw invalid_argument(oss.str());
+    }
+}
+
+//______________________________________________________________________________________________________
+long long ApexVDCReplayMT::Run(long long nevents, const EventSource& source, const EventSink& sink)
+{
+    fNEventsDecoded = 0; fMaxHitsPerEvent = 0; fMaxGroupsPerEvent = 0; fNBlocksStolen = 0;
+    fStats.Clear();
+    if (fT0Enable) fT0Calib.Init(fT0Config, fCalib.nwires);
+
+    if (nevents <= 0) return 0;
+
+    const long long nblocks  = (nevents + fBlockSize - 1) / fBlockSize;
+    const unsigned  nworkers = (unsigned)min<long long>(fNThreads, nblocks);
+
+    //deal out the blocks, so that each worker starts with a contiguous range of events
+    vector<unique_ptr<BlockQueue>> queues;
+    for (unsigned w=0; w<nworkers; w++) queues.emplace_back(new BlockQueue);
+
+    for (long long b=0; b<nblocks; b++) queues[ (b * nworkers) / nblocks ]->blocks.push_back(b);
+
+    vector<WorkerStats>   stats(nworkers);
+    vector<exception_ptr> errors(nworkers);
+
+    auto work = [&](unsigned w) {
+
+        WorkerStats& stat = stats[w];
+
+        ApexVDCPlaneEvent event;
+        event.Reserve(fHits_reserve, fGroups_reserve, fCalib.nwires);
+
+        //(each worker allocates its own histograms, on its own thread)
+        if (fT0Enable) stat.t0.Init(fT0Config, fCalib.nwires);
+
+        try {
+            long long block;
+            while (true) {
+
+                //take work from our own queue first. If that's empty, try to steal from the others.
+                // Blocks are never added once we have started, so once every queue is empty, we're done.
+                bool found = queues[w]->PopFront(block);
+
+                for (unsigned k=1; !found && k<nworkers; k++) {
+                    found = queues[(w + k) % nworkers]->PopBack(block);
+                    if (found) stat.nstolen++;
+                }
+                if (!found) break;
+
+                const long long first = block * fBlockSize;
+                const long long last  = min(nevents, first + fBlockSize);
+
+                for (long long i=first; i<last; i++) {
+
+                    event.Clear();
+                    source(i, event);
+                    if (fT0Enable) stat.t0.Fill(event, fCalib.tdc_resolution);
+                    event.Process(fCalib);
+                    sink(i, event);
+
+                    stat.nevents++;
+                    stat.max_hits   = max<unsigned>(stat.max_hits,   event.hits.size());
+                    stat.max_groups = max<unsigned>(stat.max_groups, event.groups.size());
+                }
+            }
+            stat.counters = event.stats;
+
+        } catch (...) {
+            errors[w] = current_exception();
+
+            //drain all queues, so that the other workers stop as soon as they are done with their block
+            long long block;
+            for (auto& queue : queues) while (queue->PopBack(block)) {}
+        }
+    };
+
+    if (nworkers == 1) {
+        //serial path: just run on this thread
+        work(0);
+    } else {
+        vector<thread> threads;
+        for (unsigned w=0; w<nworkers; w++) threads.emplace_back(work, w);
+        for (auto& t : threads) t.join();
+    }
+
+    for (auto& err : errors) if (err) rethrow_exception(err);
+
+    for (const auto& stat : stats) {
+        fNEventsDecoded   += stat.nevents;
+        fMaxHitsPerEvent   = max(fMaxHitsPerEvent,   stat.max_hits);
+        fMaxGroupsPerEvent = max(fMaxGroupsPerEvent, stat.max_groups);
+        fNBlocksStolen    += stat.nstolen;
+        fStats            += stat.counters;
+        if (fT0Enable) fT0Calib += stat.t0;
+    }
+
+    return fNEventsDecoded;
+}
+//______________________________________________________________________________________________________
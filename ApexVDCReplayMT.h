@@ -0,0 +1,96 @@
+#ifndef ApexVDCReplayMT_H
+#define ApexVDCReplayMT_H
+////////////////////////////////////////////////////////////////////////////////////////
+//
+//  class: ApexVDCReplayMT
+//  Event-parallel decoding of one VDC plane.
+//
+//  The events [0, nevents) are split into blocks of 'block_size' events, and the blocks
+//  are dealt out to 'nthreads' worker threads. Each worker takes blocks from the front of
+//  its own queue, and when that runs dry, steals blocks from the back of the other
+//  workers' queues, so a few slow (noisy) blocks don't leave the other threads idle.
+//
+//  Each worker owns one ApexVDCPlaneEvent, which it reuses for every event it decodes,
+//  and all workers share the same (read-only) ApexVDCPlaneCalib. For every event:
+//
+//      1. the event's ApexVDCPlaneEvent is cleared
+//      2. 'source(ievent, event)' is called, which must store the raw hits of this event
+//         (with ApexVDCPlaneEvent::StoreHit())
+//      3. the hits are sorted & grouped and the output columns filled
+//      4. 'sink(ievent, event)' is called with the finished event
+//
+//  Since each event is decoded on its own, the result of every event is identical to the
+//  serial path (nthreads=1, which runs on the calling thread). Both 'source' and 'sink'
+//  are called concurrently from different threads, for different events. To keep the
+//  output in event order, the sink should write each event into a slot indexed by
+//  'ievent', rather than appending to a shared list.
+//
+//  With EnableT0Calib(), each worker also counts the raw hits of its events in its own
+//  ApexVDCT0Calib (between steps 2 & 3), and these are added together once all workers
+//  are done (see GetT0Calib()). So, the histograms are never shared between threads.
+//
+//  - Seth H 28 Sep 25
+////////////////////////////////////////////////////////////////////////////////////////
+
+#include "ApexVDCPlaneCalib.h"
+#include "ApexVDCPlaneEvent.h"
+#include "ApexVDCPlaneStats.h"
+#include "ApexVDCT0Calib.h"
+#include <functional>
+
+class ApexVDCReplayMT {
+
+public:
+    using EventSource = std::function<void(long long, ApexVDCPlaneEvent&)>;
+    using EventSink   = std::function<void(long long, const ApexVDCPlaneEvent&)>;
+
+private:
+    const ApexVDCPlaneCalib& fCalib;
+
+    unsigned int fNThreads;     //number of worker threads (0 = number of hardware threads)
+    long long    fBlockSize;    //number of events in each block of work
+
+    int fHits_reserve   = 0;    //number of hits & groups to pre-allocate for each worker
+    int fGroups_reserve = 0;
+
+    //these are filled by Run()
+    long long    fNEventsDecoded    = 0;
+    unsigned int fMaxHitsPerEvent   = 0;
+    unsigned int fMaxGroupsPerEvent = 0;
+    long long    fNBlocksStolen     = 0;
+    ApexVDCPlaneStats fStats;   //timing & rate counters of all workers, combined
+
+    bool fT0Enable = false;     //if true, fill t0 histograms (see EnableT0Calib())
+    ApexVDCT0Calib::Config fT0Config;
+    ApexVDCT0Calib fT0Calib;    //t0 histograms of all workers, combined
+
+public:
+    explicit ApexVDCReplayMT(const ApexVDCPlaneCalib& calib,
+                             unsigned int nthreads=0,
+                             long long block_size=256);
+
+    ~ApexVDCReplayMT() = default;
+
+    //pre-allocate space for this many hits & groups in each worker's ApexVDCPlaneEvent
+    void SetReserve(int nhits, int ngroups) { fHits_reserve = nhits; fGroups_reserve = ngroups; }
+
+    //fill the t0 histograms of each worker (with this setup) while decoding. the combined histograms 
+    // of each Run() are in GetT0Calib(). 
+    void EnableT0Calib(const ApexVDCT0Calib::Config& config) { fT0Enable = true; fT0Config = config; }
+
+    //decode events [0, nevents). returns the number of events decoded.
+    long long Run(long long nevents, const EventSource& source, const EventSink& sink);
+
+    unsigned int GetNThreads()  const { return fNThreads; }
+    long long    GetBlockSize() const { return fBlockSize; }
+
+    //statistics of the last call to Run()
+    long long    GetNEventsDecoded()    const { return fNEventsDecoded; }
+    unsigned int GetMaxHitsPerEvent()   const { return fMaxHitsPerEvent; }
+    unsigned int GetMaxGroupsPerEvent() const { return fMaxGroupsPerEvent; }
+    long long    GetNBlocksStolen()     const { return fNBlocksStolen; }
+    const ApexVDCPlaneStats& GetStats() const { return fStats; }
+    const ApexVDCT0Calib&    GetT0Calib() const { return fT0Calib; }
+};
+
+#endif
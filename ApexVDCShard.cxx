@@ -0,0 +1,518 @@
+#include "ApexVDCShard.h"
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <map>
+#include <dirent.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+using namespace std;
+
+namespace {
+
+    const char* const kPlanHeader   = "# ApexVDCShardPlan 1";
+    const char* const kReportHeader = "# ApexVDCShardReport 1";
+    const char* const kReportSuffix = "report.txt";
+
+    //the counters of ApexVDCPlaneStats, by the name they have in a report
+    const struct { const char* name; unsigned long long ApexVDCPlaneStats::* member; } kCounters[] = {
+        { "stats.nevents",              &ApexVDCPlaneStats::nevents },
+        { "stats.nevents_with_warnings",&ApexVDCPlaneStats::nevents_with_warnings },
+        { "stats.nhits_raw",            &ApexVDCPlaneStats::nhits_raw },
+        { "stats.nhits_accepted",       &ApexVDCPlaneStats::nhits_accepted },
+        { "stats.nhits_rejected_tdc",   &ApexVDCPlaneStats::nhits_rejected_tdc },
+        { "stats.nhits_rejected_time",  &ApexVDCPlaneStats::nhits_rejected_time },
+        { "stats.nevents_no_reftime",   &ApexVDCPlaneStats::nevents_no_reftime },
+        { "stats.nhits_masked",         &ApexVDCPlaneStats::nhits_masked },
+        { "stats.nhits_bad_channel",    &ApexVDCPlaneStats::nhits_bad_channel },
+        { "stats.nhits_missing_data",   &ApexVDCPlaneStats::nhits_missing_data },
+        { "stats.ngroups",              &ApexVDCPlaneStats::ngroups },
+    };
+    const struct { const char* name; double ApexVDCPlaneStats::* member; } kTimers[] = {
+        { "stats.time_decode",          &ApexVDCPlaneStats::time_decode },
+        { "stats.time_convert",         &ApexVDCPlaneStats::time_convert },
+        { "stats.time_sort",            &ApexVDCPlaneStats::time_sort },
+        { "stats.time_group",           &ApexVDCPlaneStats::time_group },
+        { "stats.time_output",          &ApexVDCPlaneStats::time_output },
+        { "stats.time_ttd",             &ApexVDCPlaneStats::time_ttd },
+        { "stats.time_fit",             &ApexVDCPlaneStats::time_fit },
+    };
+
+    //open a text file, and check its first line
+    void OpenText(ifstream& in, const string& path, const char* header, const char* here)
+    {
+        in.open(path);
+        string line;
+        if (!in || !getline(in, line) || line != header) {
+            ostringstream oss;
+            oss << "in <" << here << ">: '" << path << "' is missing, or is not a " << (header + 2) << " file.";
+            throw runtime_error(oss.str());
+        }
+    }
+
+    //a line of a text file which could not be parsed
+    [[noreturn]] void BadLine(const string& path, const string& line, const char* here)
+    {
+        ostringstream oss;
+        oss << "in <" << here << ">: can't parse line '" << line << "' of '" << path << "'.";
+        throw runtime_error(oss.str());
+    }
+
+    //mkdir -p
+    void MakeDirs(const string& path, const char* here)
+    {
+        for (size_t pos = 1; pos <= path.size(); pos++) {
+            if (pos < path.size() && path[pos] != '/') continue;
+            const string dir = path.substr(0, pos);
+            if (mkdir(dir.c_str(), 0775) == 0) continue;
+
+            //(something which is already there must be a directory)
+            struct stat st;
+            if (errno == EEXIST && stat(dir.c_str(), &st) == 0 && S_ISDIR(st.st_mode)) continue;
+            if (errno == EEXIST) errno = ENOTDIR;
+
+            ostringstream oss;
+            oss << "in <" << here << ">: can't create directory '" << dir << "' (" << strerror(errno) << ").";
+            throw runtime_error(oss.str());
+        }
+    }
+
+    void ReplaceAll(string& str, const string& from, const string& to)
+    {
+        for (size_t pos = str.find(from); pos != string::npos; pos = str.find(from, pos + to.size()))
+            str.replace(pos, from.size(), to);
+    }
+}
+
+//______________________________________________________________________________________________________
+ApexVDCShardPlan ApexVDCShardPlan::Make(const string& run, const vector<uint32_t>& evnums, int nshards, long long min_events)
+{
+    const char* const here = "ApexVDCShardPlan::Make";
+
+    const long long n = evnums.size();
+
+    if (n == 0 || nshards <= 0) {
+        ostringstream oss;
+        oss << "in <" << here << ">: can't split " << n << " events of '" << run << "' into " << nshards << " shards.";
+        throw invalid_argument(oss.str());
+    }
+
+    //no more shards than we can fill with 'min_events' events each
+    const long long max_shards = max(1LL, n / max(1LL, min_events));
+    nshards = (int)min<long long>(nshards, max_shards);
+
+    ApexVDCShardPlan plan;
+    plan.run     = run;
+    plan.nevents = n;
+
+    for (int i=0; i<nshards; i++) {
+        Shard shard;
+        shard.index       = i;
+        shard.first       = (n * i) / nshards + 1;
+        shard.last        = (n * (i+1)) / nshards;
+        shard.first_evnum = evnums[shard.first - 1];
+        shard.last_evnum  = evnums[shard.last - 1];
+        plan.shards.push_back(shard);
+    }
+
+    return plan;
+}
+
+//______________________________________________________________________________________________________
+void ApexVDCShardPlan::Write(const string& path) const
+{
+    const char* const here = "ApexVDCShardPlan::Write";
+
+    ofstream out(path);
+
+    out << kPlanHeader << "\n";
+    out << "run " << run << "\n";
+    out << "nevents " << nevents << "\n";
+    out << "# shard first last first_evnum last_evnum\n";
+    for (const Shard& shard : shards)
+        out << "shard " << shard.index << " " << shard.first << " " << shard.last << " "
+            << shard.first_evnum << " " << shard.last_evnum << "\n";
+
+    if (!out) {
+        ostringstream oss;
+        oss << "in <" << here << ">: can't write '" << path << "'.";
+        throw runtime_error(oss.str());
+    }
+}
+
+//______________________________________________________________________________________________________
+ApexVDCShardPlan ApexVDCShardPlan::Read(const string& path)
+{
+    const char* const here = "ApexVDCShardPlan::Read";
+
+    ifstream in;
+    OpenText(in, path, kPlanHeader, here);
+
+    ApexVDCShardPlan plan;
+    string line;
+
+    while (getline(in, line)) {
+
+        if (line.empty() || line[0] == '#') continue;
+
+        istringstream iss(line);
+        string key;
+        iss >> key;
+
+        if (key == "run") {
+            getline(iss >> ws, plan.run);
+        } else if (key == "nevents") {
+            if (!(iss >> plan.nevents)) BadLine(path, line, here);
+        } else if (key == "shard") {
+            Shard shard;
+            if (!(iss >> shard.index >> shard.first >> shard.last >> shard.first_evnum >> shard.last_evnum))
+                BadLine(path, line, here);
+            plan.shards.push_back(shard);
+        } else {
+            BadLine(path, line, here);
+        }
+    }
+
+    //the shards must cover all events, in order, without gaps or overlaps
+    long long next = 1;
+    for (size_t i=0; i<plan.shards.size(); i++) {
+        const Shard& shard = plan.shards[i];
+        if (shard.index != (int)i || shard.first != next || shard.last < shard.first) {
+            ostringstream oss;
+            oss << "in <" << here << ">: shard " << shard.index << " of '" << path << "' covers events ["
+                << shard.first << "," << shard.last << "], but should start with event " << next << ".";
+            throw runtime_error(oss.str());
+        }
+        next = shard.last + 1;
+    }
+    if (plan.shards.empty() || next != plan.nevents + 1) {
+        ostringstream oss;
+        oss << "in <" << here << ">: the shards of '" << path << "' cover " << next-1 << " of " << plan.nevents << " events.";
+        throw runtime_error(oss.str());
+    }
+
+    return plan;
+}
+
+//______________________________________________________________________________________________________
+ApexVDCShardReport& ApexVDCShardReport::operator+=(const ApexVDCShardReport& rhs)
+{
+    if (nevents_decoded == 0) first_evnum = rhs.first_evnum;
+    if (rhs.nevents_decoded > 0) last_evnum = rhs.last_evnum;
+
+    nevents_decoded += rhs.nevents_decoded;
+    max_hits         = max(max_hits,   rhs.max_hits);
+    max_groups       = max(max_groups, rhs.max_groups);
+    nevents_grouped += rhs.nevents_grouped;
+    stats           += rhs.stats;
+
+    return *this;
+}
+
+//______________________________________________________________________________________________________
+void ApexVDCShardReport::Write(const string& path) const
+{
+    const char* const here = "ApexVDCShardReport::Write";
+
+    ofstream out(path);
+    out.precision(17);
+
+    out << kReportHeader << "\n";
+    out << "plane " << plane << "\n";
+    out << "nevents_decoded " << nevents_decoded << "\n";
+    out << "first_evnum " << first_evnum << "\n";
+    out << "last_evnum " << last_evnum << "\n";
+    out << "max_hits " << max_hits << "\n";
+    out << "max_groups " << max_groups << "\n";
+    out << "nevents_grouped " << nevents_grouped << "\n";
+
+    for (const auto& c : kCounters) out << c.name << " " << stats.*c.member << "\n";
+    for (const auto& t : kTimers)   out << t.name << " " << stats.*t.member << "\n";
+
+    out << "stats.hits_hist";
+    for (unsigned long long count : stats.hits_hist) out << " " << count;
+    out << "\n";
+
+    if (!out) {
+        ostringstream oss;
+        oss << "in <" << here << ">: can't write '" << path << "'.";
+        throw runtime_error(oss.str());
+    }
+}
+
+//______________________________________________________________________________________________________
+ApexVDCShardReport ApexVDCShardReport::Read(const string& path)
+{
+    const char* const here = "ApexVDCShardReport::Read";
+
+    ifstream in;
+    OpenText(in, path, kReportHeader, here);
+
+    ApexVDCShardReport report;
+    string line;
+
+    while (getline(in, line)) {
+
+        if (line.empty() || line[0] == '#') continue;
+
+        istringstream iss(line);
+        string key;
+        iss >> key;
+
+        bool ok = true;
+
+        if      (key == "plane")            ok = bool(iss >> report.plane);
+        else if (key == "nevents_decoded")  ok = bool(iss >> report.nevents_decoded);
+        else if (key == "first_evnum")      ok = bool(iss >> report.first_evnum);
+        else if (key == "last_evnum")       ok = bool(iss >> report.last_evnum);
+        else if (key == "max_hits")         ok = bool(iss >> report.max_hits);
+        else if (key == "max_groups")       ok = bool(iss >> report.max_groups);
+        else if (key == "nevents_grouped")  ok = bool(iss >> report.nevents_grouped);
+        else if (key == "stats.hits_hist") {
+            for (unsigned long long& count : report.stats.hits_hist) ok = ok && bool(iss >> count);
+        } else {
+            ok = false;
+            for (const auto& c : kCounters) if (key == c.name) ok = bool(iss >> report.stats.*c.member);
+            for (const auto& t : kTimers)   if (key == t.name) ok = bool(iss >> report.stats.*t.member);
+        }
+
+        if (!ok) BadLine(path, line, here);
+    }
+
+    return report;
+}
+
+//______________________________________________________________________________________________________
+const char* const ApexVDCShard::kDirVariable = "APEXVDC_SHARD_DIR";
+
+//______________________________________________________________________________________________________
+string ApexVDCShard::GetDirectory()
+{
+    const char* dir = getenv(kDirVariable);
+    return dir ? dir : "";
+}
+
+//______________________________________________________________________________________________________
+string ApexVDCShard::MakeShardDir(const string& dir, int index)
+{
+    char name[32];
+    snprintf(name, sizeof(name), "shard_%04d", index);
+    return dir + "/" + name;
+}
+
+//______________________________________________________________________________________________________
+string ApexVDCShard::MakeReportPath(const string& shard_dir, const string& plane)
+{
+    return shard_dir + "/" + plane + kReportSuffix;
+}
+
+//______________________________________________________________________________________________________
+string ApexVDCShard::Substitute(const string& arg, const ApexVDCShardPlan& plan,
+                                const ApexVDCShardPlan::Shard& shard, const string& shard_dir)
+{
+    string out = arg;
+    ReplaceAll(out, "{shard}",       to_string(shard.index));
+    ReplaceAll(out, "{first}",       to_string(shard.first));
+    ReplaceAll(out, "{last}",        to_string(shard.last));
+    ReplaceAll(out, "{first_evnum}", to_string(shard.first_evnum));
+    ReplaceAll(out, "{last_evnum}",  to_string(shard.last_evnum));
+    ReplaceAll(out, "{nevents}",     to_string(shard.GetNEvents()));
+    ReplaceAll(out, "{run}",         plan.run);
+    ReplaceAll(out, "{dir}",         shard_dir);
+    return out;
+}
+
+//______________________________________________________________________________________________________
+int ApexVDCShard::Launch(const ApexVDCShardPlan& plan, const vector<string>& command, const string& dir,
+                         int njobs, const vector<int>& which, const function<void(int, int)>& done)
+{
+    const char* const here = "ApexVDCShard::Launch";
+
+    if (command.empty()) {
+        ostringstream oss;
+        oss << "in <" << here << ">: no command given.";
+        throw invalid_argument(oss.str());
+    }
+
+    //the shards to run
+    vector<int> todo = which;
+    if (todo.empty()) for (const auto& shard : plan.shards) todo.push_back(shard.index);
+
+    for (int index : todo) {
+        if (index < 0 || index >= (int)plan.shards.size()) {
+            ostringstream oss;
+            oss << "in <" << here << ">: there is no shard " << index << " (the plan has " << plan.shards.size() << ").";
+            throw out_of_range(oss.str());
+        }
+    }
+
+    njobs = max(1, njobs);
+
+    map<pid_t, int> running;    //pid -> shard
+    int nfailed = 0;
+
+    //wait for any one worker to finish. waitpid() is retried if a signal interrupts it; any other error 
+    // (e.g. ECHILD: the workers were reaped by someone else, or SIGCHLD is ignored) would make us wait 
+    // forever, so it is fatal. 
+    auto wait_one = [&]() {
+        int wstatus = 0;
+        pid_t pid;
+        while ((pid = waitpid(-1, &wstatus, 0)) < 0) {
+            if (errno == EINTR) continue;
+            ostringstream oss;
+            oss << "in <" << here << ">: can't wait for the workers (" << strerror(errno) << "), with "
+                << running.size() << " of them still running.";
+            throw runtime_error(oss.str());
+        }
+
+        //(some other child of this process)
+        auto it = running.find(pid);
+        if (it == running.end()) return;
+
+        const int status = WIFEXITED(wstatus) ? WEXITSTATUS(wstatus) : 128 + WTERMSIG(wstatus);
+        const int index  = it->second;
+        running.erase(it);
+
+        if (status != 0) nfailed++;
+        if (done) done(index, status);
+    };
+
+    try {
+        for (int index : todo) {
+
+            while ((int)running.size() >= njobs) wait_one();
+
+            const ApexVDCShardPlan::Shard& shard = plan.shards[index];
+            const string shard_dir = MakeShardDir(dir, index);
+            MakeDirs(shard_dir, here);
+
+            //build the arguments before forking, so that the child only has to exec
+            vector<string> args;
+            for (const string& arg : command) args.push_back(Substitute(arg, plan, shard, shard_dir));
+
+            vector<char*> argv;
+            for (string& arg : args) argv.push_back(&arg[0]);
+            argv.push_back(nullptr);
+
+            const string log_path = shard_dir + "/log.txt";
+
+            fflush(stdout);
+            fflush(stderr);
+
+            const pid_t pid = fork();
+
+            if (pid < 0) {
+                ostringstream oss;
+                oss << "in <" << here << ">: can't start shard " << index << " (" << strerror(errno) << ").";
+                throw runtime_error(oss.str());
+            }
+
+            if (pid == 0) {
+                //child: log to the shard's directory, tell the planes where to write their reports, and run
+                const int fd = open(log_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0664);
+                if (fd >= 0) { dup2(fd, STDOUT_FILENO); dup2(fd, STDERR_FILENO); close(fd); }
+
+                setenv(kDirVariable, shard_dir.c_str(), 1);
+
+                execvp(argv[0], argv.data());
+
+                fprintf(stderr, "can't run '%s': %s\n", argv[0], strerror(errno));
+                _exit(127);
+            }
+
+            running[pid] = index;
+        }
+
+        while (!running.empty()) wait_one();
+
+    } catch (...) {
+        //don't leave the workers which were already started running (or as zombies) behind us: stop 
+        // them, and reap them, before giving up 
+        for (const auto& worker : running) kill(worker.first, SIGTERM);
+        for (const auto& worker : running) while (waitpid(worker.first, nullptr, 0) < 0 && errno == EINTR) {}
+        throw;
+    }
+
+    return nfailed;
+}
+
+//______________________________________________________________________________________________________
+vector<ApexVDCShardReport> ApexVDCShard::MergeReports(const ApexVDCShardPlan& plan, const string& dir)
+{
+    const char* const here = "ApexVDCShard::MergeReports";
+
+    //the planes are the ones which wrote a report for the first shard
+    vector<string> planes;
+    {
+        const string shard_dir = MakeShardDir(dir, 0);
+        DIR* d = opendir(shard_dir.c_str());
+        if (!d) {
+            ostringstream oss;
+            oss << "in <" << here << ">: can't read directory '" << shard_dir << "'.";
+            throw runtime_error(oss.str());
+        }
+
+        const size_t nsuffix = strlen(kReportSuffix);
+        while (const dirent* entry = readdir(d)) {
+            const string name = entry->d_name;
+            if (name.size() > nsuffix && name.compare(name.size() - nsuffix, nsuffix, kReportSuffix) == 0)
+                planes.push_back(name.substr(0, name.size() - nsuffix));
+        }
+        closedir(d);
+
+        sort(planes.begin(), planes.end());
+    }
+
+    if (planes.empty()) {
+        ostringstream oss;
+        oss << "in <" << here << ">: no plane reports in '" << MakeShardDir(dir, 0) << "'. (was the replay "
+               "run with " << kDirVariable << " set?)";
+        throw runtime_error(oss.str());
+    }
+
+    vector<ApexVDCShardReport> merged(planes.size());
+
+    for (size_t p=0; p<planes.size(); p++) {
+
+        merged[p].plane = planes[p];
+
+        for (const auto& shard : plan.shards) {
+
+            const string path = MakeReportPath(MakeShardDir(dir, shard.index), planes[p]);
+            const ApexVDCShardReport report = ApexVDCShardReport::Read(path);
+
+            //each plane must have decoded exactly the events of this shard
+            if (report.nevents_decoded != shard.GetNEvents() ||
+                report.first_evnum != shard.first_evnum || report.last_evnum != shard.last_evnum) {
+                ostringstream oss;
+                oss << "in <" << here << ">: plane '" << planes[p] << "' decoded " << report.nevents_decoded
+                    << " events (event numbers " << report.first_evnum << " to " << report.last_evnum << ") in shard "
+                    << shard.index << ", but the shard has " << shard.GetNEvents() << " events (event numbers "
+                    << shard.first_evnum << " to " << shard.last_evnum << ").";
+                throw runtime_error(oss.str());
+            }
+
+            merged[p] += report;
+        }
+
+        if (merged[p].nevents_decoded != plan.nevents) {
+            ostringstream oss;
+            oss << "in <" << here << ">: plane '" << planes[p] << "' decoded " << merged[p].nevents_decoded
+                << " events in all, but the run has " << plan.nevents << ".";
+            throw logic_error(oss.str());
+        }
+    }
+
+    return merged;
+}
+//______________________________________________________________________________________________________
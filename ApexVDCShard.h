@@ -0,0 +1,124 @@
+#ifndef ApexVDCShard_H
+#define ApexVDCShard_H
+////////////////////////////////////////////////////////////////////////////////////////
+//
+//  namespace: ApexVDCShard
+//  Splitting one CODA run into 'shards' (ranges of events) which are replayed by
+//  separate processes, and putting the results back together. This is what
+//  ApexOfflineShardedReplay (see tools/) is built on.
+//
+//   1. plan:   the run is scanned once for its physics events (an 'index': the event
+//              number of each physics event, in the order they are in the file), and
+//              split into shards of (nearly) the same number of physics events. The
+//              plan is a small text file (see ApexVDCShardPlan), so that the workers on
+//              other nodes (sharing a filesystem) can read it.
+//   2. launch: each shard is replayed by running a command (e.g. the analyzer with a
+//              replay script), in which '{first}', '{last}', ... are replaced by the
+//              range of the shard (see Launch()). Each worker runs with the environment
+//              variable APEXVDC_SHARD_DIR set to its own directory, in which each plane
+//              writes a report of what it decoded at the end of the run (see
+//              ApexVDCShardReport, and ApexVDCPlane::End()), and where its output goes.
+//   3. merge:  the reports of all shards are checked against the plan (every plane must
+//              have decoded exactly the physics events of its shard, from the first
+//              event number of the shard to the last), and the counters of each plane
+//              are summed over the shards (see MergeReports()). The output files are
+//              then merged in shard order, so that the merged output has the original
+//              event order.
+//
+//  Nothing here needs more than POSIX (fork/exec & the filesystem), so it works the same
+//  on one multi-core box as on a farm.
+//
+//  This does not depend on Podd or ROOT, so that it can be used outside of the analyzer.
+//
+//  - Seth H 28 Sep 25
+////////////////////////////////////////////////////////////////////////////////////////
+
+#include "ApexVDCPlaneStats.h"
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <functional>
+
+//how one run is split into shards
+struct ApexVDCShardPlan {
+
+    struct Shard {
+        int         index       = 0;
+        long long   first       = 0;    //first & last physics event of this shard, counting the physics
+        long long   last        = 0;    // events of the run from 1 (inclusive)
+        uint32_t    first_evnum = 0;    //event numbers of those events
+        uint32_t    last_evnum  = 0;
+
+        long long GetNEvents() const { return last - first + 1; }
+    };
+
+    std::string         run;            //path of the CODA file
+    long long           nevents = 0;    //number of physics events in the run
+    std::vector<Shard>  shards;
+
+    //split a run with physics events of these event numbers (in file order) into 'nshards' shards,
+    // of at least 'min_events' events each (so there may be fewer shards). throws if there are no events.
+    static ApexVDCShardPlan Make(const std::string& run, const std::vector<uint32_t>& evnums,
+                                 int nshards, long long min_events=1);
+
+    //write/read the plan as text. Read() throws if the file is missing or malformed.
+    void Write(const std::string& path) const;
+    static ApexVDCShardPlan Read(const std::string& path);
+};
+
+//what one plane decoded in one shard (or, once merged, in the whole run)
+struct ApexVDCShardReport {
+    std::string         plane;                  //the plane's prefix, e.g. "R.vdc.u1."
+    long long           nevents_decoded = 0;    //number of (physics) events decoded
+    uint32_t            first_evnum     = 0;    //event number of the first & last event decoded
+    uint32_t            last_evnum      = 0;
+    unsigned int        max_hits        = 0;    //high-water marks
+    unsigned int        max_groups      = 0;
+    long long           nevents_grouped = 0;    //number of events whose hits were grouped (max_groups is
+                                                // only measured in these)
+    ApexVDCPlaneStats   stats;                  //timing & rate counters (only filled in instrumented builds)
+
+    //add the report of the next shard (in event order)
+    ApexVDCShardReport& operator+=(const ApexVDCShardReport& rhs);
+
+    //write/read a report as text ('key value' lines). Read() throws if the file is missing or malformed.
+    void Write(const std::string& path) const;
+    static ApexVDCShardReport Read(const std::string& path);
+};
+
+namespace ApexVDCShard {
+
+    //name of the environment variable with the directory of the current shard
+    extern const char* const kDirVariable;
+
+    //directory of the shard this process is replaying (from APEXVDC_SHARD_DIR). empty if none.
+    std::string GetDirectory();
+
+    //directory of shard 'index' in the work directory 'dir'
+    std::string MakeShardDir(const std::string& dir, int index);
+
+    //path of the report of a plane (with prefix 'plane') in a shard directory
+    std::string MakeReportPath(const std::string& shard_dir, const std::string& plane);
+
+    //replace the placeholders '{shard}', '{first}', '{last}', '{first_evnum}', '{last_evnum}',
+    // '{nevents}', '{run}' & '{dir}' (the shard's directory) in 'arg'
+    std::string Substitute(const std::string& arg, const ApexVDCShardPlan& plan,
+                           const ApexVDCShardPlan::Shard& shard, const std::string& shard_dir);
+
+    //run 'command' (after Substitute()) once for each of the shards 'which' of 'plan' (all of them if
+    // empty), at most 'njobs' at a time. each runs in its own directory under 'dir' (which is created),
+    // with its stdout & stderr in 'log.txt' there. 'done' (if given) is called with the index & exit
+    // status of each shard as it finishes (128 + the signal, if it was killed). returns the number of
+    // shards which failed. throws if a shard's directory can't be made, a process can't be started, or 
+    // the workers can't be waited for; the workers which are still running are then killed first.
+    int Launch(const ApexVDCShardPlan& plan, const std::vector<std::string>& command,
+               const std::string& dir, int njobs, const std::vector<int>& which={},
+               const std::function<void(int, int)>& done=nullptr);
+
+    //read the reports of all planes from the directory of each shard of 'plan' under 'dir', check each
+    // against its shard, and add them up (in shard order). returns one merged report per plane. throws
+    // if any report is missing, or does not match its shard.
+    std::vector<ApexVDCShardReport> MergeReports(const ApexVDCShardPlan& plan, const std::string& dir);
+}
+
+#endif
@@ -0,0 +1,152 @@
+#ifndef ApexVDCSpan_H
+#define ApexVDCSpan_H
+////////////////////////////////////////////////////////////////////////////////////////
+//
+//  class: ApexVDCSpan<T>, ApexVDCGroupView, ApexVDCGroupRange
+//  Read-only views of the wires, hits & groups of a VDC plane, which neither copy nor
+//  allocate anything.
+//
+//  ApexVDCSpan<T> is just a pointer & a size, over a contiguous array of T's (like C++20's
+//  std::span<const T>). ApexVDCGroupView is one group, along with the hit list it indexes
+//  into, so that the hits of a group can be looped over directly. ApexVDCGroupRange is all
+//  groups of an event, as ApexVDCGroupViews:
+//
+//      for (const ApexVDCGroupView group : plane->GetGroupRange()) {
+//          for (const ApexVDCHit& hit : group) { ... }
+//      }
+//
+//  A view does not own what it looks at, so it is only valid for as long as that does not
+//  change: the views of hits & groups until the next event is decoded (or the plane is
+//  cleared), and the view of the wires until the DB is read again.
+//
+//  This does not depend on Podd or ROOT, so that it can be used outside of the analyzer.
+//
+//  - Seth H 28 Sep 25
+////////////////////////////////////////////////////////////////////////////////////////
+
+#include "ApexVDCHit.h"
+#include "ApexVDCHitGroup.h"
+#include <vector>
+#include <cstddef>
+#include <iterator>
+#include <stdexcept>
+#include <sstream>
+
+template<typename T> class ApexVDCSpan {
+
+private:
+    const T*    fData = nullptr;
+    std::size_t fSize = 0;
+
+public:
+    using value_type     = T;
+    using const_iterator = const T*;
+    using iterator       = const T*;
+
+    ApexVDCSpan() noexcept = default;
+    ApexVDCSpan(const T* data, std::size_t size) noexcept : fData(data), fSize(size) {}
+
+    //view of all elements of a vector
+    template<typename Alloc> ApexVDCSpan(const std::vector<T, Alloc>& vec) noexcept
+        : fData(vec.data()), fSize(vec.size()) {}
+
+    const T* begin() const noexcept { return fData; }
+    const T* end()   const noexcept { return fData + fSize; }
+    const T* data()  const noexcept { return fData; }
+
+    std::size_t size()  const noexcept { return fSize; }
+    bool        empty() const noexcept { return fSize == 0; }
+
+    const T& operator[](std::size_t i) const noexcept { return fData[i]; }
+    const T& front() const noexcept { return fData[0]; }
+    const T& back()  const noexcept { return fData[fSize-1]; }
+
+    //same as operator[], but throws if 'i' is out of range
+    const T& at(std::size_t i) const
+    {
+        if (i >= fSize) {
+            std::ostringstream oss;
+            oss << "in <ApexVDCSpan::at>: index " << i << " is out of range (size " << fSize << ").";
+            throw std::out_of_range(oss.str());
+        }
+        return fData[i];
+    }
+
+    //view of 'count' elements, starting at 'offset'. (the range must be inside of this one)
+    ApexVDCSpan subspan(std::size_t offset, std::size_t count) const noexcept { return {fData + offset, count}; }
+};
+
+//______________________________________________________________________________________________________
+class ApexVDCGroupView {
+
+private:
+    const ApexVDCHitGroup* fGroup;
+    const ApexVDCHit*      fHits;       //the (sorted) hit list which the group indexes into
+
+public:
+    ApexVDCGroupView(const ApexVDCHitGroup& group, const ApexVDCHit* hits) noexcept
+        : fGroup(&group), fHits(hits) {}
+
+    const ApexVDCHitGroup& GetGroup() const noexcept { return *fGroup; }
+
+    int GetStart() const noexcept { return fGroup->start; }
+    int GetEnd()   const noexcept { return fGroup->end; }
+    int GetSpan()  const noexcept { return fGroup->span; }
+    int GetNHits() const noexcept { return fGroup->GetNHits(); }
+
+    //the hits of this group, in order of wire number (and time, on the same wire)
+    ApexVDCSpan<ApexVDCHit> GetHits() const noexcept { return {fHits + fGroup->start, (std::size_t)fGroup->GetNHits()}; }
+    const ApexVDCHit&       GetHit(int i) const noexcept { return fHits[fGroup->start + i]; }
+
+    const ApexVDCHit* begin() const noexcept { return fHits + fGroup->start; }
+    const ApexVDCHit* end()   const noexcept { return fHits + fGroup->end + 1; }
+};
+
+//______________________________________________________________________________________________________
+class ApexVDCGroupRange {
+
+private:
+    ApexVDCSpan<ApexVDCHitGroup> fGroups;
+    const ApexVDCHit*            fHits = nullptr;
+
+public:
+    class iterator {
+    private:
+        const ApexVDCHitGroup* fGroup;
+        const ApexVDCHit*      fHits;
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type        = ApexVDCGroupView;
+        using reference         = ApexVDCGroupView;
+        using pointer           = void;
+        using difference_type   = std::ptrdiff_t;
+
+        iterator(const ApexVDCHitGroup* group, const ApexVDCHit* hits) noexcept : fGroup(group), fHits(hits) {}
+
+        ApexVDCGroupView operator*() const noexcept { return {*fGroup, fHits}; }
+
+        iterator& operator++() noexcept { ++fGroup; return *this; }
+        iterator  operator++(int) noexcept { iterator it = *this; ++fGroup; return it; }
+
+        bool operator==(const iterator& rhs) const noexcept { return fGroup == rhs.fGroup; }
+        bool operator!=(const iterator& rhs) const noexcept { return fGroup != rhs.fGroup; }
+    };
+    using const_iterator = iterator;
+
+    ApexVDCGroupRange() noexcept = default;
+    ApexVDCGroupRange(ApexVDCSpan<ApexVDCHitGroup> groups, const ApexVDCHit* hits) noexcept
+        : fGroups(groups), fHits(hits) {}
+
+    iterator begin() const noexcept { return {fGroups.begin(), fHits}; }
+    iterator end()   const noexcept { return {fGroups.end(),   fHits}; }
+
+    std::size_t size()  const noexcept { return fGroups.size(); }
+    bool        empty() const noexcept { return fGroups.empty(); }
+
+    ApexVDCGroupView operator[](std::size_t i) const noexcept { return {fGroups[i], fHits}; }
+
+    //the groups themselves (index ranges into the hit list)
+    ApexVDCSpan<ApexVDCHitGroup> GetGroups() const noexcept { return fGroups; }
+};
+
+#endif
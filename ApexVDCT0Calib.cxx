@@ -0,0 +1,185 @@
+#include "ApexVDCT0Calib.h"
+#include <algorithm>
+#include <stdexcept>
+#include <sstream>
+#include <limits>
+
+using namespace std;
+
+//______________________________________________________________________________________________________
+void ApexVDCT0Calib::Init(const Config& config, int nwires)
+{
+    const char* const here = "ApexVDCT0Calib::Init";
+
+    if (config.raw_max <= config.raw_min || config.bin_shift < 0 || config.bin_shift > 16 || nwires <= 0) {
+        ostringstream oss;
+        oss << "in <" << here << ">: invalid setup (raw range [" << config.raw_min << "," << config.raw_max << "), "
+               "bin shift " << config.bin_shift << ", " << nwires << " wires).";
+        throw invalid_argument(oss.str());
+    }
+
+    fConfig = config;
+    fNWires = nwires;
+    fNBins  = ((config.raw_max - config.raw_min) + (1 << config.bin_shift) - 1) >> config.bin_shift;
+
+    //one extra (trash) bin per wire, and round each row up to a whole number of cache lines
+    const int per_line = 64 / sizeof(uint32_t);
+    fStride = ((fNBins + 1 + per_line - 1) / per_line) * per_line;
+
+    fCounts.assign((size_t)fNWires * fStride, 0);
+}
+
+//______________________________________________________________________________________________________
+void ApexVDCT0Calib::Reset()
+{
+    fill(fCounts.begin(), fCounts.end(), 0);
+}
+
+//______________________________________________________________________________________________________
+ApexVDCT0Calib& ApexVDCT0Calib::operator+=(const ApexVDCT0Calib& rhs)
+{
+    const char* const here = "ApexVDCT0Calib::operator+=";
+
+    if (rhs.fNWires != fNWires || rhs.fNBins != fNBins || rhs.fConfig.raw_min != fConfig.raw_min ||
+        rhs.fConfig.bin_shift != fConfig.bin_shift) {
+        ostringstream oss;
+        oss << "in <" << here << ">: can't add histograms with a different setup.";
+        throw logic_error(oss.str());
+    }
+
+    for (size_t i=0; i<fCounts.size(); i++) fCounts[i] += rhs.fCounts[i];
+
+    return *this;
+}
+
+//______________________________________________________________________________________________________
+ApexVDCT0Calib::Edge ApexVDCT0Calib::FindEdge(int wire) const
+{
+    Edge edge;
+
+    const uint32_t* counts = fCounts.data() + (size_t)wire*fStride;
+    const double    width  = (double)(1 << fConfig.bin_shift);
+
+    for (int b=0; b<fNBins; b++) edge.entries += counts[b];
+
+    if (edge.entries < fConfig.min_entries) { edge.quality = kLowStats; return edge; }
+
+    //smooth the spectrum
+    const int half = max(0, fConfig.nsmooth/2);
+    vector<double> smooth(fNBins);
+
+    for (int b=0; b<fNBins; b++) {
+        const int lo = max(0, b - half), hi = min(fNBins-1, b + half);
+        double sum = 0.;
+        for (int k=lo; k<=hi; k++) sum += counts[k];
+        smooth[b] = sum / (hi - lo + 1);
+    }
+
+    //background, from the top of the range
+    const int nbg = min(fNBins, max(1, fConfig.nbackground));
+    double background = 0.;
+    for (int b=fNBins-nbg; b<fNBins; b++) background += counts[b];
+    background /= nbg;
+
+    //raw TDC value where the spectrum first rises above 'fraction' of the way from the background to
+    // 'plateau', going down from the top of the range. NaN if it is above that at the top already.
+    auto crossing = [&](double plateau, double fraction) {
+        const double level = background + fraction*(plateau - background);
+
+        if (smooth[fNBins-1] >= level) return numeric_limits<double>::quiet_NaN();
+
+        int b = fNBins-2;
+        while (b >= 0 && smooth[b] < level) b--;
+        if (b < 0) return numeric_limits<double>::quiet_NaN();
+
+        //interpolate between the centers of bins b (above the level) and b+1 (below it)
+        const double frac = (smooth[b] - level) / (smooth[b] - smooth[b+1]);
+        return GetBinLow(b) + width*(0.5 + frac);
+    };
+
+    //first, find the edge roughly, with the largest count as the plateau
+    double plateau = *max_element(smooth.begin(), smooth.end());
+    if (plateau <= background) { edge.quality = kNoEdge; return edge; }
+
+    double x50 = crossing(plateau, 0.5);
+    if (x50 != x50) { edge.quality = kNoEdge; return edge; }
+
+    //then, take the mean count just below the edge (past the smoothing) as the plateau, and find it again
+    const int last  = (int)((x50 - fConfig.raw_min) / width) - max(1, fConfig.nsmooth);
+    const int first = max(0, last - max(1, fConfig.nplateau) + 1);
+
+    if (last >= first) {
+        plateau = 0.;
+        for (int b=first; b<=last; b++) plateau += counts[b];
+        plateau /= (last - first + 1);
+    }
+    if (plateau <= background) { edge.quality = kNoEdge; return edge; }
+
+    x50 = crossing(plateau, 0.5);
+    if (x50 != x50) { edge.quality = kNoEdge; return edge; }
+
+    edge.raw   = x50;
+    edge.width = crossing(plateau, 0.1) - crossing(plateau, 0.9);
+
+    //(a NaN width means the 10% or 90% point could not be found, so the edge is not clean either)
+    edge.quality = (edge.width <= fConfig.max_width) ? kGood : kWideEdge;
+
+    return edge;
+}
+
+//______________________________________________________________________________________________________
+int ApexVDCT0Calib::Fit(double tdc_resolution, const vector<unsigned char>& bad,
+                        vector<double>& offsets, vector<int>& quality) const
+{
+    const char* const here = "ApexVDCT0Calib::Fit";
+
+    if (offsets.size() != (size_t)fNWires) {
+        ostringstream oss;
+        oss << "in <" << here << ">: got " << offsets.size() << " offsets for " << fNWires << " wires.";
+        throw invalid_argument(oss.str());
+    }
+
+    quality.assign(fNWires, kGood);
+    int ngood = 0;
+
+    for (int wire=0; wire<fNWires; wire++) {
+
+        if (!bad.empty() && bad[wire]) { quality[wire] = kBadWire; continue; }
+
+        const Edge edge = FindEdge(wire);
+        quality[wire] = edge.quality;
+
+        if (edge.quality == kGood) {
+            offsets[wire] = tdc_resolution * edge.raw;
+            ngood++;
+        }
+    }
+
+    return ngood;
+}
+
+//______________________________________________________________________________________________________
+void ApexVDCT0Calib::WriteDB(FILE* file, const char* prefix, const char* timestamp,
+                             const vector<double>& offsets, const vector<int>& quality)
+{
+    const int nwires = offsets.size();
+    const int ngood  = count(quality.begin(), quality.end(), (int)kGood);
+    const int kPerLine = 8;
+
+    if (timestamp && *timestamp) fprintf(file, "[ %s ]\n\n", timestamp);
+
+    fprintf(file, "# timing offsets from the leading edge of each wire's TDC spectrum: %d of %d wires good.\n", ngood, nwires);
+    fprintf(file, "# quality: 0 = good, 1 = too few hits, 2 = no edge, 3 = edge too wide, 4 = bad wire.\n");
+    fprintf(file, "# wires which are not good keep the offset they had.\n");
+
+    fprintf(file, "%stdc.offsets =\n", prefix);
+    for (int i=0; i<nwires; i++)
+        fprintf(file, "%s%.6e%s", i % kPerLine ? " " : "  ", offsets[i], (i+1) % kPerLine && i+1 < nwires ? "" : "\n");
+
+    fprintf(file, "%stdc.offsets.quality =\n", prefix);
+    for (int i=0; i<nwires; i++)
+        fprintf(file, "%s%d%s", i % kPerLine ? " " : "  ", quality[i], (i+1) % kPerLine && i+1 < nwires ? "" : "\n");
+
+    fprintf(file, "\n");
+}
+//______________________________________________________________________________________________________
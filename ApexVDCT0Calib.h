@@ -0,0 +1,166 @@
+#ifndef ApexVDCT0Calib_H
+#define ApexVDCT0Calib_H
+////////////////////////////////////////////////////////////////////////////////////////
+//
+//  class: ApexVDCT0Calib
+//  Timing-offset (t0) calibration of the wires of one VDC plane, from the hits of a normal
+//  replay, so that the TDC offsets don't need a separate pass over the data.
+//
+//  While decoding, the raw TDC value of every raw hit is counted in a per-wire histogram
+//  (before the TDC window & wire mask, so that the whole spectrum is seen). If the event
+//  has a reference time, the raw values are first shifted by it, so that the spectra are
+//  those of the times relative to the reference. Filling costs one increment per hit: the
+//  bin is computed without a branch, and hits outside of the histogram range go to a
+//  'trash' bin which is never looked at.
+//
+//  Each thread fills its own ApexVDCT0Calib (see ApexVDCReplayMT::EnableT0Calib()), and
+//  they are added together at the end of the run with operator+=. The counts are 32-bit
+//  integers, and each wire's row of bins starts on its own 64-byte cache line, so the
+//  histograms of different threads (which are separate allocations) never share a line.
+//
+//  At the end of the run, Fit() finds the leading edge of each wire's spectrum. For a
+//  common-stop TDC, short drift times have large raw values, so the edge (drift time 0)
+//  is at the high end of the spectrum:
+//
+//   1. the spectrum is smoothed over 'nsmooth' bins
+//   2. the background (noise, flat in time) is the mean of the top 'nbackground' bins of
+//      the range, which should be above the edge
+//   3. going down from the top of the range, the edge is where the spectrum first rises
+//      above half-way from the background to the plateau (interpolated between bins). The
+//      plateau is first taken as the largest smoothed count, which finds the edge roughly;
+//      then, as the mean count of the 'nplateau' bins just below that edge, and the edge is
+//      found again. (The largest count is pushed up by fluctuations, the mean is not.)
+//   4. the 10% & 90% points are found the same way, to measure how sharp the edge is.
+//
+//  and the offset is set so that a hit at the edge has a real time of 0:
+//
+//      offset = tdc_resolution * raw_edge
+//
+//  Each wire gets a quality flag (see EQuality). Wires which are not kGood keep the offset
+//  they had, so that the result can be used as it is. WriteDB() writes the offsets & flags
+//  as a block for the text DB.
+//
+//  This does not depend on Podd or ROOT, so that it can be used outside of the analyzer.
+//
+//  - Seth H 28 Sep 25
+////////////////////////////////////////////////////////////////////////////////////////
+
+#include "ApexVDCPlaneEvent.h"
+#include <vector>
+#include <string>
+#include <cmath>
+#include <cstdio>
+#include <cstdint>
+#include <cstddef>
+#include <new>
+
+class ApexVDCT0Calib {
+
+public:
+    struct Config {
+        int    raw_min      = 0;        //range of raw TDC values to histogram
+        int    raw_max      = 4096;
+        int    bin_shift    = 2;        //bins are 2^bin_shift raw TDC values wide
+        int    min_entries  = 500;      //a wire needs at least this many hits in range to be fit
+        int    nsmooth      = 3;        //number of bins to smooth over
+        int    nbackground  = 8;        //number of bins at the top of the range used for the background
+        int    nplateau     = 16;       //number of bins below the edge used for the plateau
+        double max_width    = 40.;      //largest 10%-90% width of a good edge [raw TDC values]
+    };
+
+    enum EQuality {
+        kGood       = 0,    //the edge was found
+        kLowStats   = 1,    //too few hits
+        kNoEdge     = 2,    //the spectrum never rises above half of its plateau, or is still high at the top of the range
+        kWideEdge   = 3,    //the edge was found, but it is wider than 'max_width'
+        kBadWire    = 4     //on the bad list
+    };
+
+    //result of the fit of one wire
+    struct Edge {
+        int    quality = kLowStats;
+        double raw     = 0.;    //raw TDC value of the edge
+        double width   = 0.;    //10%-90% width of the edge [raw TDC values]
+        double entries = 0.;
+    };
+
+private:
+    //allocator for rows of bins which start on a cache line
+    template<typename T> struct CacheAligned {
+        using value_type = T;
+        static const size_t kAlign = 64;
+        CacheAligned() = default;
+        template<typename U> CacheAligned(const CacheAligned<U>&) {}
+        T* allocate(size_t n) { return static_cast<T*>(::operator new(n*sizeof(T), std::align_val_t(kAlign))); }
+        void deallocate(T* p, size_t) { ::operator delete(p, std::align_val_t(kAlign)); }
+        template<typename U> bool operator==(const CacheAligned<U>&) const { return true; }
+        template<typename U> bool operator!=(const CacheAligned<U>&) const { return false; }
+    };
+
+    Config   fConfig;
+    int      fNWires  = 0;
+    int      fNBins   = 0;      //bins per wire
+    int      fStride  = 0;      //counts per wire row: fNBins + 1 (trash bin), rounded up to a cache line
+
+    std::vector<uint32_t, CacheAligned<uint32_t>> fCounts;    //fNWires rows of fStride counts
+
+public:
+    ApexVDCT0Calib() = default;
+    ~ApexVDCT0Calib() = default;
+
+    //set up histograms for 'nwires' wires. this forgets all counts.
+    void Init(const Config& config, int nwires);
+
+    //forget all counts
+    void Reset();
+
+    //count 'n' raw hits. 'shift' is added to each raw TDC value (to make it relative to the event's
+    // reference time, see ApexVDCPlane::Decode()). the wire numbers must be valid.
+    void Fill(const int* wire, const unsigned int* data, size_t n, int shift=0)
+    {
+        uint32_t* counts = fCounts.data();
+        const unsigned int nbins = fNBins;
+
+        for (size_t i=0; i<n; i++) {
+            //(anything below raw_min wraps around to a huge unsigned number, so it lands in the trash bin too)
+            unsigned int bin = (unsigned int)((int)data[i] + shift - fConfig.raw_min) >> fConfig.bin_shift;
+            bin = bin < nbins ? bin : nbins;
+            counts[ (size_t)wire[i]*fStride + bin ]++;
+        }
+    }
+
+    //count the raw hits of an event (after they are stored, and before they are converted). if the event 
+    // has a reference time, the raw values are shifted by it, in units of 'tdc_resolution'. 
+    void Fill(const ApexVDCPlaneEvent& event, double tdc_resolution)
+    {
+        const int shift = event.has_reftime ? (int)std::lround(event.reftime / tdc_resolution) : 0; 
+        Fill(event.raw_wire.data(), event.raw_data.data(), event.raw_wire.size(), shift); 
+    }
+
+    //add the counts of another ApexVDCT0Calib (e.g. of another thread). both must have the same setup.
+    ApexVDCT0Calib& operator+=(const ApexVDCT0Calib& rhs);
+
+    //find the edge of one wire's spectrum (see above)
+    Edge FindEdge(int wire) const;
+
+    //fit all wires. 'offsets' are the current offsets [s] (one per wire), which are replaced for
+    // every good wire. 'bad' flags the wires on the bad list (may be empty). fills 'quality' with the
+    // EQuality of each wire, and returns the number of good wires.
+    int Fit(double tdc_resolution, const std::vector<unsigned char>& bad,
+            std::vector<double>& offsets, std::vector<int>& quality) const;
+
+    //write 'offsets' & 'quality' as the text DB keys '<prefix>tdc.offsets' & '<prefix>tdc.offsets.quality',
+    // under the validity timestamp 'timestamp' ("yyyy-mm-dd hh:mm:ss", may be empty)
+    static void WriteDB(FILE* file, const char* prefix, const char* timestamp,
+                        const std::vector<double>& offsets, const std::vector<int>& quality);
+
+    const Config& GetConfig() const { return fConfig; }
+    int      GetNWires() const { return fNWires; }
+    int      GetNBins()  const { return fNBins; }
+    uint32_t GetCount(int wire, int bin) const { return fCounts[(size_t)wire*fStride + bin]; }
+
+    //raw TDC value at the low edge of a bin
+    double GetBinLow(int bin) const { return fConfig.raw_min + (double)(bin << fConfig.bin_shift); }
+};
+
+#endif
@@ -0,0 +1,132 @@
+#include "ApexVDCTTDConv.h"
+#include <algorithm>
+#include <stdexcept>
+#include <sstream>
+
+using namespace std;
+
+namespace {
+
+    //linear interpolation in one table. times outside of the table's range are clamped to its ends.
+    // (std::min/max on doubles compile to minsd/maxsd, so there is no branch here)
+    inline double Lookup(const double* table, int nbins, double time_min, double inv_bin_width, double time)
+    {
+        const double x = min( max( (time - time_min)*inv_bin_width, 0. ), (double)nbins );
+        const int    i = min( (int)x, nbins-1 );
+        const double f = x - i;
+
+        return table[i] + f*(table[i+1] - table[i]);
+    }
+}
+
+//______________________________________________________________________________________________________
+ApexVDCTTDConv::ApexVDCTTDConv()
+{
+    MakeAnalytic(AnalyticParams(), fTimeMin, fTimeMax, fNBins);
+}
+
+//______________________________________________________________________________________________________
+double ApexVDCTTDConv::Analytic(const AnalyticParams& params, double time)
+{
+    if (time <= 0.) return 0.;
+
+    double dist = params.drift_vel * time;
+
+    //faster drift close to the wire
+    if (time < params.t_near) dist *= 1. + params.c_near*(1. - time/params.t_near);
+
+    return min(dist, params.dmax);
+}
+
+//______________________________________________________________________________________________________
+void ApexVDCTTDConv::SetRange(double time_min, double time_max, int nbins)
+{
+    const char* const here = "ApexVDCTTDConv::SetRange";
+
+    if (nbins < 1 || !(time_max > time_min)) {
+        ostringstream oss;
+        oss << "in <" << here << ">: invalid table range [" << time_min << "," << time_max << "] "
+               "with " << nbins << " bins.";
+        throw invalid_argument(oss.str());
+    }
+
+    fTimeMin     = time_min;
+    fTimeMax     = time_max;
+    fNBins       = nbins;
+    fInvBinWidth = nbins / (time_max - time_min);
+}
+
+//______________________________________________________________________________________________________
+void ApexVDCTTDConv::MakeAnalytic(const AnalyticParams& params, double time_min, double time_max, int nbins)
+{
+    SetRange(time_min, time_max, nbins);
+
+    fType   = kAnalytic;
+    fParams = params;
+
+    fTables.resize(nbins+1);
+    for (int i=0; i<=nbins; i++) fTables[i] = Analytic(params, time_min + i/fInvBinWidth);
+
+    fWireTable.clear();
+}
+
+//______________________________________________________________________________________________________
+void ApexVDCTTDConv::MakeTable(const vector<double>& table, double time_min, double time_max)
+{
+    SetRange(time_min, time_max, (int)table.size()-1);
+
+    fType   = kTable;
+    fTables = table;
+
+    fWireTable.clear();
+}
+
+//______________________________________________________________________________________________________
+void ApexVDCTTDConv::MakeWireGroupTables(const vector<double>& tables, int ngroups, int nwires, double time_min, double time_max)
+{
+    const char* const here = "ApexVDCTTDConv::MakeWireGroupTables";
+
+    if (ngroups < 1 || nwires < ngroups || tables.size() % ngroups != 0 || tables.size()/ngroups < 2) {
+        ostringstream oss;
+        oss << "in <" << here << ">: can't split " << tables.size() << " table entries into " << ngroups
+            << " tables for " << nwires << " wires.";
+        throw invalid_argument(oss.str());
+    }
+
+    const int nentries = tables.size()/ngroups;
+
+    SetRange(time_min, time_max, nentries-1);
+
+    fType   = kWireGroupTable;
+    fTables = tables;
+
+    //wires are split into 'ngroups' (nearly) equal blocks, in order
+    fWireTable.resize(nwires);
+    for (int w=0; w<nwires; w++) fWireTable[w] = ((long)w * ngroups / nwires) * nentries;
+}
+
+//______________________________________________________________________________________________________
+void ApexVDCTTDConv::Convert(const int* wire, const double* time, size_t n, double* dist) const
+{
+    //the kind of conversion is only checked once for all hits, not for every hit
+    if (fType != kWireGroupTable) {
+
+        const double* table = fTables.data();
+
+        for (size_t i=0; i<n; i++) dist[i] = Lookup(table, fNBins, fTimeMin, fInvBinWidth, time[i]);
+
+    } else {
+
+        for (size_t i=0; i<n; i++)
+            dist[i] = Lookup(fTables.data() + fWireTable[wire[i]], fNBins, fTimeMin, fInvBinWidth, time[i]);
+    }
+}
+
+//______________________________________________________________________________________________________
+double ApexVDCTTDConv::Convert(int wire, double time) const
+{
+    double dist;
+    Convert(&wire, &time, 1, &dist);
+    return dist;
+}
+//______________________________________________________________________________________________________
@@ -0,0 +1,95 @@
+#ifndef ApexVDCTTDConv_H
+#define ApexVDCTTDConv_H
+////////////////////////////////////////////////////////////////////////////////////////
+//
+//  class: ApexVDCTTDConv
+//  Drift-time to drift-distance ('TTD') conversion for one VDC plane.
+//
+//  Every conversion is done with a lookup table (with linear interpolation between
+//  entries), evaluated in bulk over the hit arrays of an event with Convert(). The table
+//  is small enough (a few kB) to stay in cache, and the lookup has no branches besides the
+//  loop itself. Which kind of conversion is used is chosen once, at init:
+//
+//   - kAnalytic        the table is filled from the analytic parameterization (see Analytic())
+//   - kTable           one table for all wires, read from the DB
+//   - kWireGroupTable  one table for each group of neighboring wires, read from the DB.
+//                      the wires are split into 'ngroups' equal blocks, in wire order.
+//
+//  The analytic parameterization is a constant drift velocity 'v', with a faster drift
+//  close to the wire (where the field goes like 1/r), and a maximum distance of 'dmax':
+//
+//      d(t) = v*t*(1 + c_near*(1 - t/t_near))     for 0 <= t < t_near
+//      d(t) = v*t                                 for t >= t_near
+//
+//  and d(t) is clamped to [0, dmax].
+//
+//  This does not depend on Podd or ROOT, so that it can be used outside of the analyzer.
+//
+//  - Seth H 28 Sep 25
+////////////////////////////////////////////////////////////////////////////////////////
+
+#include <vector>
+#include <cstddef>
+
+class ApexVDCTTDConv {
+
+public:
+    enum EType { kAnalytic = 0, kTable, kWireGroupTable };
+
+    //parameters of the analytic conversion
+    struct AnalyticParams {
+        double drift_vel = 50.e-6/1.e-9;  //drift velocity [m/s]
+        double t_near    = 30.e-9;        //size of the near-wire region [s]
+        double c_near    = 0.3;           //relative speed-up of the drift at the wire
+        double dmax      = 13.e-3;        //largest possible drift distance [m]
+    };
+
+private:
+    EType   fType = kAnalytic;
+
+    AnalyticParams fParams;
+
+    //all tables have 'fNBins+1' entries, evenly spaced over [fTimeMin, fTimeMax]
+    double  fTimeMin    = -50.e-9;
+    double  fTimeMax    = 500.e-9;
+    int     fNBins      = 1100;
+    double  fInvBinWidth = 0.;
+
+    std::vector<double> fTables;        //all tables, one after the other
+    std::vector<int>    fWireTable;     //for each wire, offset of its table in 'fTables'
+
+    void SetRange(double time_min, double time_max, int nbins);
+
+public:
+    //by default, the analytic conversion with default parameters is used
+    ApexVDCTTDConv();
+    ~ApexVDCTTDConv() = default;
+
+    //the analytic parameterization (see above), evaluated directly
+    static double Analytic(const AnalyticParams& params, double time);
+
+    //fill one table (for all wires) from the analytic parameterization
+    void MakeAnalytic(const AnalyticParams& params, double time_min, double time_max, int nbins);
+
+    //use the given table for all wires. 'table' must have nbins+1 entries.
+    void MakeTable(const std::vector<double>& table, double time_min, double time_max);
+
+    //use one table for each of 'ngroups' groups of wires. 'tables' must have ngroups*(nbins+1) entries,
+    // where nbins+1 = tables.size()/ngroups.
+    void MakeWireGroupTables(const std::vector<double>& tables, int ngroups, int nwires, double time_min, double time_max);
+
+    //convert the drift times of 'n' hits (on the given wires) into drift distances
+    void Convert(const int* wire, const double* time, size_t n, double* dist) const;
+
+    //convert a single hit
+    double Convert(int wire, double time) const;
+
+    EType  GetType()    const { return fType; }
+    int    GetNBins()   const { return fNBins; }
+    int    GetNTables() const { return fNBins > 0 ? fTables.size()/(fNBins+1) : 0; }
+    double GetTimeMin() const { return fTimeMin; }
+    double GetTimeMax() const { return fTimeMax; }
+    const AnalyticParams& GetAnalyticParams() const { return fParams; }
+};
+
+#endif
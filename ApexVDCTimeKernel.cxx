@@ -0,0 +1,130 @@
+#include "ApexVDCTimeKernel.h"
+#include <atomic>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define APEXVDC_HAVE_AVX2_KERNEL 1
+#include <immintrin.h>
+#endif
+
+namespace {
+    std::atomic<int> gMode{ ApexVDCTimeKernel::kAuto };
+}
+
+//______________________________________________________________________________________________________
+size_t ApexVDCTimeKernel::ConvertScalar( const int* wire, const unsigned int* data, size_t n, const double* offsets,
+                                         double resolution, double rawtime_min, double rawtime_max,
+                                         double reftime, double time_min, double time_max,
+                                         double* rawtime, double* realtime, unsigned char* accept )
+{
+    size_t naccept = 0;
+
+    for (size_t i=0; i<n; i++) {
+        const double raw  = static_cast<double>(data[i]);
+        const double time = offsets[wire[i]] - resolution*raw - reftime;
+
+        rawtime[i]  = raw;
+        realtime[i] = time;
+        accept[i]   = (raw >= rawtime_min) & (raw <= rawtime_max) & (time >= time_min) & (time <= time_max);
+
+        naccept += accept[i];
+    }
+    return naccept;
+}
+
+#ifdef APEXVDC_HAVE_AVX2_KERNEL
+//______________________________________________________________________________________________________
+__attribute__((target("avx2")))
+static size_t ConvertAVX2( const int* wire, const unsigned int* data, size_t n, const double* offsets,
+                           double resolution, double rawtime_min, double rawtime_max,
+                           double reftime, double time_min, double time_max,
+                           double* rawtime, double* realtime, unsigned char* accept )
+{
+    const __m256d v_res  = _mm256_set1_pd(resolution);
+    const __m256d v_min  = _mm256_set1_pd(rawtime_min);
+    const __m256d v_max  = _mm256_set1_pd(rawtime_max);
+    const __m256d v_ref  = _mm256_set1_pd(reftime);
+    const __m256d v_tmin = _mm256_set1_pd(time_min);
+    const __m256d v_tmax = _mm256_set1_pd(time_max);
+
+    //there is no unsigned int32 -> double conversion in AVX2. So, flip the sign bit (which maps
+    // [0, 2^32) onto [-2^31, 2^31)), convert as signed, and add 2^31 back. This is exact.
+    const __m128i v_sign = _mm_set1_epi32(0x80000000);
+    const __m256d v_2_31 = _mm256_set1_pd(2147483648.);
+
+    //(the masked gather, with all lanes on, is the same as the plain one, but doesn't leave the 
+    // 'source' register undefined, which some compilers warn about)
+    const __m256d v_zero = _mm256_setzero_pd();
+    const __m256d v_all  = _mm256_castsi256_pd(_mm256_set1_epi64x(-1));
+
+    size_t naccept = 0;
+    size_t i = 0;
+
+    for (; i+4 <= n; i += 4) {
+
+        const __m128i v_data = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(data+i)), v_sign);
+        const __m256d v_raw  = _mm256_add_pd(_mm256_cvtepi32_pd(v_data), v_2_31);
+
+        //gather the timing offset of each hit's wire
+        const __m128i v_wire = _mm_loadu_si128((const __m128i*)(wire+i));
+        const __m256d v_off  = _mm256_mask_i32gather_pd(v_zero, offsets, v_wire, v_all, 8);
+
+        //(same order of operations as the scalar kernel, so that the results are bit-identical)
+        const __m256d v_time = _mm256_sub_pd(_mm256_sub_pd(v_off, _mm256_mul_pd(v_res, v_raw)), v_ref);
+
+        _mm256_storeu_pd(rawtime+i,  v_raw);
+        _mm256_storeu_pd(realtime+i, v_time);
+
+        const __m256d v_raw_ok  = _mm256_and_pd( _mm256_cmp_pd(v_raw,  v_min,  _CMP_GE_OQ),
+                                                 _mm256_cmp_pd(v_raw,  v_max,  _CMP_LE_OQ) );
+        const __m256d v_time_ok = _mm256_and_pd( _mm256_cmp_pd(v_time, v_tmin, _CMP_GE_OQ),
+                                                 _mm256_cmp_pd(v_time, v_tmax, _CMP_LE_OQ) );
+        const __m256d v_ok = _mm256_and_pd(v_raw_ok, v_time_ok);
+        const int mask = _mm256_movemask_pd(v_ok);
+
+        accept[i+0] = (mask >> 0) & 1;
+        accept[i+1] = (mask >> 1) & 1;
+        accept[i+2] = (mask >> 2) & 1;
+        accept[i+3] = (mask >> 3) & 1;
+
+        naccept += __builtin_popcount(mask);
+    }
+
+    //take care of the last few hits
+    naccept += ApexVDCTimeKernel::ConvertScalar( wire+i, data+i, n-i, offsets, resolution, rawtime_min, rawtime_max,
+                                                 reftime, time_min, time_max, rawtime+i, realtime+i, accept+i );
+    return naccept;
+}
+#endif
+
+//______________________________________________________________________________________________________
+bool ApexVDCTimeKernel::HasAVX2()
+{
+#ifdef APEXVDC_HAVE_AVX2_KERNEL
+    static const bool has_avx2 = __builtin_cpu_supports("avx2");
+    return has_avx2;
+#else
+    return false;
+#endif
+}
+
+//______________________________________________________________________________________________________
+void ApexVDCTimeKernel::SetMode(EMode mode) { gMode = mode; }
+
+//______________________________________________________________________________________________________
+ApexVDCTimeKernel::EMode ApexVDCTimeKernel::GetMode() { return static_cast<EMode>(gMode.load()); }
+
+//______________________________________________________________________________________________________
+size_t ApexVDCTimeKernel::Convert( const int* wire, const unsigned int* data, size_t n, const double* offsets,
+                                   double resolution, double rawtime_min, double rawtime_max,
+                                   double reftime, double time_min, double time_max,
+                                   double* rawtime, double* realtime, unsigned char* accept )
+{
+#ifdef APEXVDC_HAVE_AVX2_KERNEL
+    if (GetMode() != kScalar && HasAVX2())
+        return ConvertAVX2( wire, data, n, offsets, resolution, rawtime_min, rawtime_max, reftime, time_min, time_max,
+                            rawtime, realtime, accept );
+#endif
+    return ConvertScalar( wire, data, n, offsets, resolution, rawtime_min, rawtime_max, reftime, time_min, time_max,
+                          rawtime, realtime, accept );
+}
+//______________________________________________________________________________________________________
@@ -0,0 +1,64 @@
+#ifndef ApexVDCTimeKernel_H
+#define ApexVDCTimeKernel_H
+////////////////////////////////////////////////////////////////////////////////////////
+//
+//  namespace: ApexVDCTimeKernel
+//  Batch conversion of raw TDC values into 'real' times, for all raw hits of a plane at once.
+//
+//  For each raw hit 'i', with wire number 'wire[i]' & raw TDC value 'data[i]':
+//
+//      rawtime[i]  = (double)data[i]
+//      realtime[i] = offsets[wire[i]] - resolution*rawtime[i] - reftime
+//      accept[i]   = (rawtime_min <= rawtime[i] <= rawtime_max) &&
+//                    (time_min    <= realtime[i] <= time_max) ? 1 : 0
+//
+//  'reftime' is the reference time of the event (see ApexVDCPlaneEvent::reftime), so that
+//  the real times are relative to it, and [time_min, time_max] is a (tight) window around
+//  it. With reftime = 0 and an infinite window, this is exactly what ApexVDCPlane used to
+//  do one hit at a time in StoreHit(). There is
+//  an AVX2 version of this kernel (4 hits at a time, with the per-wire offsets gathered
+//  from one contiguous array), and a scalar fallback. Which is used is decided at runtime,
+//  depending on what the CPU supports. Both give bit-identical results, as long as the
+//  compiler does not contract a multiply & add into an FMA in only one of them, which is
+//  why this file is built with -ffp-contract=off (see CMakeLists.txt).
+//
+//  - Seth H 28 Sep 25
+////////////////////////////////////////////////////////////////////////////////////////
+
+#include <cstddef>
+
+namespace ApexVDCTimeKernel {
+
+    enum EMode { kAuto = 0, kScalar, kAVX2 };
+
+    //convert 'n' raw hits (see above). returns the number of accepted hits.
+    size_t Convert( const int*          wire,
+                    const unsigned int* data,
+                    size_t              n,
+                    const double*       offsets,
+                    double              resolution,
+                    double              rawtime_min,
+                    double              rawtime_max,
+                    double              reftime,
+                    double              time_min,
+                    double              time_max,
+                    double*             rawtime,
+                    double*             realtime,
+                    unsigned char*      accept );
+
+    //the scalar version of the kernel, which is always available
+    size_t ConvertScalar( const int* wire, const unsigned int* data, size_t n, const double* offsets,
+                          double resolution, double rawtime_min, double rawtime_max,
+                          double reftime, double time_min, double time_max,
+                          double* rawtime, double* realtime, unsigned char* accept );
+
+    //true if this CPU (and this build) can run the AVX2 kernel
+    bool HasAVX2();
+
+    //choose which kernel Convert() uses. kAuto (the default) uses AVX2 if it's available.
+    // asking for kAVX2 on a CPU which does not support it falls back to the scalar kernel.
+    void  SetMode(EMode mode);
+    EMode GetMode();
+}
+
+#endif
@@ -0,0 +1,201 @@
+#include "ApexVDCTreeReplay.h"
+#include <ROOT/TTreeProcessorMT.hxx>
+#include <TChain.h>
+#include <TTreeReader.h>
+#include <TTreeReaderArray.h>
+#include <TTreeReaderValue.h>
+#include <memory>
+#include <mutex>
+#include <exception>
+#include <stdexcept>
+#include <sstream>
+#include <algorithm>
+#include <string_view>
+
+using namespace std;
+
+namespace {
+
+    //the results of one contiguous range of entries, as processed by one task
+    struct Chunk {
+        long long first = -1;       //first entry of this chunk
+        vector<int> nhits;
+        vector<int> ngroups;
+        vector<int> group_nhits, group_span, group_pivot;
+        vector<double> group_pos, group_slope, group_chi2;
+    };
+
+    template<typename T> inline void Append(vector<T>& to, const vector<T>& from) {
+        to.insert(to.end(), from.begin(), from.end());
+    }
+}
+
+//______________________________________________________________________________________________________
+void ApexVDCTreeReplay::Result::Clear()
+{
+    nhits.clear();
+    group_offset.assign(1, 0);
+    group_nhits.clear(); group_span.clear(); group_pivot.clear();
+    group_pos.clear(); group_slope.clear(); group_chi2.clear();
+    stats.Clear();
+}
+
+//______________________________________________________________________________________________________
+ApexVDCTreeReplay::ApexVDCTreeReplay(const vector<string>& files, const char* tree_name)
+    : fFiles(files),
+    fTreeName(tree_name ? tree_name : "")
+{
+    const char* const here = "ApexVDCTreeReplay";
+
+    if (fFiles.empty()) {
+        ostringstream oss;
+        oss << "in <" << here << ">: no input files given.";
+        throw invalid_argument(oss.str());
+    }
+}
+
+//______________________________________________________________________________________________________
+long long ApexVDCTreeReplay::Run(const char* prefix, const ApexVDCPlaneCalib& calib, Result& result) const
+{
+    const char* const here = "ApexVDCTreeReplay::Run";
+
+    result.Clear();
+
+    const string wire_branch    = string(prefix) + "hit.wire";
+    const string rawtime_branch = string(prefix) + "hit.rawtime";
+    const string reftime_branch = string(prefix) + "reftime";
+    const string refok_branch   = string(prefix) + "reftime.ok";
+
+    vector<string_view> files(fFiles.begin(), fFiles.end());
+    ROOT::TTreeProcessorMT processor(files, fTreeName);
+
+    //the number of entries we should end up with
+    TChain chain(fTreeName.c_str());
+    for (const string& file : fFiles) chain.Add(file.c_str());
+    const long long nentries = chain.GetEntries();
+
+    //trees from replays with a reference time also have the reference time of each event
+    const bool has_reftime = chain.GetBranch(reftime_branch.c_str()) && chain.GetBranch(refok_branch.c_str());
+
+    //pool of event states. a task takes one for as long as it runs, so no two tasks ever share one.
+    mutex lock;
+    vector<unique_ptr<ApexVDCPlaneEvent>> events;   //all event states made so far
+    vector<ApexVDCPlaneEvent*> pool;                //the ones which are free right now
+    vector<Chunk> chunks;
+    exception_ptr error;
+
+    processor.Process([&](TTreeReader& reader) {
+
+        ApexVDCPlaneEvent* event = nullptr;
+        {
+            lock_guard<mutex> guard(lock);
+            if (error) return;
+            if (pool.empty()) {
+                events.emplace_back(new ApexVDCPlaneEvent);
+                events.back()->Reserve(fHits_reserve, fGroups_reserve, calib.nwires);
+                pool.push_back(events.back().get());
+            }
+            event = pool.back();
+            pool.pop_back();
+        }
+
+        Chunk chunk;
+
+        try {
+            //Podd writes every variable as an array of doubles
+            TTreeReaderArray<double> wire   (reader, wire_branch.c_str());
+            TTreeReaderArray<double> rawtime(reader, rawtime_branch.c_str());
+
+            unique_ptr<TTreeReaderValue<double>> reftime, refok;
+            if (has_reftime) {
+                reftime.reset(new TTreeReaderValue<double>(reader, reftime_branch.c_str()));
+                refok  .reset(new TTreeReaderValue<double>(reader, refok_branch.c_str()));
+            }
+
+            long long next = -1;
+
+            while (reader.Next()) {
+
+                if (wire.GetSetupStatus() < 0 || rawtime.GetSetupStatus() < 0) {
+                    ostringstream oss;
+                    oss << "in <" << here << ">: can't read branches '" << wire_branch << "' and '"
+                        << rawtime_branch << "' from tree '" << fTreeName << "'.";
+                    throw runtime_error(oss.str());
+                }
+
+                //the entries of one task are always contiguous
+                const long long entry = reader.GetCurrentEntry();
+                if (chunk.first < 0) chunk.first = entry;
+                else if (entry != next) {
+                    ostringstream oss;
+                    oss << "in <" << here << ">: expected entry " << next << ", got " << entry << ".";
+                    throw logic_error(oss.str());
+                }
+                next = entry + 1;
+
+                //store the hits as raw hits, and re-run everything from the TDC cut on (with the same 
+                // reference time as in the replay, if there was one)
+                event->Clear();
+                if (has_reftime && **refok != 0.) event->SetRefTime(**reftime);
+
+                const size_t n = min(wire.GetSize(), rawtime.GetSize());
+                for (size_t i=0; i<n; i++) event->StoreHit(calib, (int)wire[i], (unsigned int)rawtime[i]);
+
+                event->Process(calib);
+
+                chunk.nhits  .push_back(event->hits.size());
+                chunk.ngroups.push_back(event->groups.size());
+                Append(chunk.group_nhits, event->group_nhits);
+                Append(chunk.group_span,  event->group_span);
+                Append(chunk.group_pos,   event->group_pos);
+                Append(chunk.group_slope, event->group_slope);
+                Append(chunk.group_chi2,  event->group_chi2);
+                Append(chunk.group_pivot, event->group_pivot);
+            }
+
+        } catch (...) {
+            lock_guard<mutex> guard(lock);
+            if (!error) error = current_exception();
+        }
+
+        lock_guard<mutex> guard(lock);
+        pool.push_back(event);
+        if (chunk.first >= 0) chunks.push_back(std::move(chunk));
+    });
+
+    if (error) rethrow_exception(error);
+
+    //put the chunks back together in entry order, and check that no entries are missing
+    sort(chunks.begin(), chunks.end(), [](const Chunk& a, const Chunk& b) { return a.first < b.first; });
+
+    for (const Chunk& chunk : chunks) {
+
+        if (chunk.first != result.GetNEntries()) {
+            ostringstream oss;
+            oss << "in <" << here << ">: entries [" << result.GetNEntries() << "," << chunk.first << ") "
+                   "were not processed.";
+            throw logic_error(oss.str());
+        }
+
+        for (int ngroups : chunk.ngroups) result.group_offset.push_back(result.group_offset.back() + ngroups);
+
+        Append(result.nhits,       chunk.nhits);
+        Append(result.group_nhits, chunk.group_nhits);
+        Append(result.group_span,  chunk.group_span);
+        Append(result.group_pos,   chunk.group_pos);
+        Append(result.group_slope, chunk.group_slope);
+        Append(result.group_chi2,  chunk.group_chi2);
+        Append(result.group_pivot, chunk.group_pivot);
+    }
+
+    if (result.GetNEntries() != nentries) {
+        ostringstream oss;
+        oss << "in <" << here << ">: only " << result.GetNEntries() << " of " << nentries << " entries were processed.";
+        throw logic_error(oss.str());
+    }
+
+    for (const auto& event : events) result.stats += event->stats;
+
+    return result.GetNEntries();
+}
+//______________________________________________________________________________________________________
@@ -0,0 +1,93 @@
+#ifndef ApexVDCTreeReplay_H
+#define ApexVDCTreeReplay_H
+////////////////////////////////////////////////////////////////////////////////////////
+//
+//  class: ApexVDCTreeReplay
+//  Re-reconstruction of VDC planes from the hits already in replayed ROOT trees, outside
+//  of the analyzer's event loop.
+//
+//  A replay writes the hits of each plane to its output tree, as the variables
+//  '<prefix>hit.wire' and '<prefix>hit.rawtime' (see ApexVDCPlane::DefineVariables()).
+//  For each entry, these are stored back into an ApexVDCPlaneEvent as raw hits, and then
+//  go through all of ApexVDCPlaneEvent::Process() again (TDC cut, ordering, grouping, drift
+//  distances & group fits), with whatever ApexVDCPlaneCalib is given. (If the tree also has
+//  '<prefix>reftime' & '<prefix>reftime.ok', the hit times are again taken relative to the
+//  reference time of each event.) So, the group cuts
+//  (or the TTD conversion, or the fit) can be changed & re-run in minutes, without a full
+//  replay of the raw data.
+//
+//  The entries are processed in parallel with ROOT's TTreeProcessorMT, which hands out
+//  ranges of entries (one tree cluster, or more) to the threads of ROOT's implicit-MT pool.
+//  Each task takes an ApexVDCPlaneEvent from a pool (so each thread works on its own
+//  event state, and no event state is ever shared), and all tasks read the same (const)
+//  ApexVDCPlaneCalib. Each task writes the results of its entries into its own chunk, and
+//  once all are done, the chunks are put back together in entry order (see Result below).
+//  So, the result is the same for any number of threads. (This needs ROOT 6.22 or later, in
+//  which TTreeProcessorMT gives each task the entry numbers of the whole chain of files.)
+//
+//  Run() does not turn on implicit MT itself: the size of ROOT's thread pool is a setting of
+//  the whole process, so it is left to whoever owns the process (e.g. the main() of
+//  ApexOfflineTreeReplay, with its '--threads'). Call ROOT::EnableImplicitMT() before Run();
+//  ROOT::GetThreadPoolSize() then says how many threads the entries are processed on.
+//
+//  Since the trees only hold the hits which passed the TDC window & wire mask of the
+//  original replay, a wider window (or a shorter bad list) than that can't bring hits back.
+//
+//  - Seth H 28 Sep 25
+////////////////////////////////////////////////////////////////////////////////////////
+
+#include "ApexVDCPlaneCalib.h"
+#include "ApexVDCPlaneEvent.h"
+#include "ApexVDCPlaneStats.h"
+#include <vector>
+#include <string>
+
+class ApexVDCTreeReplay {
+
+public:
+    //results of one plane for all entries, in entry order. The groups of entry 'i' are the elements
+    // [group_offset[i], group_offset[i+1]) of the group columns.
+    struct Result {
+        std::vector<int>        nhits;          //number of hits (after the TDC cut) in each entry
+        std::vector<long long>  group_offset;   //index of the first group of each entry (nentries + 1)
+        std::vector<int>        group_nhits;
+        std::vector<int>        group_span;
+        std::vector<double>     group_pos;
+        std::vector<double>     group_slope;
+        std::vector<double>     group_chi2;
+        std::vector<int>        group_pivot;
+
+        ApexVDCPlaneStats       stats;          //timing & rate counters of all threads, combined
+
+        long long GetNEntries() const { return nhits.size(); }
+        int       GetNGroups(long long entry) const { return group_offset[entry+1] - group_offset[entry]; }
+
+        void Clear();
+    };
+
+private:
+    std::vector<std::string> fFiles;
+    std::string  fTreeName;
+
+    int fHits_reserve   = 0;    //number of hits & groups to pre-allocate for each event in the pool
+    int fGroups_reserve = 0;
+
+public:
+    explicit ApexVDCTreeReplay(const std::vector<std::string>& files,
+                               const char* tree_name="T");
+
+    ~ApexVDCTreeReplay() = default;
+
+    //pre-allocate space for this many hits & groups in each ApexVDCPlaneEvent
+    void SetReserve(int nhits, int ngroups) { fHits_reserve = nhits; fGroups_reserve = ngroups; }
+
+    //re-run the plane whose variables start with 'prefix' (e.g. "R.vdc.u1.") over all entries, with
+    // 'calib'. throws if the hit branches are missing, or if any entries were not processed.
+    // returns the number of entries.
+    long long Run(const char* prefix, const ApexVDCPlaneCalib& calib, Result& result) const;
+
+    const std::vector<std::string>& GetFiles() const { return fFiles; }
+    const std::string& GetTreeName() const { return fTreeName; }
+};
+
+#endif
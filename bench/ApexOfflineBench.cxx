@@ -0,0 +1,450 @@
+////////////////////////////////////////////////////////////////////////////////////////
+//
+//  ApexOfflineBench
+//  Benchmark of ApexVDCPlane decoding, on synthetic events (see ApexVDCBenchGenerator.h).
+//  This does not need Podd, ROOT or any beam data.
+//
+//  Each event goes through the same stages as ApexVDCPlane::Decode():
+//
+//      store   - walk all raw hits (through the THaDetMap stand-in) & store them
+//      convert - TDC cut & conversion to real time (ApexVDCTimeKernel)
+//      order   - sort hits by wire & time
+//      group   - find hit groups
+//      output  - fill the output columns
+//      ttd     - drift-time to distance conversion
+//      fit     - fit of the crossing position & slope of each group
+//
+//  For each stage, the time (ns/event) and number of heap allocations (per event) is
+//  measured, after a number of warm-up events (during which the buffers grow to their
+//  working size). The same events are decoded with each configuration (bucket sort vs.
+//  std::sort, AVX2 vs. scalar time kernel, unchecked vs. checked hit storage, with vs.
+//  without a window around the reference time, with vs. without filling the t0 histograms),
+//  so the configurations can be compared directly.
+//
+//  Last, the first '--mt-events' events are decoded again, once serially and once with
+//  ApexVDCReplayMT on '--threads' threads (0 = all hardware threads). Every output column
+//  (hits, groups & fit results) of every event must be bit-identical between the two;
+//  if any event differs, the benchmark exits with 1.
+//
+//  usage: ApexOfflineBench [--events N] [--warmup N] [--noise p] [--tracks mean]
+//                          [--multihit p] [--dead fraction] [--angle deg] [--seed N]
+//                          [--threads N] [--mt-events N] [--out results.json]
+//
+//  A table is printed to stdout, and the results are written as JSON to the '--out' file.
+//
+//  - Seth H 28 Sep 25
+////////////////////////////////////////////////////////////////////////////////////////
+
+#include "ApexVDCBenchGenerator.h"
+#include "ApexVDCBenchEvData.h"
+#include "ApexVDCPlaneCalib.h"
+#include "ApexVDCPlaneEvent.h"
+#include "ApexVDCTimeKernel.h"
+#include "ApexVDCT0Calib.h"
+#include "ApexVDCReplayMT.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+//______________________________________________________________________________________________________
+// count every heap allocation made by this program
+namespace {
+    atomic<unsigned long long> gNAllocs{0};
+}
+
+void* operator new(size_t size)
+{
+    gNAllocs.fetch_add(1, memory_order_relaxed);
+    if (void* ptr = malloc(size ? size : 1)) return ptr;
+    throw bad_alloc();
+}
+void  operator delete(void* ptr) noexcept              { free(ptr); }
+void  operator delete(void* ptr, size_t) noexcept      { free(ptr); }
+
+//______________________________________________________________________________________________________
+namespace {
+
+    enum EStage { kStore = 0, kConvert, kOrder, kGroup, kOutput, kTTD, kFit, kNStages };
+
+    const char* const kStageNames[kNStages] = { "store", "convert", "order", "group", "output", "ttd", "fit" };
+
+    struct BenchConfig {
+        const char*               name;
+        int                       use_std_sort;
+        ApexVDCTimeKernel::EMode  kernel_mode;
+        int                       checked_store;    //store hits with StoreHit() (checks each wire) instead of StoreRawHit()
+        int                       use_reftime;      //drop hits outside a window around the reference time, before ordering
+        int                       use_t0calib;      //fill the t0 histograms with the raw hits (counted in the 'store' stage)
+    };
+
+    struct BenchResult {
+        string      name;
+        long long   nevents   = 0;
+        long long   nraw      = 0;  //raw hits
+        long long   nhits     = 0;  //hits which passed the TDC cut
+        long long   ngroups   = 0;
+        double      ns[kNStages]     = {0.};
+        double      allocs[kNStages] = {0.};
+
+        double TotalNs() const { double t = 0.; for (double x : ns) t += x; return t; }
+    };
+
+    //__________________________________________________________________________________________________
+    BenchResult RunBench(const BenchConfig& bench, const ApexVDCBenchGenerator::Config& gen_config,
+                         long long nevents, long long nwarmup)
+    {
+        using clock = chrono::steady_clock;
+
+        //every configuration sees exactly the same events
+        ApexVDCBenchGenerator generator(gen_config);
+
+        ApexVDCPlaneCalib  calib  = generator.MakeCalib();
+        ApexVDCBenchDetMap detmap = generator.MakeDetMap();
+        ApexVDCBenchEvData evdata = generator.MakeEvData();
+
+        calib.use_std_sort = bench.use_std_sort;
+        ApexVDCTimeKernel::SetMode(bench.kernel_mode);
+
+        //the generated events have no trigger jitter, so the reference time is always 0. the window 
+        // keeps every track hit (drift times up to ~cell_height/drift_velocity), and drops most noise. 
+        if (bench.use_reftime) {
+            calib.reftime_min = -20.e-9;
+            calib.reftime_max = 1.5 * gen_config.cell_height / gen_config.drift_velocity;
+        }
+
+        ApexVDCT0Calib t0calib;
+        if (bench.use_t0calib) t0calib.Init(ApexVDCT0Calib::Config(), calib.nwires);
+
+        ApexVDCPlaneEvent event;
+
+        BenchResult result;
+        result.name = bench.name;
+
+        for (long long iev=0; iev < nwarmup + nevents; iev++) {
+
+            generator.Generate(evdata);
+
+            const bool measure = (iev >= nwarmup);
+
+            clock::time_point t[kNStages+1];
+            unsigned long long a[kNStages+1];
+
+            event.Clear();
+            if (bench.use_reftime) event.SetRefTime(0.);
+
+            a[kStore]   = gNAllocs; t[kStore]   = clock::now();
+            if (bench.checked_store)
+                detmap.ForEachHit(evdata, [&](int lchan, unsigned int data) { event.StoreHit(calib, lchan, data); });
+            else
+                detmap.ForEachHit(evdata, [&](int lchan, unsigned int data) { event.StoreRawHit(lchan, data); });
+
+            if (bench.use_t0calib) t0calib.Fill(event, calib.tdc_resolution);
+
+            const long long nraw = event.raw_data.size();
+
+            a[kConvert] = gNAllocs; t[kConvert] = clock::now();
+            event.ConvertHits(calib);
+
+            a[kOrder]   = gNAllocs; t[kOrder]   = clock::now();
+            event.SortHits(calib);
+
+            a[kGroup]   = gNAllocs; t[kGroup]   = clock::now();
+            event.FindGroups(calib);
+
+            a[kOutput]  = gNAllocs; t[kOutput]  = clock::now();
+            event.FillOutput();
+
+            a[kTTD]     = gNAllocs; t[kTTD]     = clock::now();
+            event.ComputeDistances(calib);
+
+            a[kFit]     = gNAllocs; t[kFit]     = clock::now();
+            event.FitGroups(calib);
+
+            a[kNStages] = gNAllocs; t[kNStages] = clock::now();
+
+            if (!measure) continue;
+
+            result.nevents++;
+            result.nraw    += nraw;
+            result.nhits   += event.hits.size();
+            result.ngroups += event.groups.size();
+
+            for (int s=0; s<kNStages; s++) {
+                result.ns[s]     += chrono::duration<double, nano>(t[s+1] - t[s]).count();
+                result.allocs[s] += a[s+1] - a[s];
+            }
+        }
+
+        //turn totals into per-event numbers
+        for (int s=0; s<kNStages; s++) {
+            result.ns[s]     /= max(1LL, result.nevents);
+            result.allocs[s] /= max(1LL, result.nevents);
+        }
+
+        ApexVDCTimeKernel::SetMode(ApexVDCTimeKernel::kAuto);
+        return result;
+    }
+
+    //__________________________________________________________________________________________________
+    //the output columns of one decoded event, as they would be written to the tree
+    struct EventColumns {
+        vector<double> hit_rawtime, hit_time, hit_pos, hit_dist;
+        vector<int>    hit_wire;
+        vector<int>    group_nhits, group_start, group_end, group_span, group_pivot;
+        vector<double> group_pos, group_slope, group_chi2;
+
+        void Fill(const ApexVDCPlaneEvent& event)
+        {
+            hit_rawtime = event.hit_rawtime; hit_time    = event.hit_time;    hit_pos    = event.hit_pos;
+            hit_dist    = event.hit_dist;    hit_wire    = event.hit_wire;
+            group_nhits = event.group_nhits; group_start = event.group_start; group_end  = event.group_end;
+            group_span  = event.group_span;  group_pivot = event.group_pivot;
+            group_pos   = event.group_pos;   group_slope = event.group_slope; group_chi2 = event.group_chi2;
+        }
+    };
+
+    //bit-for-bit, so that a NaN (or -0.) in one and not the other counts as a difference
+    template<typename T> bool SameBits(const vector<T>& a, const vector<T>& b)
+    {
+        return a.size() == b.size() && (a.empty() || memcmp(a.data(), b.data(), a.size()*sizeof(T)) == 0);
+    }
+
+    bool SameColumns(const EventColumns& a, const EventColumns& b)
+    {
+        return SameBits(a.hit_rawtime, b.hit_rawtime) && SameBits(a.hit_time,    b.hit_time)    &&
+               SameBits(a.hit_pos,     b.hit_pos)     && SameBits(a.hit_dist,    b.hit_dist)    &&
+               SameBits(a.hit_wire,    b.hit_wire)    && SameBits(a.group_nhits, b.group_nhits) &&
+               SameBits(a.group_start, b.group_start) && SameBits(a.group_end,   b.group_end)   &&
+               SameBits(a.group_span,  b.group_span)  && SameBits(a.group_pivot, b.group_pivot) &&
+               SameBits(a.group_pos,   b.group_pos)   && SameBits(a.group_slope, b.group_slope) &&
+               SameBits(a.group_chi2,  b.group_chi2);
+    }
+
+    struct ReplayMTResult {
+        long long    nevents     = 0;
+        unsigned int nthreads    = 0;
+        long long    nstolen     = 0;   //blocks of events stolen by idle workers
+        double       ns_serial   = 0.;  //per event
+        double       ns_mt       = 0.;  //per event (wall clock)
+        long long    nmismatched = 0;   //events whose columns differ between the two
+    };
+
+    //__________________________________________________________________________________________________
+    //decode the same events serially & with ApexVDCReplayMT, and compare every output column
+    ReplayMTResult RunReplayMT(const ApexVDCBenchGenerator::Config& gen_config, long long nevents, unsigned int nthreads)
+    {
+        using clock = chrono::steady_clock;
+
+        ApexVDCBenchGenerator generator(gen_config);
+
+        ApexVDCPlaneCalib  calib  = generator.MakeCalib();
+        ApexVDCBenchDetMap detmap = generator.MakeDetMap();
+        ApexVDCBenchEvData evdata = generator.MakeEvData();
+
+        //generate all events up front (the generator is not thread-safe): the raw hits of event 'i' 
+        // are [first[i], first[i+1]) 
+        vector<int>          raw_lchan;
+        vector<unsigned int> raw_data;
+        vector<size_t>       first(1, 0);
+
+        for (long long iev=0; iev<nevents; iev++) {
+            generator.Generate(evdata);
+            detmap.ForEachHit(evdata, [&](int lchan, unsigned int data) { raw_lchan.push_back(lchan); raw_data.push_back(data); });
+            first.push_back(raw_lchan.size());
+        }
+
+        auto source = [&](long long i, ApexVDCPlaneEvent& event) {
+            for (size_t k=first[i]; k<first[i+1]; k++) event.StoreHit(calib, raw_lchan[k], raw_data[k]);
+        };
+
+        ReplayMTResult result;
+        result.nevents = nevents;
+
+        //serial: the same steps as ApexVDCPlane::Decode()
+        vector<EventColumns> serial(nevents);
+        {
+            ApexVDCPlaneEvent event;
+            const auto start = clock::now();
+            for (long long i=0; i<nevents; i++) {
+                event.Clear();
+                source(i, event);
+                event.Process(calib);
+                serial[i].Fill(event);
+            }
+            result.ns_serial = chrono::duration<double, nano>(clock::now() - start).count() / max(1LL, nevents);
+        }
+
+        //event-parallel: each event goes into its own slot, whichever thread decodes it
+        vector<EventColumns> parallel(nevents);
+        {
+            ApexVDCReplayMT replay(calib, nthreads, 64);
+            const auto start = clock::now();
+            const long long ndecoded = replay.Run(nevents, source,
+                                                  [&](long long i, const ApexVDCPlaneEvent& event) { parallel[i].Fill(event); });
+            result.ns_mt    = chrono::duration<double, nano>(clock::now() - start).count() / max(1LL, nevents);
+            result.nthreads = replay.GetNThreads();
+            result.nstolen  = replay.GetNBlocksStolen();
+
+            if (ndecoded != nevents) {
+                fprintf(stderr, "ApexOfflineBench: ApexVDCReplayMT decoded %lld of %lld events\n", ndecoded, nevents);
+                result.nmismatched = nevents - ndecoded;
+            }
+        }
+
+        for (long long i=0; i<nevents; i++) {
+            if (SameColumns(serial[i], parallel[i])) continue;
+            if (result.nmismatched++ < 10)
+                fprintf(stderr, "ApexOfflineBench: event %lld: ApexVDCReplayMT output differs from the serial one\n", i);
+        }
+
+        return result;
+    }
+
+    //__________________________________________________________________________________________________
+    void PrintResult(const BenchResult& r)
+    {
+        const double hits_per_event = (double)r.nraw / max(1LL, r.nevents);
+
+        printf("\n%s  (%.1f raw hits/event, %.1f hits/event, %.2f groups/event)\n",
+               r.name.c_str(), hits_per_event, (double)r.nhits/max(1LL, r.nevents), (double)r.ngroups/max(1LL, r.nevents));
+        printf("  %-10s %12s %14s\n", "stage", "ns/event", "allocs/event");
+
+        for (int s=0; s<kNStages; s++)
+            printf("  %-10s %12.1f %14.3f\n", kStageNames[s], r.ns[s], r.allocs[s]);
+
+        double allocs = 0.; for (double a : r.allocs) allocs += a;
+
+        printf("  %-10s %12.1f %14.3f   (%.3g raw hits/s)\n", "total", r.TotalNs(), allocs, hits_per_event / (r.TotalNs()*1e-9));
+    }
+
+    //__________________________________________________________________________________________________
+    void PrintReplayMT(const ReplayMTResult& r)
+    {
+        printf("\nreplay_mt  (%lld events, %u threads, %lld blocks stolen)\n", r.nevents, r.nthreads, r.nstolen);
+        printf("  %-10s %12s\n", "", "ns/event");
+        printf("  %-10s %12.1f\n", "serial", r.ns_serial);
+        printf("  %-10s %12.1f   (x%.2f)\n", "parallel", r.ns_mt, r.ns_serial / max(1e-9, r.ns_mt));
+        printf("  %lld events differ from the serial output%s\n", r.nmismatched, r.nmismatched ? "  <-- FAILED" : "");
+    }
+
+    //__________________________________________________________________________________________________
+    void WriteJSON(const char* path, const vector<BenchResult>& results, const ReplayMTResult& mt,
+                   const ApexVDCBenchGenerator::Config& c, long long nevents, long long nwarmup, bool has_avx2)
+    {
+        FILE* file = fopen(path, "w");
+        if (!file) {
+            fprintf(stderr, "ApexOfflineBench: could not open '%s' for writing\n", path);
+            return;
+        }
+
+        fprintf(file, "{\n");
+        fprintf(file, "  \"config\": {\"events\": %lld, \"warmup\": %lld, \"nwires\": %d, \"noise_occupancy\": %g, "
+                      "\"ntracks_mean\": %g, \"multihit_prob\": %g, \"dead_fraction\": %g, \"track_angle\": %g, "
+                      "\"seed\": %u, \"has_avx2\": %s},\n",
+                      nevents, nwarmup, c.nwires, c.noise_occupancy, c.ntracks_mean, c.multihit_prob,
+                      c.dead_fraction, c.track_angle, c.seed, has_avx2 ? "true" : "false");
+        fprintf(file, "  \"results\": [\n");
+
+        for (size_t i=0; i<results.size(); i++) {
+            const BenchResult& r = results[i];
+            const double hits_per_event = (double)r.nraw / max(1LL, r.nevents);
+
+            fprintf(file, "    {\"name\": \"%s\", \"raw_hits_per_event\": %g, \"hits_per_event\": %g, \"groups_per_event\": %g, "
+                          "\"ns_per_event\": %g, \"hits_per_second\": %g, \"stages\": {",
+                          r.name.c_str(), hits_per_event, (double)r.nhits/max(1LL, r.nevents),
+                          (double)r.ngroups/max(1LL, r.nevents), r.TotalNs(), hits_per_event/(r.TotalNs()*1e-9));
+
+            for (int s=0; s<kNStages; s++)
+                fprintf(file, "%s\"%s\": {\"ns_per_event\": %g, \"allocs_per_event\": %g}",
+                        s ? ", " : "", kStageNames[s], r.ns[s], r.allocs[s]);
+
+            fprintf(file, "}}%s\n", i+1 < results.size() ? "," : "");
+        }
+        fprintf(file, "  ],\n");
+        fprintf(file, "  \"replay_mt\": {\"events\": %lld, \"threads\": %u, \"blocks_stolen\": %lld, "
+                      "\"serial_ns_per_event\": %g, \"mt_ns_per_event\": %g, \"mismatched_events\": %lld}\n}\n",
+                      mt.nevents, mt.nthreads, mt.nstolen, mt.ns_serial, mt.ns_mt, mt.nmismatched);
+        fclose(file);
+    }
+}
+
+//______________________________________________________________________________________________________
+int main(int argc, char* argv[])
+{
+    ApexVDCBenchGenerator::Config gen_config;
+
+    long long    nevents  = 100000;
+    long long    nwarmup  = 1000;
+    long long    nmt      = 20000;  //events decoded both serially & with ApexVDCReplayMT
+    unsigned int nthreads = 0;      //(0 = all hardware threads)
+    const char*  out      = "ApexOfflineBench.json";
+
+    for (int i=1; i<argc; i++) {
+
+        const char* arg = argv[i];
+
+        if (!strcmp(arg, "--help") || !strcmp(arg, "-h")) {
+            printf("usage: %s [--events N] [--warmup N] [--noise p] [--tracks mean] [--multihit p] "
+                   "[--dead fraction] [--angle deg] [--seed N] [--threads N] [--mt-events N] [--out results.json]\n", argv[0]);
+            return 0;
+        }
+        if (i+1 >= argc) {
+            fprintf(stderr, "ApexOfflineBench: missing value for '%s'\n", arg);
+            return 1;
+        }
+        const char* val = argv[++i];
+
+        if      (!strcmp(arg, "--events"))   nevents = atoll(val);
+        else if (!strcmp(arg, "--warmup"))   nwarmup = atoll(val);
+        else if (!strcmp(arg, "--noise"))    gen_config.noise_occupancy = atof(val);
+        else if (!strcmp(arg, "--tracks"))   gen_config.ntracks_mean    = atof(val);
+        else if (!strcmp(arg, "--multihit")) gen_config.multihit_prob   = atof(val);
+        else if (!strcmp(arg, "--dead"))     gen_config.dead_fraction   = atof(val);
+        else if (!strcmp(arg, "--angle"))    gen_config.track_angle     = atof(val);
+        else if (!strcmp(arg, "--seed"))     gen_config.seed            = strtoul(val, nullptr, 10);
+        else if (!strcmp(arg, "--threads"))  nthreads = strtoul(val, nullptr, 10);
+        else if (!strcmp(arg, "--mt-events")) nmt   = atoll(val);
+        else if (!strcmp(arg, "--out"))      out = val;
+        else {
+            fprintf(stderr, "ApexOfflineBench: unknown option '%s' (try --help)\n", arg);
+            return 1;
+        }
+    }
+
+    const bool has_avx2 = ApexVDCTimeKernel::HasAVX2();
+
+    printf("ApexOfflineBench: %lld events (+%lld warm-up), %d wires, noise occupancy %g, %g tracks/event, "
+           "multi-hit prob. %g, dead fraction %g, AVX2 %s\n",
+           nevents, nwarmup, gen_config.nwires, gen_config.noise_occupancy, gen_config.ntracks_mean,
+           gen_config.multihit_prob, gen_config.dead_fraction, has_avx2 ? "available" : "not available");
+
+    const BenchConfig benches[] = {
+        { "default",        0, ApexVDCTimeKernel::kAuto,   0, 0, 0 },
+        { "std_sort",       1, ApexVDCTimeKernel::kAuto,   0, 0, 0 },
+        { "scalar_kernel",  0, ApexVDCTimeKernel::kScalar, 0, 0, 0 },
+        { "checked_store",  0, ApexVDCTimeKernel::kAuto,   1, 0, 0 },
+        { "reftime_window", 0, ApexVDCTimeKernel::kAuto,   0, 1, 0 },
+        { "t0_calib",       0, ApexVDCTimeKernel::kAuto,   0, 0, 1 },
+    };
+
+    vector<BenchResult> results;
+    for (const auto& bench : benches) {
+        results.push_back( RunBench(bench, gen_config, nevents, nwarmup) );
+        PrintResult(results.back());
+    }
+
+    const ReplayMTResult mt = RunReplayMT(gen_config, nmt, nthreads);
+    PrintReplayMT(mt);
+
+    WriteJSON(out, results, mt, gen_config, nevents, nwarmup, has_avx2);
+    printf("\nresults written to '%s'\n", out);
+
+    return mt.nmismatched ? 1 : 0;
+}
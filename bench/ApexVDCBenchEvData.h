@@ -0,0 +1,73 @@
+#ifndef ApexVDCBenchEvData_H
+#define ApexVDCBenchEvData_H
+////////////////////////////////////////////////////////////////////////////////////////
+//
+//  classes: ApexVDCBenchEvData, ApexVDCBenchDetMap
+//  Very light stand-ins for Podd's THaEvData & THaDetMap, so that ApexVDCPlane's decoding
+//  can be benchmarked without the analyzer (or any CODA data).
+//
+//  ApexVDCBenchEvData holds the raw TDC data of one event, as a list of hits for each
+//  (module, channel). ApexVDCBenchDetMap maps (module, channel) onto a logical channel
+//  (wire number) the same way THaDetMap::kFillLogicalChannel does, and walks all hits of
+//  an event in the same order as THaDetMap's multi-hit iterator.
+//
+//  - Seth H 28 Sep 25
+////////////////////////////////////////////////////////////////////////////////////////
+
+#include <vector>
+
+class ApexVDCBenchEvData {
+private:
+    unsigned int fNChanPerModule;
+    std::vector<std::vector<std::vector<unsigned int>>> fData; //[module][channel][hit]
+
+public:
+    ApexVDCBenchEvData(unsigned int nmodules, unsigned int nchan_per_module)
+        : fNChanPerModule{nchan_per_module},
+        fData(nmodules, std::vector<std::vector<unsigned int>>(nchan_per_module)) {};
+
+    void Clear() { for (auto& module : fData) for (auto& chan : module) chan.clear(); }
+
+    void AddHit(unsigned int module, unsigned int chan, unsigned int data) { fData[module][chan].push_back(data); }
+
+    unsigned int GetNModules()     const { return fData.size(); }
+    unsigned int GetNChannels()    const { return fNChanPerModule; }
+    unsigned int GetNumHits(unsigned int module, unsigned int chan) const { return fData[module][chan].size(); }
+    unsigned int GetData(unsigned int module, unsigned int chan, unsigned int hit) const { return fData[module][chan][hit]; }
+
+    //total number of raw hits in this event
+    unsigned int GetNHits() const {
+        unsigned int n = 0;
+        for (const auto& module : fData) for (const auto& chan : module) n += chan.size();
+        return n;
+    }
+};
+
+class ApexVDCBenchDetMap {
+public:
+    //one 'detmap' entry: the channels [lo, hi] of 'module' are the logical channels [first, first + hi-lo]
+    struct Module { unsigned int module, lo, hi; int first; };
+
+private:
+    std::vector<Module> fModules;
+
+public:
+    ApexVDCBenchDetMap() = default;
+
+    void AddModule(unsigned int module, unsigned int lo, unsigned int hi, int first) { fModules.push_back({module, lo, hi, first}); }
+
+    const std::vector<Module>& GetModules() const { return fModules; }
+
+    //call 'store(lchan, data)' for every hit in the event, in the same order as THaDetMap's multi-hit iterator
+    template<typename Store_t> void ForEachHit(const ApexVDCBenchEvData& evdata, Store_t&& store) const {
+        for (const auto& mod : fModules) {
+            for (unsigned int chan=mod.lo; chan<=mod.hi; chan++) {
+                const unsigned int nhits = evdata.GetNumHits(mod.module, chan);
+                for (unsigned int hit=0; hit<nhits; hit++)
+                    store( mod.first + (int)(chan - mod.lo), evdata.GetData(mod.module, chan, hit) );
+            }
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,131 @@
+#include "ApexVDCBenchGenerator.h"
+#include <cmath>
+#include <algorithm>
+
+using namespace std;
+
+//______________________________________________________________________________________________________
+ApexVDCBenchGenerator::ApexVDCBenchGenerator(const Config& config)
+    : fConfig{config},
+    fRng{config.seed},
+    fDead(config.nwires, 0)
+{
+    //pick the dead wires once, so they are the same for every event
+    bernoulli_distribution is_dead(fConfig.dead_fraction);
+    for (auto& dead : fDead) dead = is_dead(fRng);
+}
+
+//______________________________________________________________________________________________________
+ApexVDCPlaneCalib ApexVDCBenchGenerator::MakeCalib() const
+{
+    ApexVDCPlaneCalib calib;
+
+    calib.nwires          = fConfig.nwires;
+    calib.wire_spacing    = fConfig.wire_spacing;
+    calib.first_wire_pos  = -0.5*fConfig.wire_spacing*(fConfig.nwires - 1);
+    calib.tdc_resolution  = fConfig.tdc_resolution;
+    calib.tdc_rawtime_min = fConfig.tdc_rawtime_min;
+    calib.tdc_rawtime_max = fConfig.tdc_rawtime_max;
+
+    calib.MakeWires(vector<double>(fConfig.nwires, fConfig.tdc_offset));
+
+    return calib;
+}
+
+//______________________________________________________________________________________________________
+ApexVDCBenchDetMap ApexVDCBenchGenerator::MakeDetMap() const
+{
+    //wires are spread over as many TDC modules as are needed, in order
+    ApexVDCBenchDetMap detmap;
+
+    const int nchan = fConfig.nchan_per_module;
+
+    for (int first=0, module=0; first < fConfig.nwires; first += nchan, module++) {
+        const int last = min(first + nchan, fConfig.nwires) - 1;
+        detmap.AddModule(module, 0, last - first, first);
+    }
+    return detmap;
+}
+
+//______________________________________________________________________________________________________
+ApexVDCBenchEvData ApexVDCBenchGenerator::MakeEvData() const
+{
+    const int nchan = fConfig.nchan_per_module;
+    return ApexVDCBenchEvData( (fConfig.nwires + nchan - 1)/nchan, nchan );
+}
+
+//______________________________________________________________________________________________________
+int ApexVDCBenchGenerator::GetNDeadWires() const
+{
+    return count(fDead.begin(), fDead.end(), 1);
+}
+
+//______________________________________________________________________________________________________
+void ApexVDCBenchGenerator::AddHit(ApexVDCBenchEvData& evdata, int wire, double drift_time)
+{
+    if (wire < 0 || wire >= fConfig.nwires || fDead[wire]) return;
+
+    //common-stop TDC: realtime = offset - resolution*rawtime
+    const double raw = (fConfig.tdc_offset - drift_time) / fConfig.tdc_resolution;
+    if (raw < 0.) return;
+
+    const int nchan = fConfig.nchan_per_module;
+    evdata.AddHit( wire / nchan, wire % nchan, (unsigned int)raw );
+}
+
+//______________________________________________________________________________________________________
+void ApexVDCBenchGenerator::Generate(ApexVDCBenchEvData& evdata)
+{
+    evdata.Clear();
+
+    uniform_real_distribution<double> flat(0., 1.);
+    exponential_distribution<double>  delay(1./fConfig.multihit_delay);
+    poisson_distribution<int>         ntracks_dist(fConfig.ntracks_mean);
+    normal_distribution<double>       angle_dist(fConfig.track_angle, fConfig.track_angle_spread);
+
+    const double deg = M_PI/180.;
+    const double plane_width = fConfig.wire_spacing*fConfig.nwires;
+
+    //tracks
+    const int ntracks = ntracks_dist(fRng);
+
+    for (int t=0; t<ntracks; t++) {
+
+        const double tan_angle = tan( angle_dist(fRng)*deg );
+        const double x0 = flat(fRng)*plane_width;
+
+        //the track passes through the cell of every wire within this distance of its crossing point
+        const double reach = fConfig.cell_height*fabs(tan_angle);
+
+        const int first = (int)ceil ( (x0 - reach)/fConfig.wire_spacing );
+        const int last  = (int)floor( (x0 + reach)/fConfig.wire_spacing );
+
+        for (int wire=first; wire<=last; wire++) {
+
+            if (flat(fRng) > fConfig.track_efficiency) continue;
+
+            //(vertical) distance from the wire to the track
+            const double dist = fabs(wire*fConfig.wire_spacing - x0)/fabs(tan_angle);
+            const double time = dist / fConfig.drift_velocity;
+
+            AddHit(evdata, wire, time);
+
+            if (flat(fRng) < fConfig.multihit_prob) AddHit(evdata, wire, time + delay(fRng));
+        }
+    }
+
+    //noise
+    const double noise_time_max = fConfig.noise_rawtime_max*fConfig.tdc_resolution;
+
+    for (int wire=0; wire<fConfig.nwires; wire++) {
+
+        if (flat(fRng) >= fConfig.noise_occupancy) continue;
+
+        const double time = fConfig.tdc_offset - flat(fRng)*noise_time_max;
+
+        AddHit(evdata, wire, time);
+
+        if (flat(fRng) < fConfig.multihit_prob) AddHit(evdata, wire, time + delay(fRng));
+    }
+}
+//______________________________________________________________________________________________________
@@ -0,0 +1,77 @@
+#ifndef ApexVDCBenchGenerator_H
+#define ApexVDCBenchGenerator_H
+////////////////////////////////////////////////////////////////////////////////////////
+//
+//  class: ApexVDCBenchGenerator
+//  Generates synthetic raw TDC data for one VDC plane, using realistic detector parameters:
+//
+//   - tracks cross the plane at a (configurable) angle, and fire every wire whose cell they
+//     pass through, with a drift time given by the distance from track to wire.
+//   - every wire can fire at random (noise), with a flat raw TDC distribution.
+//   - a fired wire can produce extra (later) hits, as multi-hit TDCs record after-pulses.
+//   - a list of dead wires never produce any hits.
+//
+//  The raw data is written into an ApexVDCBenchEvData, laid out across TDC modules the same
+//  way as the ApexVDCBenchDetMap made by MakeDetMap().
+//
+//  - Seth H 28 Sep 25
+////////////////////////////////////////////////////////////////////////////////////////
+
+#include "ApexVDCBenchEvData.h"
+#include "ApexVDCPlaneCalib.h"
+#include <random>
+#include <vector>
+
+class ApexVDCBenchGenerator {
+
+public:
+    struct Config {
+        int     nwires          = 368;
+        double  wire_spacing    = 4.243e-3;  //[m]
+        double  tdc_resolution  = 0.5e-9;    //[s]
+        double  tdc_offset      = 1.0e-6;    //timing offset of every wire [s]
+        double  tdc_rawtime_min = 0.;
+        double  tdc_rawtime_max = 2200.;
+        double  noise_rawtime_max = 2600.;   //noise hits are flat in [0, noise_rawtime_max)
+
+        int     nchan_per_module = 96;       //TDC channels per module
+
+        double  track_angle     = 45.;       //angle of tracks w.r.t. the plane normal [deg]
+        double  track_angle_spread = 5.;     //(gaussian) spread of track angle [deg]
+        double  ntracks_mean    = 1.2;       //mean number of tracks per event (poisson)
+        double  cell_height     = 13.e-3;    //largest drift distance (half-gap between planes) [m]
+        double  drift_velocity  = 50.e-6/1e-9; //[m/s]
+        double  track_efficiency = 0.98;     //chance that a wire on a track actually fires
+
+        double  noise_occupancy = 0.01;      //chance that any one wire fires at random, per event
+        double  multihit_prob   = 0.10;      //chance that a fired wire records another (later) hit
+        double  multihit_delay  = 60.e-9;    //mean delay of the extra hit [s]
+        double  dead_fraction   = 0.01;      //fraction of dead wires
+
+        unsigned int seed       = 12345;
+    };
+
+private:
+    Config              fConfig;
+    std::mt19937_64     fRng;
+    std::vector<char>   fDead;      //1 for each dead wire
+
+    void AddHit(ApexVDCBenchEvData& evdata, int wire, double drift_time);
+
+public:
+    explicit ApexVDCBenchGenerator(const Config& config);
+
+    const Config& GetConfig() const { return fConfig; }
+
+    //calibration & detector map which match the generated data
+    ApexVDCPlaneCalib  MakeCalib() const;
+    ApexVDCBenchDetMap MakeDetMap() const;
+    ApexVDCBenchEvData MakeEvData() const;
+
+    int GetNDeadWires() const;
+
+    //generate one event (clears 'evdata' first)
+    void Generate(ApexVDCBenchEvData& evdata);
+};
+
+#endif
@@ -0,0 +1,84 @@
+#ifndef ApexVDCTest_H
+#define ApexVDCTest_H
+////////////////////////////////////////////////////////////////////////////////////////
+//
+//  namespace: ApexVDCTest
+//  The few things every test program (tests/ApexVDCTest*.cxx) needs: a check macro which
+//  counts (and prints) failures instead of stopping at the first one, a temporary directory,
+//  and events from the benchmark's generator (see bench/ApexVDCBenchGenerator.h), so that
+//  the tests decode the same kind of events as ApexOfflineBench.
+//
+//  Each test program returns 0 if all of its checks passed, 1 if any failed, and
+//  kSkipped (77) if it could not run here (e.g. no AVX2), which ctest reports as skipped.
+//
+//  Like the benchmark, the tests only use the Podd-independent sources, so they can be
+//  built without Podd or ROOT (-DAPEXOFFLINE_BENCH_ONLY=ON).
+//
+//  - Seth H 28 Sep 25
+////////////////////////////////////////////////////////////////////////////////////////
+
+#include "ApexVDCBenchGenerator.h"
+#include "ApexVDCBenchEvData.h"
+#include "ApexVDCPlaneEvent.h"
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+//check 'cond'; if it's false, print where (and 'cond') and count it as a failure
+#define APEXVDC_CHECK(cond) \
+    ApexVDCTest::Check((cond), #cond, __FILE__, __LINE__)
+
+//same as APEXVDC_CHECK, but with a printf-style message saying what was being checked
+#define APEXVDC_CHECK_MSG(cond, ...) \
+    do { if (!ApexVDCTest::Check((cond), #cond, __FILE__, __LINE__)) { \
+        fprintf(stderr, "    "); fprintf(stderr, __VA_ARGS__); fprintf(stderr, "\n"); } } while (0)
+
+namespace ApexVDCTest {
+
+    const int kSkipped = 77;    //exit code of a skipped test (see SKIP_RETURN_CODE in CMakeLists.txt)
+
+    inline int& NChecks() { static int n = 0; return n; }
+    inline int& NFailed() { static int n = 0; return n; }
+
+    inline bool Check(bool ok, const char* cond, const char* file, int line)
+    {
+        NChecks()++;
+        if (!ok) {
+            NFailed()++;
+            fprintf(stderr, "%s:%d: check failed: %s\n", file, line, cond);
+        }
+        return ok;
+    }
+
+    //print a summary of all checks, and return the exit code of the test program
+    inline int Summary(const char* name)
+    {
+        printf("%s: %d checks, %d failed\n", name, NChecks(), NFailed());
+        return NFailed() > 0 ? 1 : 0;
+    }
+
+    //make a new, empty temporary directory. exits if it can't.
+    inline std::string MakeTempDir(const char* name)
+    {
+        const char* tmp = getenv("TMPDIR");
+        std::string path = std::string(tmp && *tmp ? tmp : "/tmp") + "/" + name + ".XXXXXX";
+
+        if (!mkdtemp(&path[0])) {
+            fprintf(stderr, "can't make a temporary directory '%s'\n", path.c_str());
+            exit(1);
+        }
+        return path;
+    }
+
+    //generate the next event of 'generator', and store all of its raw hits in 'event' (after clearing it)
+    inline void StoreEvent(ApexVDCBenchGenerator& generator, const ApexVDCBenchDetMap& detmap,
+                           ApexVDCBenchEvData& evdata, const ApexVDCPlaneCalib& calib, ApexVDCPlaneEvent& event)
+    {
+        generator.Generate(evdata);
+
+        event.Clear();
+        detmap.ForEachHit(evdata, [&](int lchan, unsigned int data) { event.StoreHit(calib, lchan, data); });
+    }
+}
+
+#endif
@@ -0,0 +1,223 @@
+////////////////////////////////////////////////////////////////////////////////////////
+//
+//  ApexVDCTestCalibCache
+//  An ApexVDCPlaneDB written to the calibration cache must come back exactly as it was,
+//  and only with the key it was written with. Also checks the key itself: it must change
+//  when the DB file changes (and only then is the file read again), and pick up the right
+//  validity timestamp for the run date.
+//
+//  - Seth H 28 Sep 25
+////////////////////////////////////////////////////////////////////////////////////////
+
+#include "ApexVDCTest.h"
+#include "ApexVDCCalibCache.h"
+#include <cstdio>
+#include <cstring>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+using namespace std;
+
+namespace {
+
+    //a DB with something other than the default in every field. (it is value-initialized, so that the 
+    // padding of its scalars is zero, like that of a DB read from the cache.) 
+    ApexVDCPlaneDB MakeDB()
+    {
+        ApexVDCPlaneDB db = ApexVDCPlaneDB();
+
+        db.s.center[0] = 0.1; db.s.center[1] = -0.2; db.s.center[2] = 0.335;
+        db.s.length          = 2.1;
+        db.s.width           = 0.29;
+        db.s.nwires          = 368;
+        db.s.first_wire_pos  = 0.7794;
+        db.s.wire_spacing    = -0.0042426;
+        db.s.wire_angle      = -45.;
+        db.s.tdc_resolution  = 0.5e-9;
+        db.s.tdc_rawtime_min = 300.;
+        db.s.tdc_rawtime_max = 2100.;
+        db.s.group_hits_min  = 3;
+        db.s.group_span_min  = 3;
+        db.s.group_span_max  = 9;
+        db.s.group_max_gap   = 1;
+        db.s.fit_sigma       = 150.e-6;
+        db.s.ttd_nbins       = 50;
+        db.s.reftime_chan[0] = 4; db.s.reftime_chan[1] = 17; db.s.reftime_chan[2] = 95;
+        db.s.reftime_min     = -40.e-9;
+        db.s.reftime_max     = 350.e-9;
+        db.s.hot_enable      = 1;
+        db.s.t0_enable       = 1;
+        db.s.last_stage      = ApexVDCPlaneEvent::kStageOutput;
+        db.s.hits_reserve    = 200;
+
+        for (int i=0; i<4; i++) { db.detmap.push_back(i); db.detmap.push_back(96*i); }
+        db.badlist = { 3, 77, 300 };
+        for (int i=0; i<db.s.nwires; i++) db.tdc_offsets.push_back(1.e-6 + i*1.e-12);
+        for (int i=0; i<db.s.ttd_nbins; i++) db.ttd_table.push_back(i*5.e-5);
+        db.ttd_conv    = "table";
+        db.description = "U1 plane";
+        db.reftime_var = "R.s2.time";
+        db.t0_output   = "u1.t0.db";
+
+        return db;
+    }
+
+    //the scalars are compared byte by byte, up to the end of their last member (the padding after it is 
+    // not copied when an ApexVDCPlaneDB is assigned, so it may differ) 
+    const size_t kScalarsEnd = offsetof(ApexVDCPlaneDB::Scalars, groups_reserve) + sizeof(int);
+
+    bool Same(const ApexVDCPlaneDB& a, const ApexVDCPlaneDB& b)
+    {
+        return memcmp(&a.s, &b.s, kScalarsEnd) == 0 &&
+               a.detmap == b.detmap && a.badlist == b.badlist && a.tdc_offsets == b.tdc_offsets &&
+               a.ttd_table == b.ttd_table && a.ttd_conv == b.ttd_conv && a.description == b.description &&
+               a.reftime_var == b.reftime_var && a.t0_output == b.t0_output;
+    }
+
+    //write a text file, and open it for reading
+    FILE* MakeFile(const string& path, const char* text)
+    {
+        FILE* file = fopen(path.c_str(), "w");
+        if (file) { fputs(text, file); fclose(file); }
+        return fopen(path.c_str(), "r");
+    }
+}
+
+//______________________________________________________________________________________________________
+int main()
+{
+    const string dir = ApexVDCTest::MakeTempDir("ApexVDCTestCalibCache");
+    ApexVDCCalibCache::SetDirectory(dir.c_str());
+
+    //round trip
+    const ApexVDCPlaneDB db = MakeDB();
+
+    ApexVDCCalibCache::Key key;
+    key.hash     = 0x0123456789abcdefull;
+    key.validity = 20190214000000LL;
+
+    const string path = ApexVDCCalibCache::MakePath("R.vdc.u1.", key);
+    APEXVDC_CHECK(!path.empty());
+    APEXVDC_CHECK(ApexVDCCalibCache::Write(path, key, db));
+
+    ApexVDCPlaneDB back;
+    APEXVDC_CHECK(ApexVDCCalibCache::Read(path, key, back));
+    APEXVDC_CHECK(Same(db, back));
+
+    //the padding of the scalars is written as zeros, so the same DB always gives the same file (here, the 
+    // bytes between 'nwires' & the double after it are set to something else) 
+    {
+        ApexVDCPlaneDB dirty = db;
+        unsigned char* bytes = reinterpret_cast<unsigned char*>(&dirty.s);
+        for (size_t i = offsetof(ApexVDCPlaneDB::Scalars, nwires) + sizeof(int);
+                    i < offsetof(ApexVDCPlaneDB::Scalars, first_wire_pos); i++) bytes[i] = 0xa5;
+
+        const string dirty_path = dir + "/dirty.cache";
+        APEXVDC_CHECK(ApexVDCCalibCache::Write(dirty_path, key, dirty));
+
+        auto slurp = [](const string& name) {
+            string text;
+            FILE* file = fopen(name.c_str(), "rb");
+            if (file) {
+                char chunk[4096];
+                size_t n;
+                while ((n = fread(chunk, 1, sizeof(chunk), file)) > 0) text.append(chunk, n);
+                fclose(file);
+            }
+            return text;
+        };
+        const string clean_bytes = slurp(path), dirty_bytes = slurp(dirty_path);
+        APEXVDC_CHECK(!clean_bytes.empty() && clean_bytes == dirty_bytes);
+
+        remove(dirty_path.c_str());
+    }
+
+    //a different key (an edited DB file, or another validity period) must not match
+    ApexVDCPlaneDB untouched;
+    ApexVDCCalibCache::Key other = key;
+    other.hash++;
+    APEXVDC_CHECK(!ApexVDCCalibCache::Read(path, other, untouched));
+    other = key;
+    other.validity = 20190301000000LL;
+    APEXVDC_CHECK(!ApexVDCCalibCache::Read(path, other, untouched));
+    APEXVDC_CHECK(untouched.detmap.empty() && untouched.s.nwires == 0);
+
+    //a truncated file must not be read
+    {
+        FILE* file = fopen(path.c_str(), "r+");
+        APEXVDC_CHECK(file != nullptr);
+        if (file) {
+            fseek(file, 0, SEEK_END);
+            const long size = ftell(file);
+            fclose(file);
+            APEXVDC_CHECK(truncate(path.c_str(), size - 8) == 0);
+        }
+        APEXVDC_CHECK(!ApexVDCCalibCache::Read(path, key, untouched));
+    }
+
+    //the key of a DB file: the hash changes with the contents, and the validity is the latest
+    // timestamp which is not after the run
+    const char* text =
+        "[ 2019-01-01 00:00:00 ]\n"
+        "R.vdc.u1.tdc.min = 300\n"
+        "[ 2019-02-10 12:00:00 ]\n"
+        "R.vdc.u1.tdc.min = 310\n"
+        "[ 2019-03-01 ]\n"
+        "R.vdc.u1.tdc.min = 320\n";
+
+    FILE* file = MakeFile(dir + "/db_R.vdc.dat", text);
+    ApexVDCCalibCache::Key k1, k2, k3;
+    APEXVDC_CHECK(file && ApexVDCCalibCache::MakeKey(file, 20190214120000LL, k1));
+    if (file) fclose(file);
+    APEXVDC_CHECK(k1.validity == 20190210120000LL);
+
+    file = MakeFile(dir + "/db_R.vdc.dat", text);
+    APEXVDC_CHECK(file && ApexVDCCalibCache::MakeKey(file, 20190301000000LL, k2));
+    if (file) fclose(file);
+    APEXVDC_CHECK(k2.validity == 20190301000000LL && k2.hash == k1.hash);
+
+    file = MakeFile(dir + "/db_R.vdc.dat", (string(text) + "R.vdc.u1.tdc.max = 2100\n").c_str());
+    APEXVDC_CHECK(file && ApexVDCCalibCache::MakeKey(file, 20190214120000LL, k3));
+    if (file) fclose(file);
+    APEXVDC_CHECK(k3.hash != k1.hash && k3.validity == k1.validity);
+
+    //a file which is unchanged (same size & modification time) is not read again: an edit which keeps 
+    // both goes unnoticed, but one which only keeps the size does not. (the validity is still found 
+    // for each run date.) 
+    const string db_path = dir + "/db_R.vdc.dat";
+    string same_size = text;
+    same_size[same_size.size() - 2] = '1';     //tdc.min = 321
+
+    ApexVDCCalibCache::Key k4, k5, k6;
+    struct stat st;
+
+    file = MakeFile(db_path, text);
+    APEXVDC_CHECK(file && fstat(fileno(file), &st) == 0);
+    APEXVDC_CHECK(file && ApexVDCCalibCache::MakeKey(file, 20190214120000LL, k4));
+    if (file) fclose(file);
+    APEXVDC_CHECK(k4.hash == k1.hash);
+
+    const timespec same_time[2]  = { st.st_atim, st.st_mtim };
+    const timespec later_time[2] = { st.st_atim, { st.st_mtim.tv_sec + 1, st.st_mtim.tv_nsec } };
+
+    file = MakeFile(db_path, same_size.c_str());
+    APEXVDC_CHECK(utimensat(AT_FDCWD, db_path.c_str(), same_time, 0) == 0);
+    APEXVDC_CHECK(file && ApexVDCCalibCache::MakeKey(file, 20190301120000LL, k5));
+    APEXVDC_CHECK(k5.hash == k1.hash && k5.validity == 20190301000000LL);
+
+    APEXVDC_CHECK(utimensat(AT_FDCWD, db_path.c_str(), later_time, 0) == 0);
+    APEXVDC_CHECK(file && ApexVDCCalibCache::MakeKey(file, 20190301120000LL, k6));
+    if (file) fclose(file);
+    APEXVDC_CHECK(k6.hash != k1.hash && k6.hash != k3.hash && k6.validity == 20190301000000LL);
+
+    remove(path.c_str());
+    remove((dir + "/db_R.vdc.dat").c_str());
+    rmdir(dir.c_str());
+
+    return ApexVDCTest::Summary("ApexVDCTestCalibCache");
+}
+//______________________________________________________________________________________________________
@@ -0,0 +1,109 @@
+////////////////////////////////////////////////////////////////////////////////////////
+//
+//  ApexVDCTestClusterFit
+//  ApexVDCClusterFit::Fit() on perfect tracks: the fitted crossing position & slope must be
+//  those of the track, with chi2 ~ 0. The same tracks are fit on a plane with a positive &
+//  with a negative wire spacing (as in most Hall A VDC DBs), which must give the same result.
+//
+//  - Seth H 28 Sep 25
+////////////////////////////////////////////////////////////////////////////////////////
+
+#include "ApexVDCTest.h"
+#include "ApexVDCClusterFit.h"
+#include <cmath>
+#include <random>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+    const int    kNWires  = 368;
+    const double kSpacing = 0.0042426;  //[m]
+
+    struct Result { size_t nfit; vector<double> pos, slope, chi2; vector<int> pivot; };
+
+    //make one group of hits for each track (crossing position, slope), on a plane with this wire spacing,
+    // and fit them all at once. each track fires 'nwires' wires around its crossing point, and the
+    // closest wire to the track also gets a later (after-pulse) hit, which the fit must ignore.
+    Result FitTracks(double spacing, const vector<double>& track_pos, const vector<double>& track_slope, int nwires)
+    {
+        //wire 'i' is at first + i*spacing, so that the plane is centered on 0 either way
+        const double first = -0.5*spacing*(kNWires - 1);
+
+        vector<double> pos, dist;
+        vector<int>    wire, start, end;
+
+        for (size_t t=0; t<track_pos.size(); t++) {
+
+            const int center = (int)lround((track_pos[t] - first)/spacing);
+
+            start.push_back(pos.size());
+            for (int w=center - nwires/2; w<center - nwires/2 + nwires; w++) {
+                const double x = first + w*spacing;
+                const double d = track_slope[t]*fabs(x - track_pos[t]);
+
+                pos.push_back(x); dist.push_back(d); wire.push_back(w);
+
+                if (w == center) { pos.push_back(x); dist.push_back(d + 3.e-3); wire.push_back(w); }
+            }
+            end.push_back(pos.size() - 1);
+        }
+
+        const size_t ngroups = start.size();
+
+        Result r;
+        r.pos.resize(ngroups); r.slope.resize(ngroups); r.chi2.resize(ngroups); r.pivot.resize(ngroups);
+
+        vector<double> scratch;
+        r.nfit = ApexVDCClusterFit::Fit( pos.data(), dist.data(), wire.data(), start.data(), end.data(), ngroups,
+                                         200.e-6, r.pos.data(), r.slope.data(), r.chi2.data(), r.pivot.data(),
+                                         scratch );
+        return r;
+    }
+}
+
+//______________________________________________________________________________________________________
+int main()
+{
+    mt19937_64 rng(31415);
+    uniform_real_distribution<double> pos_dist(-0.7, 0.7);
+    uniform_real_distribution<double> slope_dist(0.6, 1.6);     //tracks at ~30-60 deg from the normal
+
+    vector<double> track_pos, track_slope;
+    for (int t=0; t<500; t++) { track_pos.push_back(pos_dist(rng)); track_slope.push_back(slope_dist(rng)); }
+
+    for (int nwires : { 3, 5, 7 }) {
+
+        const Result pos_spacing = FitTracks(+kSpacing, track_pos, track_slope, nwires);
+        const Result neg_spacing = FitTracks(-kSpacing, track_pos, track_slope, nwires);
+
+        APEXVDC_CHECK_MSG(pos_spacing.nfit == track_pos.size(), "%d wires, spacing > 0: %zu of %zu fit",
+                          nwires, pos_spacing.nfit, track_pos.size());
+        APEXVDC_CHECK_MSG(neg_spacing.nfit == track_pos.size(), "%d wires, spacing < 0: %zu of %zu fit",
+                          nwires, neg_spacing.nfit, track_pos.size());
+
+        int nbad = 0;
+
+        for (size_t t=0; t<track_pos.size(); t++) {
+            for (const Result* r : { &pos_spacing, &neg_spacing }) {
+
+                const bool ok = fabs(r->pos[t]   - track_pos[t])   < 1.e-9 &&
+                                fabs(r->slope[t] - track_slope[t]) < 1.e-6 &&
+                                r->chi2[t] >= 0. && r->chi2[t] < 1.e-6;
+                nbad += !ok;
+
+                APEXVDC_CHECK_MSG(ok, "%d wires, spacing %s 0, track at %.6f (slope %.4f): fit pos %.6f, slope %.4f, chi2 %g",
+                                  nwires, r == &pos_spacing ? ">" : "<", track_pos[t], track_slope[t],
+                                  r->pos[t], r->slope[t], r->chi2[t]);
+                if (nbad > 10) break;
+            }
+        }
+
+        printf("%d wires/track: %zu tracks, fit with spacing > 0: %zu, spacing < 0: %zu, %d wrong\n",
+               nwires, track_pos.size(), pos_spacing.nfit, neg_spacing.nfit, nbad);
+    }
+
+    return ApexVDCTest::Summary("ApexVDCTestClusterFit");
+}
+//______________________________________________________________________________________________________
@@ -0,0 +1,137 @@
+////////////////////////////////////////////////////////////////////////////////////////
+//
+//  ApexVDCTestClusterMatch
+//  ApexVDCClusterMatch::MatchUV() must make exactly the tracks which a loop over every U
+//  pair & V pair makes, while examining fewer combinations. Checked with random pairs on
+//  the usual +-45 deg planes, on planes at 0 & 90 deg (where x or y does not depend on v),
+//  and with chambers which only cut in x, or not at all.
+//
+//  - Seth H 28 Sep 25
+////////////////////////////////////////////////////////////////////////////////////////
+
+#include "ApexVDCTest.h"
+#include "ApexVDCClusterMatch.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+    //the tracks a loop over all U & V pairs makes (see ApexVDC::CoarseTrack() before it was indexed)
+    vector<ApexVDCTrackPair> MatchAll(const vector<ApexVDCClusterPair>& upairs,
+                                      const vector<ApexVDCClusterPair>& vpairs, const ApexVDCUVGeometry& geom)
+    {
+        const double sin_u = sin(geom.u_angle), cos_u = cos(geom.u_angle);
+        const double sin_v = sin(geom.v_angle), cos_v = cos(geom.v_angle);
+        const double sin_vu = sin(geom.v_angle - geom.u_angle);
+
+        auto inside = [&](const ApexVDCClusterPair& up, const ApexVDCClusterPair& vp, int c) {
+
+            const ApexVDCUVGeometry::Area& a = geom.area[c];
+
+            const double u = up.pos + up.slope*(a.z - geom.z_u);
+            const double v = vp.pos + vp.slope*(a.z - geom.z_v);
+
+            const double x = (u*sin_v - v*sin_u) / sin_vu;
+            const double y = (v*cos_u - u*cos_v) / sin_vu;
+
+            return (a.length <= 0. || fabs(x - a.x) <= 0.5*a.length + geom.margin) &&
+                   (a.width  <= 0. || fabs(y - a.y) <= 0.5*a.width  + geom.margin);
+        };
+
+        vector<ApexVDCTrackPair> tracks;
+        for (size_t i=0; i<upairs.size(); i++)
+            for (size_t j=0; j<vpairs.size(); j++)
+                if (inside(upairs[i], vpairs[j], 0) && inside(upairs[i], vpairs[j], 1))
+                    tracks.push_back({ (int)i, (int)j });
+
+        return tracks;
+    }
+
+    bool Less(const ApexVDCTrackPair& a, const ApexVDCTrackPair& b)
+    {
+        return a.u < b.u || (a.u == b.u && a.v < b.v);
+    }
+}
+
+//______________________________________________________________________________________________________
+int main()
+{
+    mt19937_64 rng(20250928);
+
+    //chamber geometry, roughly that of the Hall A VDCs (the upper chamber 0.335 m above & 0.335 m further
+    // along x). the pairs' positions are spread over more than the chambers, so that many pairs miss them.
+    ApexVDCUVGeometry base;
+    base.u_angle = -M_PI/4.;
+    base.v_angle =  M_PI/4.;
+    base.z_u     = 0.;
+    base.z_v     = 0.026;
+    base.area[0] = { 0.,    0.,    0., 2.118, 0.288 };
+    base.area[1] = { 0.335, 0.335, 0., 2.118, 0.288 };
+    base.margin  = 0.02;
+
+    struct Case { const char* name; double u_angle, v_angle; double width0, width1, length0, length1; };
+
+    const Case cases[] = {
+        { "u -45, v +45",        -M_PI/4., M_PI/4., 0.288, 0.288, 2.118, 2.118 },
+        { "u 0, v 90",            0.,      M_PI/2., 0.288, 0.288, 2.118, 2.118 },
+        { "u 90, v 0",            M_PI/2., 0.,      0.288, 0.288, 2.118, 2.118 },
+        { "lower cuts x only",   -M_PI/4., M_PI/4., 0.,    0.288, 2.118, 2.118 },
+        { "no size",             -M_PI/4., M_PI/4., 0.,    0.,    0.,    0.    },
+    };
+
+    vector<ApexVDCVIndex>    index;
+    vector<ApexVDCTrackPair> tracks;
+
+    for (const Case& c : cases) {
+
+        ApexVDCUVGeometry geom = base;
+        geom.u_angle        = c.u_angle;
+        geom.v_angle        = c.v_angle;
+        geom.area[0].width  = c.width0;  geom.area[1].width  = c.width1;
+        geom.area[0].length = c.length0; geom.area[1].length = c.length1;
+
+        uniform_real_distribution<double> pos(-1.2, 1.2), slope(0.4, 1.6);
+        uniform_int_distribution<int>     npairs(0, 40);
+
+        size_t nwrong = 0, ncand = 0, ncomb = 0, ntracks = 0;
+
+        for (int ev=0; ev<2000; ev++) {
+
+            vector<ApexVDCClusterPair> upairs(npairs(rng)), vpairs(npairs(rng));
+            for (auto& p : upairs) p = { 0, 0, pos(rng), slope(rng) };
+            for (auto& p : vpairs) p = { 0, 0, pos(rng), slope(rng) };
+
+            ncand += ApexVDCClusterMatch::MatchUV(upairs, vpairs, geom, index, tracks);
+            ncomb += upairs.size()*vpairs.size();
+
+            vector<ApexVDCTrackPair> expected = MatchAll(upairs, vpairs, geom);
+
+            sort(tracks.begin(), tracks.end(), Less);
+
+            const bool same = tracks.size() == expected.size() &&
+                              equal(tracks.begin(), tracks.end(), expected.begin(),
+                                    [](const ApexVDCTrackPair& a, const ApexVDCTrackPair& b) {
+                                        return a.u == b.u && a.v == b.v; });
+
+            if (!same && nwrong++ < 5) APEXVDC_CHECK_MSG(same, "%s: event %d: %zu tracks, expected %zu",
+                                                         c.name, ev, tracks.size(), expected.size());
+            ntracks += expected.size();
+        }
+        APEXVDC_CHECK(nwrong == 0);
+        APEXVDC_CHECK(ncand <= ncomb);
+
+        printf("%-20s %zu tracks, %zu of %zu combinations examined, %zu events differ\n",
+               c.name, ntracks, ncand, ncomb, nwrong);
+    }
+
+    //no pairs on either side
+    APEXVDC_CHECK(ApexVDCClusterMatch::MatchUV({}, { { 0, 0, 0., 1. } }, base, index, tracks) == 0 && tracks.empty());
+
+    return ApexVDCTest::Summary("ApexVDCTestClusterMatch");
+}
+//______________________________________________________________________________________________________
@@ -0,0 +1,79 @@
+////////////////////////////////////////////////////////////////////////////////////////
+//
+//  ApexVDCTestHitOrder
+//  The per-wire bucket sort of ApexVDCPlaneEvent::SortHits() must give exactly the same
+//  order as std::sort() with ApexVDCHit::operator<, for quiet & busy events (above & below
+//  the size at which SortHits() switches to the bucket sort), with many hits per wire.
+//
+//  - Seth H 28 Sep 25
+////////////////////////////////////////////////////////////////////////////////////////
+
+#include "ApexVDCTest.h"
+#include "ApexVDCPlaneEvent.h"
+#include <algorithm>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+    //sort the same events with the bucket sort & std::sort(), and compare
+    void CompareSorts(const char* name, const ApexVDCBenchGenerator::Config& config, int nevents)
+    {
+        ApexVDCBenchGenerator generator(config);
+
+        ApexVDCPlaneCalib  calib  = generator.MakeCalib();
+        ApexVDCBenchDetMap detmap = generator.MakeDetMap();
+        ApexVDCBenchEvData evdata = generator.MakeEvData();
+
+        ApexVDCPlaneEvent event;
+        vector<ApexVDCHit> expected;
+
+        int nbusy = 0, nwrong = 0;
+
+        for (int iev=0; iev<nevents; iev++) {
+
+            ApexVDCTest::StoreEvent(generator, detmap, evdata, calib, event);
+            event.ConvertHits(calib);
+
+            //std::sort is stable enough here: two hits on the same wire with the same rawtime are identical
+            expected = event.hits;
+            std::sort(expected.begin(), expected.end());
+
+            calib.use_std_sort = 0;
+            event.SortHits(calib);
+
+            if (event.hits.size() >= 64) nbusy++;
+
+            bool same = event.hits.size() == expected.size();
+            for (size_t i=0; same && i<expected.size(); i++) {
+                same = event.hits[i].wire     == expected[i].wire    &&
+                       event.hits[i].rawtime  == expected[i].rawtime &&
+                       event.hits[i].realtime == expected[i].realtime;
+            }
+            if (!same) nwrong++;
+        }
+
+        APEXVDC_CHECK_MSG(nwrong == 0, "%s: %d of %d events sorted differently", name, nwrong, nevents);
+
+        printf("%s: %d events (%d with >= 64 hits), %d sorted differently\n", name, nevents, nbusy, nwrong);
+    }
+}
+
+//______________________________________________________________________________________________________
+int main()
+{
+    ApexVDCBenchGenerator::Config quiet;
+    CompareSorts("quiet", quiet, 2000);
+
+    //lots of noise & after-pulses: well above the bucket sort threshold, with several hits on many wires
+    ApexVDCBenchGenerator::Config busy;
+    busy.noise_occupancy = 0.2;
+    busy.multihit_prob   = 0.5;
+    busy.ntracks_mean    = 4.;
+    busy.seed            = 777;
+    CompareSorts("busy", busy, 2000);
+
+    return ApexVDCTest::Summary("ApexVDCTestHitOrder");
+}
+//______________________________________________________________________________________________________
@@ -0,0 +1,211 @@
+////////////////////////////////////////////////////////////////////////////////////////
+//
+//  ApexVDCTestHitStream
+//  Events written to a hit stream (see ApexVDCHitStream.h) & read back must give exactly
+//  the same hits, groups & fit results as the events which were written, with & without a
+//  reference time. Also checks that a stream is refused when it can't hold every hit (a
+//  TDC cut above 16 bits), when it is truncated, and when an event in it is corrupt, and
+//  that the calibration check works.
+//
+//  - Seth H 28 Sep 25
+////////////////////////////////////////////////////////////////////////////////////////
+
+#include "ApexVDCTest.h"
+#include "ApexVDCHitStream.h"
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+using namespace std;
+
+namespace {
+
+    //the results of one event which must survive the trip through the stream
+    struct EventColumns {
+        uint64_t            evnum = 0;
+        vector<int>         hit_wire;
+        vector<double>      hit_rawtime, hit_time, hit_dist;
+        vector<int>         group_start, group_end, group_span;
+        vector<double>      group_pos, group_slope, group_chi2;
+
+        void Fill(uint64_t ev, const ApexVDCPlaneEvent& event)
+        {
+            evnum       = ev;
+            hit_wire    = event.hit_wire;    hit_rawtime = event.hit_rawtime; hit_time   = event.hit_time;
+            hit_dist    = event.hit_dist;
+            group_start = event.group_start; group_end   = event.group_end;   group_span = event.group_span;
+            group_pos   = event.group_pos;   group_slope = event.group_slope; group_chi2 = event.group_chi2;
+        }
+    };
+
+    template<typename T> bool SameBits(const vector<T>& a, const vector<T>& b)
+    {
+        return a.size() == b.size() && (a.empty() || memcmp(a.data(), b.data(), a.size()*sizeof(T)) == 0);
+    }
+
+    bool Same(const EventColumns& a, const EventColumns& b)
+    {
+        return a.evnum == b.evnum &&
+               SameBits(a.hit_wire,    b.hit_wire)    && SameBits(a.hit_rawtime, b.hit_rawtime) &&
+               SameBits(a.hit_time,    b.hit_time)    && SameBits(a.hit_dist,    b.hit_dist)    &&
+               SameBits(a.group_start, b.group_start) && SameBits(a.group_end,   b.group_end)   &&
+               SameBits(a.group_span,  b.group_span)  && SameBits(a.group_pos,   b.group_pos)   &&
+               SameBits(a.group_slope, b.group_slope) && SameBits(a.group_chi2,  b.group_chi2);
+    }
+
+    template<typename F> bool Throws(F&& f)
+    {
+        try { f(); } catch (const exception&) { return true; }
+        return false;
+    }
+}
+
+//______________________________________________________________________________________________________
+int main()
+{
+    const string dir  = ApexVDCTest::MakeTempDir("ApexVDCTestHitStream");
+    const string path = dir + "/u1.hits";
+
+    ApexVDCBenchGenerator::Config config;
+    config.noise_occupancy = 0.05;
+    config.multihit_prob   = 0.3;
+    config.ntracks_mean    = 2.;
+
+    ApexVDCBenchGenerator generator(config);
+
+    ApexVDCPlaneCalib  calib  = generator.MakeCalib();
+    ApexVDCBenchDetMap detmap = generator.MakeDetMap();
+    ApexVDCBenchEvData evdata = generator.MakeEvData();
+
+    //write: every third event has a reference time, and the event numbers have gaps
+    const int nevents = 3000;
+
+    vector<EventColumns> written(nevents);
+    ApexVDCPlaneEvent event;
+
+    ApexVDCHitStreamWriter writer;
+    APEXVDC_CHECK(!Throws([&] { writer.Open(path.c_str(), calib); }));
+
+    long long nhits = 0, nreftime = 0;
+
+    for (int i=0; i<nevents && writer.IsOpen(); i++) {
+
+        ApexVDCTest::StoreEvent(generator, detmap, evdata, calib, event);
+        if (i % 3 == 0) { event.SetRefTime(-12.5e-9 + 1.e-9*(i % 17)); nreftime++; }
+
+        event.Process(calib);
+
+        const uint64_t evnum = 10 + 2*i + i/100;
+        written[i].Fill(evnum, event);
+        writer.Write(evnum, event);
+
+        nhits += event.hits.size();
+    }
+    APEXVDC_CHECK(writer.GetNEvents() == (uint64_t)nevents);
+    APEXVDC_CHECK(!Throws([&] { writer.Close(); }));
+
+    //read back, in reverse order (the stream has an index, so any order must work)
+    ApexVDCHitStreamReader reader;
+    APEXVDC_CHECK(!Throws([&] { reader.Open(path.c_str()); }));
+    APEXVDC_CHECK(reader.GetNEvents() == (uint64_t)nevents && reader.GetNWires() == calib.nwires);
+    APEXVDC_CHECK(reader.MatchesCalib(calib));
+
+    int nwrong = 0;
+    for (int i=nevents-1; i>=0 && reader.GetNEvents() == (uint64_t)nevents; i--) {
+
+        event.Clear();
+        const int n = reader.Read(i, calib, event);
+        event.ProcessSorted(calib);
+
+        EventColumns back;
+        back.Fill(reader.GetEventNumber(i), event);
+
+        const bool same = n == (int)written[i].hit_wire.size() && Same(written[i], back);
+        if (!same && nwrong++ < 10) APEXVDC_CHECK_MSG(same, "event %d (number %llu) differs after the round trip",
+                                                      i, (unsigned long long)written[i].evnum);
+    }
+    APEXVDC_CHECK(nwrong == 0);
+
+    printf("%d events (%lld hits, %lld with a reference time) written & read back, %d differ\n",
+           nevents, nhits, nreftime, nwrong);
+
+    //a different TDC calibration is noticed
+    ApexVDCPlaneCalib other = calib;
+    other.tdc_offsets[17] += 1.e-12;
+    APEXVDC_CHECK(!reader.MatchesCalib(other));
+    reader.Close();
+
+    //a corrupt event is refused before anything is allocated for it: an event with a (5-byte) hit count 
+    // of 4G, and one whose second wire step wraps around past wire 0 
+    {
+        vector<unsigned char> header(24);
+        FILE* file = fopen(path.c_str(), "rb");
+        APEXVDC_CHECK(file && fread(header.data(), 1, header.size(), file) == header.size());
+        if (file) fclose(file);
+
+        const vector<unsigned char> bad_events[] = {
+            { 0xff, 0xff, 0xff, 0xff, 0x0f, 0x00, 0x05, 0x02, 0x10, 0x02, 0x20, 0x02 },
+            { 0x02, 0x00, 0x05, 0xfb, 0xff, 0xff, 0xff, 0x0f, 0x10, 0x02, 0x20, 0x02 },
+        };
+
+        for (const auto& bad : bad_events) {
+
+            //header, the event, the index (event number 1 at offset 24) & the trailer
+            vector<unsigned char> bytes = header;
+            bytes.insert(bytes.end(), bad.begin(), bad.end());
+
+            const uint64_t index[2]   = { 1, header.size() };
+            const uint64_t trailer[2] = { 1, header.size() + bad.size() };
+            bytes.insert(bytes.end(), (const unsigned char*)index,   (const unsigned char*)(index + 2));
+            bytes.insert(bytes.end(), (const unsigned char*)trailer, (const unsigned char*)(trailer + 2));
+            bytes.insert(bytes.end(), { 'A','P','E','X','V','D','C','I' });
+
+            const string bad_path = dir + "/bad.hits";
+            FILE* out = fopen(bad_path.c_str(), "wb");
+            if (out) { fwrite(bytes.data(), 1, bytes.size(), out); fclose(out); }
+
+            ApexVDCHitStreamReader bad_reader;
+            APEXVDC_CHECK(!Throws([&] { bad_reader.Open(bad_path.c_str()); }));
+
+            ApexVDCPlaneEvent fresh;
+            APEXVDC_CHECK(Throws([&] { bad_reader.Read(0, calib, fresh); }));
+            APEXVDC_CHECK(fresh.raw_wire.capacity() < 1000);
+
+            bad_reader.Close();
+            remove(bad_path.c_str());
+        }
+    }
+
+    //a truncated stream is refused
+    {
+        FILE* file = fopen(path.c_str(), "r");
+        APEXVDC_CHECK(file != nullptr);
+        if (file) {
+            fseek(file, 0, SEEK_END);
+            const long size = ftell(file);
+            fclose(file);
+            APEXVDC_CHECK(truncate(path.c_str(), size - 8) == 0);
+        }
+        APEXVDC_CHECK(Throws([&] { reader.Open(path.c_str()); }));
+    }
+    remove(path.c_str());
+
+    //a TDC cut which lets through hits that don't fit in 16 bits is refused when the stream is opened
+    // (rather than at the first such hit), and no file is made
+    ApexVDCPlaneCalib wide = calib;
+    wide.tdc_rawtime_max = 70000.;
+    APEXVDC_CHECK(Throws([&] { writer.Open(path.c_str(), wide); }));
+    APEXVDC_CHECK(!writer.IsOpen() && access(path.c_str(), F_OK) != 0);
+
+    wide.tdc_rawtime_max = 65535.;
+    APEXVDC_CHECK(!Throws([&] { writer.Open(path.c_str(), wide); writer.Close(); }));
+
+    remove(path.c_str());
+    rmdir(dir.c_str());
+
+    return ApexVDCTest::Summary("ApexVDCTestHitStream");
+}
+//______________________________________________________________________________________________________
@@ -0,0 +1,150 @@
+////////////////////////////////////////////////////////////////////////////////////////
+//
+//  ApexVDCTestHotWire
+//  ApexVDCHotWireFinder on known noise patterns: nothing is reported before the window is
+//  full, a ringing wire (also at the edge of the plane) becomes hot when the window moves,
+//  wires on the bad list are never hot nor used as neighbors, a hot wire stays hot until
+//  its count falls below half of the threshold (and is released in exactly the step where
+//  it does), 'min_hits' holds on a quiet plane, and Reset() forgets everything.
+//
+//  - Seth H 28 Sep 25
+////////////////////////////////////////////////////////////////////////////////////////
+
+#include "ApexVDCTest.h"
+#include "ApexVDCHotWireFinder.h"
+#include <cstdio>
+#include <exception>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+    const int kNWires = 64;
+
+    //a window of 100 events, in 10 sub-blocks of 10 events
+    ApexVDCHotWireFinder::Config MakeConfig()
+    {
+        ApexVDCHotWireFinder::Config config;
+        config.window     = 100;
+        config.nblocks    = 10;
+        config.factor     = 10.;
+        config.min_hits   = 50;
+        config.nneighbors = 4;
+        return config;
+    }
+
+    //the hits of one event: 'rate[w]' hits on each wire w
+    vector<int> MakeEvent(const vector<int>& rate)
+    {
+        vector<int> wires;
+        for (int w=0; w<(int)rate.size(); w++)
+            for (int i=0; i<rate[w]; i++) wires.push_back(w);
+        return wires;
+    }
+
+    //fill 'nevents' events with the same hits. returns the number of Fill() calls which returned true.
+    int FillEvents(ApexVDCHotWireFinder& finder, const vector<int>& rate, int nevents)
+    {
+        const vector<int> wires = MakeEvent(rate);
+        int nchanged = 0;
+        for (int i=0; i<nevents; i++) nchanged += finder.Fill(wires.data(), wires.size());
+        return nchanged;
+    }
+}
+
+//______________________________________________________________________________________________________
+int main()
+{
+    const ApexVDCHotWireFinder::Config config = MakeConfig();
+
+    //wire 40 is on the bad list
+    vector<unsigned char> bad(kNWires, 0);
+    bad[40] = 1;
+
+    ApexVDCHotWireFinder finder;
+    finder.Init(config, kNWires, bad);
+
+    //one hit per event on every wire, and 20 on wires 0 & 20 (ringing). the bad wire 40 rings even harder.
+    vector<int> rate(kNWires, 1);
+    rate[0]  = 20;
+    rate[20] = 20;
+    rate[40] = 50;
+
+    //nothing is reported until the window is full, however hot a wire is
+    APEXVDC_CHECK(FillEvents(finder, rate, 99) == 0);
+    APEXVDC_CHECK(!finder.IsHot(0) && !finder.IsHot(20));
+
+    //the 100th event completes the window: wires 0 & 20 have 2000 hits, their neighbors 100 each. the bad
+    // wire is neither hot, nor counted as a neighbor of wire 41.
+    APEXVDC_CHECK(FillEvents(finder, rate, 1) == 1);
+    APEXVDC_CHECK(finder.GetNewHot() == vector<int>({ 0, 20 }) && finder.GetNewCold().empty());
+    APEXVDC_CHECK(finder.GetWindowCount(20) == 2000 && finder.GetNeighborMean(20) == 100.);
+    APEXVDC_CHECK(finder.GetNeighborMean(0) == 100.);
+    APEXVDC_CHECK(!finder.IsHot(40) && finder.GetNeighborMean(41) == 100.);
+
+    //the window moves in steps of one sub-block: no change within a sub-block, nor when nothing changed
+    APEXVDC_CHECK(FillEvents(finder, rate, 9) == 0);
+    APEXVDC_CHECK(FillEvents(finder, rate, 1) == 0 && finder.GetNewHot().empty());
+    APEXVDC_CHECK(finder.IsHot(20));
+
+    //wire 20 calms down to 6 hits/event. once the window only has these events, its count (600) is below
+    // the threshold (1000), but above half of it, so it stays hot.
+    rate[0]  = 1;
+    rate[20] = 6;
+    FillEvents(finder, rate, 100);
+    APEXVDC_CHECK(finder.GetWindowCount(20) == 600);
+    APEXVDC_CHECK(finder.IsHot(20));
+
+    //wire 0 dropped to 100 in the same steps, so it was released in the step where its count fell below 500
+    APEXVDC_CHECK(!finder.IsHot(0));
+
+    //at 1 hit/event, wire 20 loses 50 hits per sub-block: 550, 500 (not below half), then 450 (released)
+    rate[20] = 1;
+    APEXVDC_CHECK(FillEvents(finder, rate, 10) == 0 && finder.GetWindowCount(20) == 550);
+    APEXVDC_CHECK(FillEvents(finder, rate, 10) == 0 && finder.GetWindowCount(20) == 500 && finder.IsHot(20));
+    APEXVDC_CHECK(FillEvents(finder, rate, 10) == 1 && finder.GetWindowCount(20) == 450);
+    APEXVDC_CHECK(finder.GetNewCold() == vector<int>({ 20 }) && finder.GetNewHot().empty());
+    APEXVDC_CHECK(!finder.IsHot(20));
+
+    //Reset() forgets all counts & hot wires, and a full window is needed again
+    rate[20] = 20;
+    FillEvents(finder, rate, 100);
+    APEXVDC_CHECK(finder.IsHot(20));
+
+    finder.Reset();
+    APEXVDC_CHECK(!finder.IsHot(20) && finder.GetWindowCount(20) == 0);
+    APEXVDC_CHECK(FillEvents(finder, rate, 99) == 0 && !finder.IsHot(20));
+    APEXVDC_CHECK(FillEvents(finder, rate, 1) == 1 && finder.GetNewHot() == vector<int>({ 20 }));
+
+    //on a quiet plane, a wire needs more than 'min_hits' in the window: 45 hits aren't enough, 60 are
+    {
+        ApexVDCHotWireFinder quiet;
+        quiet.Init(config, kNWires, {});
+
+        vector<int> some(kNWires, 0), none(kNWires, 0);
+        some[5]  = 1;
+        some[50] = 1;
+
+        FillEvents(quiet, some, 45);
+        some[5] = 0;
+        FillEvents(quiet, some, 15);
+        FillEvents(quiet, none, 40);
+
+        APEXVDC_CHECK(quiet.GetWindowCount(5) == 45 && quiet.GetWindowCount(50) == 60);
+        APEXVDC_CHECK(!quiet.IsHot(5) && quiet.IsHot(50));
+    }
+
+    //a window which can't be split into sub-blocks is refused
+    {
+        ApexVDCHotWireFinder::Config wrong = config;
+        wrong.nblocks = 200;
+
+        bool thrown = false;
+        try { ApexVDCHotWireFinder().Init(wrong, kNWires, bad); } catch (const exception&) { thrown = true; }
+        APEXVDC_CHECK(thrown);
+    }
+
+    return ApexVDCTest::Summary("ApexVDCTestHotWire");
+}
+//______________________________________________________________________________________________________
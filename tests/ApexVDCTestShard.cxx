@@ -0,0 +1,214 @@
+////////////////////////////////////////////////////////////////////////////////////////
+//
+//  ApexVDCTestShard
+//  Shard plans & plane reports (see ApexVDCShard.h): a plan must cover every physics event
+//  exactly once, in order, and survive being written & read back; a report must survive the
+//  same; and MergeReports() must add up the reports of all shards in order, and refuse any
+//  report which does not match its shard. Launch() must report the exit status of every
+//  shard, and when it gives up part-way, must not leave any worker running behind it.
+//
+//  - Seth H 28 Sep 25
+////////////////////////////////////////////////////////////////////////////////////////
+
+#include "ApexVDCTest.h"
+#include "ApexVDCShard.h"
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <exception>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace {
+
+    //the report a plane would write after decoding exactly the events of 'shard'
+    ApexVDCShardReport MakeReport(const string& plane, const ApexVDCShardPlan::Shard& shard)
+    {
+        ApexVDCShardReport report;
+        report.plane           = plane;
+        report.nevents_decoded = shard.GetNEvents();
+        report.first_evnum     = shard.first_evnum;
+        report.last_evnum      = shard.last_evnum;
+        report.max_hits        = 10 + shard.index;
+        report.max_groups      = 3;
+        report.nevents_grouped = shard.GetNEvents()/2;
+        report.stats.nevents   = shard.GetNEvents();
+        report.stats.ngroups   = 2*shard.GetNEvents();
+        report.stats.time_fit  = 0.25*shard.index;
+        report.stats.hits_hist[1] = shard.index;
+        return report;
+    }
+
+    template<typename F> bool Throws(F&& f)
+    {
+        try { f(); } catch (const exception&) { return true; }
+        return false;
+    }
+}
+
+//______________________________________________________________________________________________________
+int main()
+{
+    const string dir = ApexVDCTest::MakeTempDir("ApexVDCTestShard");
+
+    //physics events with gaps in their event numbers (e.g. from scaler & EPICS events in between)
+    vector<uint32_t> evnums;
+    for (uint32_t i=0; i<1003; i++) evnums.push_back(5 + 3*i + i/100);
+
+    //plans: every event in exactly one shard, in order, with sizes which differ by at most 1
+    for (int nshards : { 1, 2, 7, 16, 1003, 5000 }) {
+
+        const ApexVDCShardPlan plan = ApexVDCShardPlan::Make("run.dat", evnums, nshards);
+
+        APEXVDC_CHECK(plan.nevents == (long long)evnums.size());
+        APEXVDC_CHECK((int)plan.shards.size() == min<int>(nshards, evnums.size()));
+
+        long long next = 1, min_size = plan.nevents, max_size = 0;
+        for (const auto& shard : plan.shards) {
+            APEXVDC_CHECK(shard.first == next);
+            APEXVDC_CHECK(shard.first_evnum == evnums[shard.first-1] && shard.last_evnum == evnums[shard.last-1]);
+            min_size = min(min_size, shard.GetNEvents());
+            max_size = max(max_size, shard.GetNEvents());
+            next = shard.last + 1;
+        }
+        APEXVDC_CHECK_MSG(next == plan.nevents + 1 && max_size - min_size <= 1, "%d shards", nshards);
+    }
+
+    //no shard smaller than 'min_events'
+    APEXVDC_CHECK(ApexVDCShardPlan::Make("run.dat", evnums, 64, 100).shards.size() == 10);
+    APEXVDC_CHECK(Throws([&] { ApexVDCShardPlan::Make("run.dat", {}, 4); }));
+
+    //plans are written & read back as they are, and a broken plan is refused
+    const ApexVDCShardPlan plan = ApexVDCShardPlan::Make("/data/apex 4650.dat", evnums, 7);
+    plan.Write(dir + "/plan.txt");
+    const ApexVDCShardPlan back = ApexVDCShardPlan::Read(dir + "/plan.txt");
+
+    APEXVDC_CHECK(back.run == plan.run && back.nevents == plan.nevents && back.shards.size() == plan.shards.size());
+    for (size_t i=0; i<plan.shards.size() && i<back.shards.size(); i++) {
+        APEXVDC_CHECK(back.shards[i].index == plan.shards[i].index &&
+                      back.shards[i].first == plan.shards[i].first && back.shards[i].last == plan.shards[i].last &&
+                      back.shards[i].first_evnum == plan.shards[i].first_evnum &&
+                      back.shards[i].last_evnum  == plan.shards[i].last_evnum);
+    }
+
+    {
+        ofstream out(dir + "/bad_plan.txt");
+        out << "# ApexVDCShardPlan 1\nrun run.dat\nnevents 100\nshard 0 1 50 1 50\nshard 1 52 100 52 100\n";
+    }
+    APEXVDC_CHECK(Throws([&] { ApexVDCShardPlan::Read(dir + "/bad_plan.txt"); }));
+    APEXVDC_CHECK(Throws([&] { ApexVDCShardPlan::Read(dir + "/missing.txt"); }));
+
+    //reports are written & read back as they are
+    const ApexVDCShardReport report = MakeReport("R.vdc.u1.", plan.shards[3]);
+    report.Write(dir + "/report.txt");
+    const ApexVDCShardReport rback = ApexVDCShardReport::Read(dir + "/report.txt");
+
+    APEXVDC_CHECK(rback.plane == report.plane && rback.nevents_decoded == report.nevents_decoded &&
+                  rback.first_evnum == report.first_evnum && rback.last_evnum == report.last_evnum &&
+                  rback.max_hits == report.max_hits && rback.max_groups == report.max_groups &&
+                  rback.nevents_grouped == report.nevents_grouped &&
+                  rback.stats.nevents == report.stats.nevents && rback.stats.ngroups == report.stats.ngroups &&
+                  rback.stats.time_fit == report.stats.time_fit && rback.stats.hits_hist[1] == report.stats.hits_hist[1]);
+
+    //merge: the reports of two planes in every shard
+    const char* const planes[] = { "R.vdc.u1.", "R.vdc.v1." };
+
+    for (const auto& shard : plan.shards) {
+        const string shard_dir = ApexVDCShard::MakeShardDir(dir, shard.index);
+        mkdir(shard_dir.c_str(), 0775);
+        for (const char* name : planes) MakeReport(name, shard).Write(ApexVDCShard::MakeReportPath(shard_dir, name));
+    }
+
+    vector<ApexVDCShardReport> merged;
+    APEXVDC_CHECK(!Throws([&] { merged = ApexVDCShard::MergeReports(plan, dir); }));
+    APEXVDC_CHECK(merged.size() == 2);
+
+    for (const auto& m : merged) {
+        APEXVDC_CHECK(m.nevents_decoded == plan.nevents);
+        APEXVDC_CHECK(m.first_evnum == evnums.front() && m.last_evnum == evnums.back());
+        APEXVDC_CHECK(m.max_hits == 10 + plan.shards.size() - 1);
+
+        long long ngrouped = 0;
+        for (const auto& shard : plan.shards) ngrouped += shard.GetNEvents()/2;
+        APEXVDC_CHECK(m.nevents_grouped == ngrouped);
+        APEXVDC_CHECK(m.stats.nevents == (unsigned long long)plan.nevents && m.stats.ngroups == 2ull*plan.nevents);
+    }
+
+    //a shard whose plane skipped an event must be refused
+    {
+        const auto& shard = plan.shards[2];
+        ApexVDCShardReport bad = MakeReport(planes[1], shard);
+        bad.nevents_decoded--;
+        bad.Write(ApexVDCShard::MakeReportPath(ApexVDCShard::MakeShardDir(dir, shard.index), planes[1]));
+    }
+    APEXVDC_CHECK(Throws([&] { ApexVDCShard::MergeReports(plan, dir); }));
+
+    //... and so must a missing report
+    MakeReport(planes[1], plan.shards[2]).Write(ApexVDCShard::MakeReportPath(ApexVDCShard::MakeShardDir(dir, 2), planes[1]));
+    remove(ApexVDCShard::MakeReportPath(ApexVDCShard::MakeShardDir(dir, 5), planes[0]).c_str());
+    APEXVDC_CHECK(Throws([&] { ApexVDCShard::MergeReports(plan, dir); }));
+
+    //launch: the exit status of each shard is passed on as it is
+    const string launch_dir = dir + "/launch";
+    const ApexVDCShardPlan small = ApexVDCShardPlan::Make("run.dat", evnums, 4);
+
+    map<int, int> statuses;
+    int nfailed = -1;
+    APEXVDC_CHECK(!Throws([&] {
+        nfailed = ApexVDCShard::Launch(small, { "sh", "-c", "exit {shard}" }, launch_dir, 2, {},
+                                       [&](int index, int status) { statuses[index] = status; });
+    }));
+    APEXVDC_CHECK(nfailed == 3 && statuses.size() == 4);
+    for (const auto& st : statuses) APEXVDC_CHECK_MSG(st.second == st.first, "shard %d: exit status %d", st.first, st.second);
+
+    //a shard which can't be started stops the launch, and the workers which are already running are 
+    // stopped (and reaped) rather than left behind
+    {
+        const string blocker = ApexVDCShard::MakeShardDir(launch_dir, 2);
+        remove((blocker + "/log.txt").c_str());
+        rmdir(blocker.c_str());
+        ofstream(blocker) << "not a directory\n";
+
+        const auto start = chrono::steady_clock::now();
+        APEXVDC_CHECK(Throws([&] { ApexVDCShard::Launch(small, { "sleep", "30" }, launch_dir, 4); }));
+        const double secs = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+        APEXVDC_CHECK_MSG(secs < 10., "Launch() took %.1f s to give up", secs);
+        APEXVDC_CHECK(waitpid(-1, nullptr, WNOHANG) < 0 && errno == ECHILD);
+
+        remove(blocker.c_str());
+    }
+
+    //if the workers can't be waited for (SIGCHLD ignored: they are reaped automatically), Launch() 
+    // must give up rather than wait forever 
+    signal(SIGCHLD, SIG_IGN);
+    APEXVDC_CHECK(Throws([&] { ApexVDCShard::Launch(small, { "true" }, launch_dir, 2); }));
+    signal(SIGCHLD, SIG_DFL);
+
+    for (const auto& shard : small.shards) {
+        const string shard_dir = ApexVDCShard::MakeShardDir(launch_dir, shard.index);
+        remove((shard_dir + "/log.txt").c_str());
+        rmdir(shard_dir.c_str());
+    }
+    rmdir(launch_dir.c_str());
+
+    //clean up
+    for (const auto& shard : plan.shards) {
+        const string shard_dir = ApexVDCShard::MakeShardDir(dir, shard.index);
+        for (const char* name : planes) remove(ApexVDCShard::MakeReportPath(shard_dir, name).c_str());
+        rmdir(shard_dir.c_str());
+    }
+    for (const char* name : { "/plan.txt", "/bad_plan.txt", "/report.txt" }) remove((dir + name).c_str());
+    rmdir(dir.c_str());
+
+    return ApexVDCTest::Summary("ApexVDCTestShard");
+}
+//______________________________________________________________________________________________________
@@ -0,0 +1,167 @@
+////////////////////////////////////////////////////////////////////////////////////////
+//
+//  ApexVDCTestT0Calib
+//  ApexVDCT0Calib on known spectra: a sharp edge at each raw TDC value within a bin must be
+//  found at exactly that value (the smoothed step is a straight line between bin centers,
+//  so the interpolation is exact), also when the hits are shifted by a reference time, and
+//  hits outside of the range (in the trash bin) must not move it. Each quality flag is
+//  checked on a spectrum made for it, along with the offsets Fit() does (not) replace, and
+//  adding the histograms of two halves of the hits must give the same edges.
+//
+//  - Seth H 28 Sep 25
+////////////////////////////////////////////////////////////////////////////////////////
+
+#include "ApexVDCTest.h"
+#include "ApexVDCT0Calib.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <exception>
+#include <functional>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+    const int    kNWires     = 10;
+    const double kResolution = 0.5e-9;  //[s]
+
+    //hits which make a spectrum: 'count(raw)' hits at each raw value in [raw_min, raw_max), shifted by 'offset'
+    struct Hits {
+        vector<int>          wire;
+        vector<unsigned int> data;
+
+        void Add(int w, int raw_min, int raw_max, const function<int(int)>& count, int offset=0)
+        {
+            for (int raw=raw_min; raw<raw_max; raw++)
+                for (int i=0; i<count(raw); i++) { wire.push_back(w); data.push_back(raw + offset); }
+        }
+    };
+
+    //a sharp edge at 'edge': 25 hits per raw value below it, on top of a flat background of 1 per raw value
+    function<int(int)> Step(int edge)
+    {
+        return [edge](int raw) { return raw >= 1000 && raw < edge ? 26 : 1; };
+    }
+}
+
+//______________________________________________________________________________________________________
+int main()
+{
+    ApexVDCT0Calib::Config config;    //raw range [0, 4096) in bins of 4, smoothed over 3 bins
+
+    ApexVDCT0Calib calib;
+    calib.Init(config, kNWires);
+
+    const int nbins = calib.GetNBins();
+    APEXVDC_CHECK(nbins == 1024);
+
+    Hits hits;
+
+    //wires 0-3: an edge at each raw value in the bin [2000, 2004). wire 0 also has hits above the range.
+    for (int w=0; w<4; w++) hits.Add(w, 0, 4096, Step(2000 + w));
+    hits.Add(0, 0, 1000, [](int) { return 1; }, 60000);
+
+    //wire 4: the same spectrum as wire 0, but written 100 raw values too high (to be shifted back)
+    Hits shifted;
+    shifted.Add(4, 0, 4096, Step(2000), 100);
+
+    //wire 5: only hits outside of the range, above it & below it (after the shift)
+    Hits trash;
+    trash.Add(5, 0, 1000, [](int) { return 1; }, 5000);
+    trash.Add(5, 0, 1000, [](int raw) { return raw < 10 ? 1 : 0; });
+
+    //wire 6: flat, no edge
+    hits.Add(6, 0, 4096, [](int) { return 4; });
+
+    //wire 7: the plateau falls off over 200 raw values, so the edge is too wide
+    hits.Add(7, 0, 4096, [](int raw) { return raw < 1000 || raw >= 2100 ? 1 : 1 + min(25, 25*(2100 - raw)/200); });
+
+    //wire 8: a good edge, but on the bad list
+    hits.Add(8, 0, 4096, Step(2000));
+
+    //wire 9: only 499 hits in the range
+    hits.Add(9, 1000, 1300, [](int) { return 1; });
+    hits.Add(9, 2000, 2199, [](int) { return 1; });
+
+    //fill half of the hits into another ApexVDCT0Calib, and add it (as the threads of a replay do)
+    ApexVDCT0Calib other;
+    other.Init(config, kNWires);
+
+    const size_t half = hits.wire.size()/2;
+    calib.Fill(hits.wire.data(),        hits.data.data(),        half);
+    other.Fill(hits.wire.data() + half, hits.data.data() + half, hits.wire.size() - half);
+    calib.Fill(shifted.wire.data(), shifted.data.data(), shifted.wire.size(), -100);
+    calib.Fill(trash.wire.data(),   trash.data.data(),   trash.wire.size(),   -20);
+    calib += other;
+
+    //the trash bin has every hit outside of the range, and the range none of them
+    double in_range = 0.;
+    for (int b=0; b<nbins; b++) in_range += calib.GetCount(5, b);
+    APEXVDC_CHECK(in_range == 0. && calib.GetCount(5, nbins) == 1010);
+    APEXVDC_CHECK(calib.GetCount(0, nbins) == 1000);
+
+    //the edges
+    for (int w=0; w<4; w++) {
+        const ApexVDCT0Calib::Edge edge = calib.FindEdge(w);
+        APEXVDC_CHECK_MSG(edge.quality == ApexVDCT0Calib::kGood && fabs(edge.raw - (2000 + w)) < 1.e-9,
+                          "wire %d: edge at %.6f (quality %d), expected %d", w, edge.raw, edge.quality, 2000 + w);
+        APEXVDC_CHECK(edge.width > 0. && edge.width < 3*4);
+    }
+    APEXVDC_CHECK(fabs(calib.FindEdge(4).raw - 2000.) < 1.e-9);
+    APEXVDC_CHECK(calib.FindEdge(7).width > config.max_width);
+
+    //the fit, and the quality flags
+    vector<unsigned char> bad(kNWires, 0);
+    bad[8] = 1;
+
+    const double old_offset = 1.e-6;
+    vector<double> offsets(kNWires, old_offset);
+    vector<int>    quality;
+
+    const int ngood = calib.Fit(kResolution, bad, offsets, quality);
+
+    const int expected[kNWires] = {
+        ApexVDCT0Calib::kGood,     ApexVDCT0Calib::kGood,     ApexVDCT0Calib::kGood,   ApexVDCT0Calib::kGood,
+        ApexVDCT0Calib::kGood,     ApexVDCT0Calib::kLowStats, ApexVDCT0Calib::kNoEdge, ApexVDCT0Calib::kWideEdge,
+        ApexVDCT0Calib::kBadWire,  ApexVDCT0Calib::kLowStats
+    };
+
+    APEXVDC_CHECK(ngood == 5);
+
+    for (int w=0; w<kNWires; w++) {
+
+        APEXVDC_CHECK_MSG(quality[w] == expected[w], "wire %d: quality %d, expected %d", w, quality[w], expected[w]);
+
+        //good wires get the offset of their edge, the others keep theirs
+        const double offset = expected[w] == ApexVDCT0Calib::kGood ? kResolution*(2000 + (w < 4 ? w : 0)) : old_offset;
+        APEXVDC_CHECK_MSG(fabs(offsets[w] - offset) < 1.e-18, "wire %d: offset %.9e, expected %.9e", w, offsets[w], offset);
+    }
+
+    //Reset() forgets all counts
+    calib.Reset();
+    APEXVDC_CHECK(calib.GetCount(0, 500) == 0 && calib.GetCount(5, nbins) == 0);
+    APEXVDC_CHECK(calib.FindEdge(0).quality == ApexVDCT0Calib::kLowStats);
+
+    //histograms with a different setup can't be added, and a wrong number of offsets is refused
+    {
+        ApexVDCT0Calib::Config wide = config;
+        wide.bin_shift = 3;
+
+        ApexVDCT0Calib coarse;
+        coarse.Init(wide, kNWires);
+
+        bool thrown = false;
+        try { calib += coarse; } catch (const exception&) { thrown = true; }
+        APEXVDC_CHECK(thrown);
+
+        vector<double> few(kNWires - 1, 0.);
+        thrown = false;
+        try { calib.Fit(kResolution, bad, few, quality); } catch (const exception&) { thrown = true; }
+        APEXVDC_CHECK(thrown);
+    }
+
+    return ApexVDCTest::Summary("ApexVDCTestT0Calib");
+}
+//______________________________________________________________________________________________________
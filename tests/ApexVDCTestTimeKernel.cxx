@@ -0,0 +1,96 @@
+////////////////////////////////////////////////////////////////////////////////////////
+//
+//  ApexVDCTestTimeKernel
+//  The AVX2 version of ApexVDCTimeKernel::Convert() must give bit-identical results to the
+//  scalar one: the same raw & real times, and the same accept flags, for any number of hits
+//  (including the leftover ones after the last group of 4), raw TDC values over the whole
+//  32-bit range, and with & without a reference-time window.
+//
+//  Skipped if this CPU (or build) has no AVX2 kernel.
+//
+//  - Seth H 28 Sep 25
+////////////////////////////////////////////////////////////////////////////////////////
+
+#include "ApexVDCTest.h"
+#include "ApexVDCTimeKernel.h"
+#include <cstring>
+#include <limits>
+#include <random>
+#include <vector>
+
+using namespace std;
+
+//______________________________________________________________________________________________________
+int main()
+{
+    if (!ApexVDCTimeKernel::HasAVX2()) {
+        printf("ApexVDCTestTimeKernel: no AVX2 kernel on this CPU/build, skipped\n");
+        return ApexVDCTest::kSkipped;
+    }
+
+    const int nwires = 368;
+
+    mt19937_64 rng(4242);
+    uniform_real_distribution<double> offset_dist(0.5e-6, 1.5e-6);
+    uniform_int_distribution<int>     wire_dist(0, nwires-1);
+    uniform_int_distribution<unsigned int> tdc_dist(0, 3000);
+    uniform_int_distribution<unsigned int> any_dist(0, numeric_limits<unsigned int>::max());
+
+    vector<double> offsets(nwires);
+    for (double& off : offsets) off = offset_dist(rng);
+
+    const double inf = numeric_limits<double>::infinity();
+
+    //(reftime, window) pairs: none, and a tight window around a reference time
+    const double windows[][3] = { { 0., -inf, inf }, { 35.e-9, -20.e-9, 400.e-9 } };
+
+    int nwrong = 0, ncases = 0;
+
+    for (int n=0; n<=67; n++) {
+        for (const auto& w : windows) {
+            for (int full_range=0; full_range<2; full_range++) {
+
+                vector<int>          wire(n);
+                vector<unsigned int> data(n);
+                for (int i=0; i<n; i++) {
+                    wire[i] = wire_dist(rng);
+                    data[i] = full_range ? any_dist(rng) : tdc_dist(rng);
+                }
+                //make sure the extremes are in there
+                if (full_range && n >= 2) { data[0] = 0; data[n-1] = numeric_limits<unsigned int>::max(); }
+
+                vector<double>        raw[2], real[2];
+                vector<unsigned char> accept[2];
+                size_t                naccept[2];
+
+                const ApexVDCTimeKernel::EMode modes[2] = { ApexVDCTimeKernel::kScalar, ApexVDCTimeKernel::kAVX2 };
+
+                for (int m=0; m<2; m++) {
+                    raw[m].assign(n, 0.); real[m].assign(n, 0.); accept[m].assign(n, 0);
+
+                    ApexVDCTimeKernel::SetMode(modes[m]);
+                    naccept[m] = ApexVDCTimeKernel::Convert( wire.data(), data.data(), n, offsets.data(),
+                                                             0.5e-9, 100., 2200., w[0], w[1], w[2],
+                                                             raw[m].data(), real[m].data(), accept[m].data() );
+                }
+
+                const bool same = naccept[0] == naccept[1] &&
+                                  memcmp(raw[0].data(),    raw[1].data(),    n*sizeof(double)) == 0 &&
+                                  memcmp(real[0].data(),   real[1].data(),   n*sizeof(double)) == 0 &&
+                                  memcmp(accept[0].data(), accept[1].data(), n) == 0;
+
+                APEXVDC_CHECK_MSG(same, "%d hits, reftime %g, full range %d: AVX2 differs from scalar", n, w[0], full_range);
+
+                nwrong += !same;
+                ncases++;
+            }
+        }
+    }
+
+    ApexVDCTimeKernel::SetMode(ApexVDCTimeKernel::kAuto);
+
+    printf("%d cases, %d differ\n", ncases, nwrong);
+
+    return ApexVDCTest::Summary("ApexVDCTestTimeKernel");
+}
+//______________________________________________________________________________________________________
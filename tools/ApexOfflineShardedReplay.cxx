@@ -0,0 +1,354 @@
+////////////////////////////////////////////////////////////////////////////////////////
+//
+//  ApexOfflineShardedReplay
+//  Replay one CODA run with many processes at once, each on its own range of events
+//  ('shard'), and merge their output back into one file in the original event order
+//  (see ApexVDCShard.h).
+//
+//  usage: ApexOfflineShardedReplay plan   --run file.dat --shards N [--min-events M] --plan plan.txt
+//         ApexOfflineShardedReplay launch --plan plan.txt --dir work [--jobs N] [--node k/n] -- command...
+//         ApexOfflineShardedReplay merge  --plan plan.txt --dir work --out merged.root
+//                                         [--output replay.root] [--tree T]
+//         ApexOfflineShardedReplay run    --run file.dat --shards N [--min-events M] --dir work [--jobs N]
+//                                         --out merged.root [--output replay.root] [--tree T] -- command...
+//
+//  'plan' reads the run once to find its physics events, and splits them into N shards of
+//  (nearly) the same size. 'launch' runs 'command' for each shard (at most --jobs at a time),
+//  with these replaced in each of its arguments:
+//
+//      {first}, {last}             first & last physics event of the shard (counting from 1)
+//      {first_evnum}, {last_evnum} their event numbers
+//      {shard}, {nevents}, {run}   index & size of the shard, and the CODA file
+//      {dir}                       the shard's directory (work/shard_0000, ...)
+//
+//  e.g. to run a replay script which takes an event range & an output file:
+//
+//      ApexOfflineShardedReplay run --run apex_4650.dat --shards 16 --jobs 16 --dir work
+//          --out apex_4650.root -- analyzer -b -q 'replay.C("{run}",{first},{last},"{dir}/replay.root")'
+//
+//  Each command writes its stdout & stderr to 'log.txt' in its directory, and each VDC plane
+//  writes a report of what it decoded there (since APEXVDC_SHARD_DIR is set). With --node
+//  k/n, only the shards k, k+n, k+2n, ... are run, so that one plan can be spread over n
+//  nodes which share 'work'; 'merge' is then run once all of them are done.
+//
+//  'merge' checks that each plane decoded exactly the events of each shard, merges the
+//  output file (--output, in each shard's directory) of all shards in order, checks that the
+//  merged tree has as many entries as the shards together, and writes the counters of each
+//  plane, summed over all shards, to work/<plane>report.txt.
+//
+//  - Seth H 28 Sep 25
+////////////////////////////////////////////////////////////////////////////////////////
+
+#include "ApexVDCShard.h"
+#include "ApexVDCPlaneStats.h"
+#include <THaCodaFile.h>
+#include <CodaDecoder.h>
+#include <TFile.h>
+#include <TTree.h>
+#include <TFileMerger.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <stdexcept>
+#include <sstream>
+#include <memory>
+#include <string>
+#include <vector>
+#include <sys/stat.h>
+
+using namespace std;
+
+namespace {
+
+    //read all events of a CODA file, and return the event numbers of its physics events (in file order). 
+    // an event which can't be decoded is fatal: skipping it here, when the analyzer in the workers may 
+    // not, would shift every shard after it, and the merge would refuse the result only after the replay. 
+    vector<uint32_t> ScanRun(const string& run)
+    {
+        const char* const here = "ScanRun";
+
+        Decoder::THaCodaFile file;
+        if (file.codaOpen(run.c_str()) != CODA_OK) {
+            ostringstream oss;
+            oss << "in <" << here << ">: can't open CODA file '" << run << "'.";
+            throw runtime_error(oss.str());
+        }
+
+        Decoder::CodaDecoder evdata;
+        evdata.SetCodaVersion(file.getCodaVersion());
+        evdata.Init();
+
+        vector<uint32_t> evnums;
+        long long nread = 0;
+
+        int status;
+        while ((status = file.codaRead()) == CODA_OK) {
+
+            nread++;
+            const int decode_status = evdata.LoadEvent(file.getEvBuffer());
+
+            if (decode_status != THaEvData::HED_OK) {
+                file.codaClose();
+                ostringstream oss;
+                oss << "in <" << here << ">: event " << nread << " of '" << run << "' (after " << evnums.size()
+                    << " physics events) could not be decoded (status " << decode_status << "). no plan was made.";
+                throw runtime_error(oss.str());
+            }
+
+            if (evdata.IsPhysicsTrigger()) evnums.push_back(evdata.GetEvNum());
+        }
+        file.codaClose();
+
+        if (status != CODA_EOF) {
+            ostringstream oss;
+            oss << "in <" << here << ">: error " << status << " reading '" << run << "' after "
+                << evnums.size() << " physics events.";
+            throw runtime_error(oss.str());
+        }
+
+        return evnums;
+    }
+
+    //make a plan for a run, and write it
+    ApexVDCShardPlan MakePlan(const string& run, int nshards, long long min_events, const string& plan_path)
+    {
+        const auto start = chrono::steady_clock::now();
+
+        const ApexVDCShardPlan plan = ApexVDCShardPlan::Make(run, ScanRun(run), nshards, min_events);
+        plan.Write(plan_path);
+
+        const double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+        printf("%s: %lld physics events in %zu shards (scanned in %.1f s). plan written to '%s'\n",
+               run.c_str(), plan.nevents, plan.shards.size(), seconds, plan_path.c_str());
+
+        return plan;
+    }
+
+    //run the shards of a plan (those of this node, if 'node' is 'k/n'). returns the number which failed.
+    int LaunchShards(const ApexVDCShardPlan& plan, const vector<string>& command, const string& dir,
+                     int njobs, const string& node)
+    {
+        vector<int> which;
+        if (!node.empty()) {
+            int k = -1, n = 0;
+            if (sscanf(node.c_str(), "%d/%d", &k, &n) != 2 || n <= 0 || k < 0 || k >= n) {
+                ostringstream oss;
+                oss << "in <LaunchShards>: bad node '" << node << "' (must be 'k/n', with 0 <= k < n).";
+                throw invalid_argument(oss.str());
+            }
+            for (const auto& shard : plan.shards) if (shard.index % n == k) which.push_back(shard.index);
+            if (which.empty()) { printf("no shards for node %s\n", node.c_str()); return 0; }
+        }
+
+        const auto start = chrono::steady_clock::now();
+
+        const int nfailed = ApexVDCShard::Launch(plan, command, dir, njobs, which, [&](int index, int status) {
+            const auto& shard = plan.shards[index];
+            printf("shard %d (events %lld-%lld): %s", index, shard.first, shard.last, status ? "FAILED" : "done");
+            if (status) printf(" (exit status %d, see '%s/log.txt')", status, ApexVDCShard::MakeShardDir(dir, index).c_str());
+            printf("\n");
+            fflush(stdout);
+        });
+
+        const double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+        const size_t nrun = which.empty() ? plan.shards.size() : which.size();
+        printf("%zu shards run in %.1f s, %d failed\n", nrun, seconds, nfailed);
+
+        return nfailed;
+    }
+
+    //number of entries of tree 'tree_name' in a file. throws if there is no such file or tree.
+    long long GetNEntries(const string& path, const string& tree_name)
+    {
+        unique_ptr<TFile> file(TFile::Open(path.c_str(), "READ"));
+        TTree* tree = (file && !file->IsZombie()) ? file->Get<TTree>(tree_name.c_str()) : nullptr;
+        if (!tree) {
+            ostringstream oss;
+            oss << "in <GetNEntries>: no tree '" << tree_name << "' in '" << path << "'.";
+            throw runtime_error(oss.str());
+        }
+        return tree->GetEntries();
+    }
+
+    //check & add up the plane reports of all shards, and merge their output files (in shard order)
+    void MergeShards(const ApexVDCShardPlan& plan, const string& dir, const string& output,
+                     const string& tree_name, const string& out_path)
+    {
+        const char* const here = "MergeShards";
+
+        //first the reports, since there is no point in merging output which is incomplete
+        const vector<ApexVDCShardReport> reports = ApexVDCShard::MergeReports(plan, dir);
+
+        for (const auto& report : reports) {
+
+            const string path = ApexVDCShard::MakeReportPath(dir, report.plane);
+            report.Write(path);
+
+            //the hits may not have been grouped in any event (see the DB key 'stages')
+            const string max_groups = report.nevents_grouped > 0 ? to_string(report.max_groups) : "not measured";
+
+            printf("%s: %lld events decoded (event numbers %u to %u). max hits/event = %u, "
+                   "max groups/event = %s. report written to '%s'\n",
+                   report.plane.c_str(), report.nevents_decoded, report.first_evnum, report.last_evnum,
+                   report.max_hits, max_groups.c_str(), path.c_str());
+
+            if (ApexVDCPlaneStats::IsEnabled()) printf("%s\n", report.stats.Summary().c_str());
+        }
+
+        //then the output, in shard order, so that the merged tree has the entries in the order of the run
+        TFileMerger merger(false);
+        merger.SetPrintLevel(0);
+
+        if (!merger.OutputFile(out_path.c_str(), "RECREATE")) {
+            ostringstream oss;
+            oss << "in <" << here << ">: can't open '" << out_path << "' for writing.";
+            throw runtime_error(oss.str());
+        }
+
+        long long nentries = 0;
+
+        for (const auto& shard : plan.shards) {
+            const string path = ApexVDCShard::MakeShardDir(dir, shard.index) + "/" + output;
+
+            nentries += GetNEntries(path, tree_name);
+
+            if (!merger.AddFile(path.c_str())) {
+                ostringstream oss;
+                oss << "in <" << here << ">: can't add '" << path << "' to the merge.";
+                throw runtime_error(oss.str());
+            }
+        }
+
+        if (!merger.Merge()) {
+            ostringstream oss;
+            oss << "in <" << here << ">: merging into '" << out_path << "' failed.";
+            throw runtime_error(oss.str());
+        }
+
+        const long long nmerged = GetNEntries(out_path, tree_name);
+        if (nmerged != nentries) {
+            ostringstream oss;
+            oss << "in <" << here << ">: tree '" << tree_name << "' of '" << out_path << "' has " << nmerged
+                << " entries, but the shards have " << nentries << ".";
+            throw runtime_error(oss.str());
+        }
+
+        printf("%zu shards merged into '%s' (%lld entries in tree '%s')\n",
+               plan.shards.size(), out_path.c_str(), nentries, tree_name.c_str());
+    }
+
+    void PrintUsage(const char* prog)
+    {
+        printf("usage: %s plan   --run file.dat --shards N [--min-events M] --plan plan.txt\n"
+               "       %s launch --plan plan.txt --dir work [--jobs N] [--node k/n] -- command...\n"
+               "       %s merge  --plan plan.txt --dir work --out merged.root [--output replay.root] [--tree T]\n"
+               "       %s run    --run file.dat --shards N [--min-events M] --dir work [--jobs N] --out merged.root\n"
+               "                 [--output replay.root] [--tree T] -- command...\n"
+               "in 'command', {first} {last} {first_evnum} {last_evnum} {shard} {nevents} {run} & {dir} are replaced\n"
+               "by the values of each shard.\n", prog, prog, prog, prog);
+    }
+}
+
+//______________________________________________________________________________________________________
+int main(int argc, char* argv[])
+{
+    if (argc < 2 || !strcmp(argv[1], "--help") || !strcmp(argv[1], "-h")) {
+        PrintUsage(argv[0]);
+        return argc < 2 ? 1 : 0;
+    }
+
+    const string mode = argv[1];
+
+    string run, plan_path, dir, node, out_path;
+    string output    = "replay.root";
+    string tree_name = "T";
+    int nshards = 0, njobs = 1;
+    long long min_events = 1;
+    vector<string> command;
+
+    for (int i=2; i<argc; i++) {
+
+        const char* arg = argv[i];
+
+        //everything after '--' is the command to run for each shard
+        if (!strcmp(arg, "--")) {
+            command.assign(argv + i + 1, argv + argc);
+            break;
+        }
+
+        if (i+1 >= argc) {
+            fprintf(stderr, "missing value for '%s'\n", arg);
+            return 1;
+        }
+        const char* val = argv[++i];
+
+        if      (!strcmp(arg, "--run"))         run        = val;
+        else if (!strcmp(arg, "--shards"))      nshards    = atoi(val);
+        else if (!strcmp(arg, "--min-events"))  min_events = atoll(val);
+        else if (!strcmp(arg, "--plan"))        plan_path  = val;
+        else if (!strcmp(arg, "--dir"))         dir        = val;
+        else if (!strcmp(arg, "--jobs"))        njobs      = atoi(val);
+        else if (!strcmp(arg, "--node"))        node       = val;
+        else if (!strcmp(arg, "--out"))         out_path   = val;
+        else if (!strcmp(arg, "--output"))      output     = val;
+        else if (!strcmp(arg, "--tree"))        tree_name  = val;
+        else {
+            fprintf(stderr, "unknown option '%s' (see --help)\n", arg);
+            return 1;
+        }
+    }
+
+    try {
+        if (mode == "plan") {
+            if (run.empty() || nshards <= 0 || plan_path.empty()) {
+                fprintf(stderr, "need --run, --shards & --plan (see --help)\n");
+                return 1;
+            }
+            MakePlan(run, nshards, min_events, plan_path);
+
+        } else if (mode == "launch") {
+            if (plan_path.empty() || dir.empty() || command.empty()) {
+                fprintf(stderr, "need --plan, --dir & a command after '--' (see --help)\n");
+                return 1;
+            }
+            if (LaunchShards(ApexVDCShardPlan::Read(plan_path), command, dir, njobs, node) > 0) return 1;
+
+        } else if (mode == "merge") {
+            if (plan_path.empty() || dir.empty() || out_path.empty()) {
+                fprintf(stderr, "need --plan, --dir & --out (see --help)\n");
+                return 1;
+            }
+            MergeShards(ApexVDCShardPlan::Read(plan_path), dir, output, tree_name, out_path);
+
+        } else if (mode == "run") {
+            if (run.empty() || nshards <= 0 || dir.empty() || out_path.empty() || command.empty()) {
+                fprintf(stderr, "need --run, --shards, --dir, --out & a command after '--' (see --help)\n");
+                return 1;
+            }
+            //(the plan is kept with the shards, so that a failed shard can be run again with 'launch')
+            mkdir(dir.c_str(), 0775);
+            const ApexVDCShardPlan plan = MakePlan(run, nshards, min_events, dir + "/plan.txt");
+
+            if (LaunchShards(plan, command, dir, njobs, "") > 0) {
+                fprintf(stderr, "not merging, since some shards failed\n");
+                return 1;
+            }
+            MergeShards(plan, dir, output, tree_name, out_path);
+
+        } else {
+            fprintf(stderr, "unknown mode '%s' (see --help)\n", mode.c_str());
+            return 1;
+        }
+
+    } catch (const exception& e) {
+        fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+
+    return 0;
+}
+//______________________________________________________________________________________________________
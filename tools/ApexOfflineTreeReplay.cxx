@@ -0,0 +1,210 @@
+////////////////////////////////////////////////////////////////////////////////////////
+//
+//  ApexOfflineTreeReplay
+//  Re-reconstruct VDC planes from the hits in replayed ROOT trees (see ApexVDCTreeReplay.h),
+//  e.g. to try out new group cuts without replaying the raw data.
+//
+//  usage: ApexOfflineTreeReplay --plane R.vdc.u1 [--plane R.vdc.v1 ...] [--tree T]
+//                               [--date "yyyy-mm-dd hh:mm:ss"] [--threads N] [--cache dir]
+//                               [--group.hitsmin N] [--group.spanmin N] [--group.spanmax N]
+//                               [--group.maxgap N] [--out out.root] files...
+//
+//  The calibration of each plane is read from the DB (at $DB_DIR) for the given date, just
+//  like in a replay, so the plane name must be the full name of the plane in the replay
+//  (which is also the prefix of its variables in the tree). If a cache directory is given
+//  (or APEXVDC_CALIB_CACHE is set), the calibration is loaded from the cache when possible
+//  (see ApexVDCCalibCache.h). Any of the group cuts given on the command line then replace
+//  the ones from the DB.
+//
+//  The output tree 'T' has one entry for each input entry (in the same order), with these
+//  branches for each plane:
+//
+//      <plane>.nhits, <plane>.ngroups,
+//      <plane>.group.nhits, .span, .pos, .slope, .chi2, .pivot
+//
+//  - Seth H 28 Sep 25
+////////////////////////////////////////////////////////////////////////////////////////
+
+#include "ApexVDCPlane.h"
+#include "ApexVDCTreeReplay.h"
+#include "ApexVDCCalibCache.h"
+#include <THaGlobals.h>
+#include <THaVarList.h>
+#include <TDatime.h>
+#include <TFile.h>
+#include <TROOT.h>
+#include <TTree.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+    //the output columns of one plane for the current entry
+    struct PlaneOutput {
+        int nhits = 0, ngroups = 0;
+        vector<int>    group_nhits, group_span, group_pivot;
+        vector<double> group_pos, group_slope, group_chi2;
+
+        void Branch(TTree* tree, const string& name) {
+            tree->Branch((name + ".nhits").c_str(),         &nhits);
+            tree->Branch((name + ".ngroups").c_str(),       &ngroups);
+            tree->Branch((name + ".group.nhits").c_str(),   &group_nhits);
+            tree->Branch((name + ".group.span").c_str(),    &group_span);
+            tree->Branch((name + ".group.pos").c_str(),     &group_pos);
+            tree->Branch((name + ".group.slope").c_str(),   &group_slope);
+            tree->Branch((name + ".group.chi2").c_str(),    &group_chi2);
+            tree->Branch((name + ".group.pivot").c_str(),   &group_pivot);
+        }
+
+        template<typename T> static void Copy(vector<T>& to, const vector<T>& from, long long first, long long last) {
+            to.assign(from.begin() + first, from.begin() + last);
+        }
+
+        void Set(const ApexVDCTreeReplay::Result& result, long long entry) {
+            const long long first = result.group_offset[entry];
+            const long long last  = result.group_offset[entry+1];
+
+            nhits   = result.nhits[entry];
+            ngroups = last - first;
+            Copy(group_nhits, result.group_nhits, first, last);
+            Copy(group_span,  result.group_span,  first, last);
+            Copy(group_pos,   result.group_pos,   first, last);
+            Copy(group_slope, result.group_slope, first, last);
+            Copy(group_chi2,  result.group_chi2,  first, last);
+            Copy(group_pivot, result.group_pivot, first, last);
+        }
+    };
+}
+
+//______________________________________________________________________________________________________
+int main(int argc, char* argv[])
+{
+    vector<string> planes;
+    vector<string> files;
+    string tree_name = "T";
+    string out_path  = "treereplay.root";
+    string date_str;
+    unsigned int nthreads = 0;     //size of ROOT's thread pool (0 = all hardware threads)
+
+    //group cuts to replace the ones from the DB (-1 = keep the DB value)
+    int hits_min = -1, span_min = -1, span_max = -1, max_gap = -1;
+
+    for (int i=1; i<argc; i++) {
+
+        const char* arg = argv[i];
+
+        if (!strcmp(arg, "--help") || !strcmp(arg, "-h")) {
+            printf("usage: %s --plane name [--plane name ...] [--tree T] [--date \"yyyy-mm-dd hh:mm:ss\"] "
+                   "[--threads N] [--cache dir] [--group.hitsmin N] [--group.spanmin N] [--group.spanmax N] "
+                   "[--group.maxgap N] [--out out.root] files...\n", argv[0]);
+            return 0;
+        }
+
+        if (strncmp(arg, "--", 2) != 0) { files.push_back(arg); continue; }
+
+        if (i+1 >= argc) {
+            fprintf(stderr, "missing value for '%s'\n", arg);
+            return 1;
+        }
+        const char* val = argv[++i];
+
+        if      (!strcmp(arg, "--plane"))           planes.push_back(val);
+        else if (!strcmp(arg, "--tree"))            tree_name = val;
+        else if (!strcmp(arg, "--date"))            date_str  = val;
+        else if (!strcmp(arg, "--threads"))         nthreads  = atoi(val);
+        else if (!strcmp(arg, "--cache"))           ApexVDCCalibCache::SetDirectory(val);
+        else if (!strcmp(arg, "--group.hitsmin"))   hits_min  = atoi(val);
+        else if (!strcmp(arg, "--group.spanmin"))   span_min  = atoi(val);
+        else if (!strcmp(arg, "--group.spanmax"))   span_max  = atoi(val);
+        else if (!strcmp(arg, "--group.maxgap"))    max_gap   = atoi(val);
+        else if (!strcmp(arg, "--out"))             out_path  = val;
+        else {
+            fprintf(stderr, "unknown option '%s' (see --help)\n", arg);
+            return 1;
+        }
+    }
+
+    if (planes.empty() || files.empty()) {
+        fprintf(stderr, "need at least one --plane, and one input file (see --help)\n");
+        return 1;
+    }
+
+    //the planes define their variables when they are initialized, so there must be a variable list
+    if (!gHaVars) gHaVars = new THaVarList;
+
+    const TDatime date = date_str.empty() ? TDatime() : TDatime(date_str.c_str());
+
+    //the entries are processed on ROOT's implicit-MT pool (see ApexVDCTreeReplay.h), which is ours to set up 
+    ROOT::EnableImplicitMT(nthreads);
+
+    try {
+        ApexVDCTreeReplay replay(files, tree_name.c_str());
+
+        vector<ApexVDCTreeReplay::Result> results(planes.size());
+
+        for (size_t p=0; p<planes.size(); p++) {
+
+            //read this plane's calibration, just like in a replay
+            ApexVDCPlane plane(planes[p].c_str(), planes[p].c_str());
+            if (plane.Init(date) != THaAnalysisObject::kOK) {
+                fprintf(stderr, "could not initialize plane '%s' from the DB\n", planes[p].c_str());
+                return 1;
+            }
+
+            ApexVDCPlaneCalib calib = plane.GetCalib();
+            if (hits_min >= 0) calib.group_hits_min = hits_min;
+            if (span_min >= 0) calib.group_span_min = span_min;
+            if (span_max >= 0) calib.group_span_max = span_max;
+            if (max_gap  >= 0) calib.group_max_gap  = max_gap;
+
+            const auto start = chrono::steady_clock::now();
+
+            const long long nentries = replay.Run((planes[p] + ".").c_str(), calib, results[p]);
+
+            const double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+            printf("%s: %lld entries, %llu groups in %.1f s (%u threads)%s\n",
+                   planes[p].c_str(), nentries, (unsigned long long)results[p].group_pos.size(), seconds,
+                   ROOT::GetThreadPoolSize(), plane.IsCalibFromCache() ? ", calibration from cache" : "");
+
+            if (ApexVDCPlaneStats::IsEnabled()) printf("%s\n", results[p].stats.Summary().c_str());
+        }
+
+        //write all planes to one tree, in entry order
+        unique_ptr<TFile> out(TFile::Open(out_path.c_str(), "RECREATE"));
+        if (!out || out->IsZombie()) {
+            fprintf(stderr, "can't open '%s' for writing\n", out_path.c_str());
+            return 1;
+        }
+
+        TTree* tree = new TTree("T", "ApexOfflineTreeReplay output");
+
+        vector<PlaneOutput> outputs(planes.size());
+        for (size_t p=0; p<planes.size(); p++) outputs[p].Branch(tree, planes[p]);
+
+        const long long nentries = results.front().GetNEntries();
+
+        for (long long entry=0; entry<nentries; entry++) {
+            for (size_t p=0; p<planes.size(); p++) outputs[p].Set(results[p], entry);
+            tree->Fill();
+        }
+
+        out->Write();
+        printf("%lld entries written to '%s'\n", nentries, out_path.c_str());
+
+    } catch (const exception& e) {
+        fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+
+    return 0;
+}
+//______________________________________________________________________________________________________